@@ -5,7 +5,7 @@
 #
 #-------------------------------------------------
 
-QT += core gui qml quick quickwidgets positioning texttospeech xml
+QT += core gui qml quick quickwidgets positioning texttospeech xml concurrent
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 INCLUDEPATH += $$PWD/../DroneManager
 INCLUDEPATH += $$PWD/../SpyCLib
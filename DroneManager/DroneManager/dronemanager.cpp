@@ -1,113 +1,283 @@
 // Qt
 #include <QTime>
 #include <QDebug>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
 
 // Application
 #include "dronemanager.h"
 #include "droneemulator.h"
 #include "waypoint.h"
-#include <defs.h>
+#include <messageschema.h>
 #include <cxmlnode.h>
 #include "serializehelper.h"
 #include <tcpserver.h>
+#include <simulationscheduler.h>
+#include <fleetstate.h>
+#include <fleetkinematics.h>
+#include <workerpool.h>
+#include <geofenceengine.h>
+#include <proximitymonitor.h>
+#include <routeplanner.h>
+#include <statustracker.h>
+#include <terraincache.h>
+#include <scenario.h>
+#define ASYNC_VALIDATION_POINTS 500 // Plans from this size on are validated on a worker thread
+#define OVERRUN_LOG_PERIOD_MS 10000 // Overruns are logged as one summary per period at most
 using namespace Model;
 
 //-------------------------------------------------------------------------------------------------
 
-DroneManager::DroneManager(QObject *pParent) : QObject(pParent)
+DroneManager::DroneManager(const RunOptions &options, QObject *pParent) : QObject(pParent),
+    m_options(options)
 {
-    // Build server
-    m_pServer = new Core::TCPServer(this);
-    connect(m_pServer, &Core::TCPServer::newConnectionFromGroundStation, this, &DroneManager::onNewConnectionFromGroundStation, Qt::DirectConnection);
-    connect(m_pServer, &Core::TCPServer::dataReady, this, &DroneManager::onIncomingMessage, Qt::DirectConnection);
+    // Build server (headless runs talk to nobody)
+    if (!m_options.bHeadless)
+    {
+        m_pServer = new Core::TCPServer(this);
+        connect(m_pServer, &Core::TCPServer::newConnectionFromGroundStation, this, &DroneManager::onNewConnectionFromGroundStation, Qt::DirectConnection);
+        connect(m_pServer, &Core::TCPServer::dataReady, this, &DroneManager::onIncomingMessage, Qt::DirectConnection);
+    }
     connect(this, &DroneManager::uploadPlans, this, &DroneManager::onUploadPlans, Qt::QueuedConnection);
 
-    // Video url
-    QStringList lVideos;
-    lVideos << "D:/projects/SpyC/SpyCProject/SpyC/video/video1.mp4" <<
-        "D:/projects/SpyC/SpyCProject/SpyC/video/video2.mp4" <<
-        "D:/projects/SpyC/SpyCProject/SpyC/video/video3.mp4";
+    // Outgoing messages posted during one event loop iteration are sent together
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(0);
+    connect(&m_flushTimer, &QTimer::timeout, this, &DroneManager::onFlushMessages, Qt::DirectConnection);
+
+    // Simulation scheduler (one clock for every drone)
+    m_pScheduler = new Core::SimulationScheduler(50, this);
+    m_pScheduler->setSpeedFactor(m_options.dSpeedFactor);
+    connect(m_pScheduler, &Core::SimulationScheduler::tickOverrun, this, &DroneManager::onTickOverrun, Qt::DirectConnection);
+
+    // Fleet state (every drone's dynamic state, stored by slot)
+    m_pFleetState = new Core::FleetState;
+
+    // Fleet kinematics (every flying drone advanced in one batch, partitioned over worker threads)
+    m_pWorkerPool = m_options.iThreadCount < 0 ? new Core::WorkerPool : new Core::WorkerPool(m_options.iThreadCount);
+    m_pKinematics = new Core::FleetKinematics(m_pScheduler, m_pFleetState, m_pWorkerPool);
+    m_context.pScheduler = m_pScheduler;
+    m_context.pFleetState = m_pFleetState;
+    m_context.pKinematics = m_pKinematics;
+    m_context.pWorkerPool = m_pWorkerPool;
+
+    // Geofence engine (checked after kinematics on the same tick)
+    m_pGeofence = new Core::GeofenceEngine(m_pScheduler, m_pFleetState, 100, this);
+    connect(m_pGeofence, &Core::GeofenceEngine::zoneEvent, this, &DroneManager::onZoneEvent, Qt::DirectConnection);
+    m_context.pGeofence = m_pGeofence;
+
+    // Proximity monitor
+    m_pProximity = new Core::ProximityMonitor(m_pScheduler, m_pFleetState, m_options.dSeparation, 100, this);
+    connect(m_pProximity, &Core::ProximityMonitor::proximityChanged, this, &DroneManager::onProximityChanged, Qt::DirectConnection);
+
+    // Terrain elevation (terrain following and clearance checks)
+    if (!m_options.sTerrainDirectory.isEmpty())
+    {
+        m_pTerrain = new Core::TerrainCache(m_options.sTerrainDirectory);
+        m_context.pTerrain = m_pTerrain;
+        m_context.dTerrainClearance = m_options.dTerrainClearance;
+    }
 
-    // Initial position
-    QVector<double> vLatitudes = QVector<double>() << 48.856614 << 40.7127753 << 9.641185499999999;
-    QVector<double> vLongitudes = QVector<double>() << 2.3522219000000177 << -74.0059728 << -13.57840120000003;
+    // Route planner
+    m_pRoutePlanner = new Core::RoutePlanner;
 
-    // Create enw drone
-    for (int i=0; i<3; i++)
+    // Drone status (sent when it changes, heartbeat for parked drones)
+    m_pStatusTracker = new Core::StatusTracker(m_pScheduler, m_pFleetState, 250, m_options.iHeartbeatMs, this);
+    m_pStatusTracker->setErrorBound(m_options.dErrorBound);
+    connect(m_pStatusTracker, &Core::StatusTracker::statusChanged, this, &DroneManager::onStatusChanged, Qt::DirectConnection);
+
+    // Drones
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+    Core::Scenario scenario;
+    if (m_options.sScenarioFile.isEmpty())
+        scenario = defaultScenario();
+    else
+    if (!scenario.load(m_options.sScenarioFile, m_pWorkerPool))
+        qWarning() << "DroneManager::DroneManager can't load scenario" << m_options.sScenarioFile;
+    spawn(scenario);
+    m_iStartupMs = startupTimer.elapsed();
+    qDebug() << "DroneManager::DroneManager spawned" << m_vDrones.size() << "drones in" << m_iStartupMs << "ms";
+
+    // Mission
+    if (!m_options.sMissionFile.isEmpty() && !loadMission(m_options.sMissionFile))
+        qWarning() << "DroneManager::DroneManager can't load mission" << m_options.sMissionFile;
+
+    // Headless run ends after the requested simulated time
+    if (m_options.bHeadless)
     {
-        // Set initial position
-        double dLatitude = vLatitudes[i];
-        double dLongitude = vLongitudes[i];
-        QGeoCoordinate initialPos(dLatitude, dLongitude);
-
-        // Build drone emulators
-        QString sDroneUID = QString("DRONE %1").arg(i);
-        Core::DroneEmulator *pDroneEmulator = new Core::DroneEmulator(sDroneUID, lVideos[i], initialPos, this);
-        connect(pDroneEmulator, &Core::DroneEmulator::timeOut, this, &DroneManager::onDroneTimeOut, Qt::QueuedConnection);
-        connect(pDroneEmulator, &Core::DroneEmulator::droneError, this, &DroneManager::onDroneError, Qt::QueuedConnection);
-        m_vDrones << pDroneEmulator;
+        if (m_options.iDurationMs > 0)
+            m_pScheduler->addTask(m_options.iDurationMs, [this]() { onSimulationEnd(); });
+        else
+            qWarning() << "DroneManager::DroneManager headless run without duration";
     }
+
+    m_pScheduler->start();
 }
 
 //-------------------------------------------------------------------------------------------------
 
 DroneManager::~DroneManager()
 {
-
+    // Drones unregister from the scheduler: delete them first
+    qDeleteAll(m_vDrones);
+    m_vDrones.clear();
+    m_hDrones.clear();
+    m_vSlotDrones.clear();
+    delete m_pStatusTracker;
+    delete m_pRoutePlanner;
+    delete m_pProximity;
+    delete m_pGeofence;
+    delete m_pKinematics;
+    delete m_pWorkerPool;
+    delete m_pFleetState;
+    delete m_pTerrain;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DroneManager::sendMessage(const QString &sMessage)
+void DroneManager::sendMessage(const Core::CXMLNode &messageNode)
 {
     if (m_pServer != nullptr)
-        m_pServer->sendMessage(sMessage);
+        m_pServer->sendMessage(messageNode);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::postMessage(const Core::CXMLNode &messageNode)
+{
+    if (m_pServer == nullptr)
+        return;
+    m_vPendingMessages << messageNode;
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
 }
 
 //-------------------------------------------------------------------------------------------------
 
 Core::DroneEmulator *DroneManager::getDrone(const QString &sDroneUID) const
 {
-    foreach (Core::DroneEmulator *pDroneEmulator, m_vDrones)
-        if (pDroneEmulator->uid() == sDroneUID)
-            return pDroneEmulator;
-    return nullptr;
+    return m_hDrones.value(sDroneUID, nullptr);
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DroneManager::onDroneTimeOut()
+Core::DroneEmulator *DroneManager::getDrone(int iHandle) const
 {
-    Core::DroneEmulator *pSender = dynamic_cast<Core::DroneEmulator *>(sender());
-    if (pSender != nullptr)
+    int iSlot = m_pFleetState->slot(iHandle);
+    if ((iSlot < 0) || (iSlot >= m_vSlotDrones.size()))
+        return nullptr;
+    return m_vSlotDrones[iSlot];
+}
+
+//-------------------------------------------------------------------------------------------------
+
+Core::DroneEmulator *DroneManager::targetDrone(const Core::CXMLNode &msgNode, QString &sDroneUID) const
+{
+    int iHandle = Core::SerializeHelper::droneHandle(msgNode);
+    Core::DroneEmulator *pDroneEmulator = iHandle >= 0 ? getDrone(iHandle) : getDrone(sDroneUID);
+    if (pDroneEmulator != nullptr)
+        sDroneUID = pDroneEmulator->uid();
+    return pDroneEmulator;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+Core::Scenario DroneManager::defaultScenario()
+{
+    QStringList lVideos;
+    lVideos << "D:/projects/SpyC/SpyCProject/SpyC/video/video1.mp4" <<
+        "D:/projects/SpyC/SpyCProject/SpyC/video/video2.mp4" <<
+        "D:/projects/SpyC/SpyCProject/SpyC/video/video3.mp4";
+    QVector<double> vLatitudes = QVector<double>() << 48.856614 << 40.7127753 << 9.641185499999999;
+    QVector<double> vLongitudes = QVector<double>() << 2.3522219000000177 << -74.0059728 << -13.57840120000003;
+
+    Core::Scenario scenario;
+    for (int i=0; i<3; i++)
     {
-        QString sCurrentDroneStatus = pSender->currentStatus();
-        sendMessage(sCurrentDroneStatus);
+        Core::Scenario::Drone drone;
+        drone.sDroneUID = QString("DRONE %1").arg(i);
+        drone.sVideoUrl = lVideos[i];
+        drone.position = QGeoCoordinate(vLatitudes[i], vLongitudes[i]);
+        scenario.append(drone);
+    }
+    return scenario;
+}
 
-        if (m_bUploadPlans)
-        {
-            // At first connect send safety/mission/landing plans to client
-            foreach (Core::DroneEmulator *pDrone, m_vDrones)
-            {
-                if (pDrone != nullptr)
-                {
-                    sendMessage(Core::SerializeHelper::serializeSafetyPlan(pDrone->safetyPlan(), pDrone->uid()).toJsonString());
-                    sendMessage(Core::SerializeHelper::serializeMissionPlan(pDrone->missionPlan(), pDrone->uid()).toJsonString());
-                    sendMessage(Core::SerializeHelper::serializeLandingPlan(pDrone->landingPlan(), pDrone->uid()).toJsonString());
-                }
-            }
-            m_bUploadPlans = false;
-        }
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::spawn(const Core::Scenario &scenario)
+{
+    // Emulators register with the scheduler and fleet state: built here, plans and flight paths were prepared by the loader
+    const QVector<Core::Scenario::Drone> &vDrones = scenario.drones();
+    m_pFleetState->reserve(m_vDrones.size()+vDrones.size());
+    m_vDrones.reserve(m_vDrones.size()+vDrones.size());
+    m_hDrones.reserve(m_hDrones.size()+vDrones.size());
+    foreach (const Core::Scenario::Drone &drone, vDrones)
+    {
+        Core::DroneEmulator *pDroneEmulator = new Core::DroneEmulator(drone.sDroneUID, drone.sVideoUrl, drone.position, m_context, this);
+        connect(pDroneEmulator, &Core::DroneEmulator::droneError, this, &DroneManager::onDroneError, Qt::QueuedConnection);
+        m_vDrones << pDroneEmulator;
+        m_hDrones.insert(drone.sDroneUID, pDroneEmulator);
+        if (pDroneEmulator->slot() >= m_vSlotDrones.size())
+            m_vSlotDrones.resize(pDroneEmulator->slot()+1);
+        m_vSlotDrones[pDroneEmulator->slot()] = pDroneEmulator;
+        if (!drone.safetyPlan.isEmpty())
+            pDroneEmulator->setSafetyPlan(drone.safetyPlan);
+        if (!drone.lExclusionArea.isEmpty())
+            pDroneEmulator->setExclusionArea(drone.lExclusionArea);
+        if (!drone.vMissionPlan.isEmpty())
+            pDroneEmulator->setMissionPlan(drone.vMissionPlan);
+        if (!drone.vLandingPlan.isEmpty())
+            pDroneEmulator->setLandingPlan(drone.vLandingPlan);
+        if (drone.bTakeOff)
+            takeOff(pDroneEmulator);
     }
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DroneManager::onTakeOffRequest(const QString &sDroneUID)
+void DroneManager::takeOff(Core::DroneEmulator *pDrone)
 {
-    Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
-    if (pTargetDrone != nullptr)
-        pTargetDrone->takeOff();
+    pDrone->takeOff();
+
+    // Push planned trajectory once: the drone is then reported only when off schedule
+    if (m_options.bTrajectory && (m_pFleetState->flightStatus(pDrone->slot()) == SpyCore::FLYING))
+    {
+        sendMessage(Core::SerializeHelper::serializeTrajectory(pDrone->missionPlan(), pDrone->uid(), m_pScheduler->simulationTime(), m_pFleetState->pathProgress(pDrone->slot())));
+        m_pStatusTracker->setTrajectory(pDrone->slot(), pDrone->flightPath());
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::onStatusChanged(int iSlot)
+{
+    Core::CXMLNode statusNode = Core::SerializeHelper::serializeDroneStatus(*m_pFleetState, iSlot, m_pScheduler->simulationTime());
+    if (m_pStatusTracker->hasTrajectory(iSlot))
+        Core::SerializeHelper::appendProgress(statusNode, m_pFleetState->pathProgress(iSlot));
+    postMessage(statusNode);
+
+    if (m_bUploadPlans)
+    {
+        // At first connect send safety/mission/landing plans to client, and trajectories of drones already following one
+        foreach (Core::DroneEmulator *pDrone, m_vDrones)
+        {
+            if (pDrone != nullptr)
+            {
+                sendMessage(Core::SerializeHelper::serializeSafetyPlan(pDrone->safetyPlan(), pDrone->uid()));
+                sendMessage(Core::SerializeHelper::serializeMissionPlan(pDrone->missionPlan(), pDrone->uid()));
+                sendMessage(Core::SerializeHelper::serializeLandingPlan(pDrone->landingPlan(), pDrone->uid()));
+                sendMessage(Core::SerializeHelper::serializeExclusionArea(pDrone->exclusionArea(), pDrone->uid()));
+                if (m_pStatusTracker->hasTrajectory(pDrone->slot()))
+                    sendMessage(Core::SerializeHelper::serializeTrajectory(pDrone->missionPlan(), pDrone->uid(), m_pScheduler->simulationTime(), m_pFleetState->pathProgress(pDrone->slot())));
+            }
+        }
+        m_bUploadPlans = false;
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -125,7 +295,10 @@ void DroneManager::onMissionPlanChanged(const QString &sDroneUID)
 {
     Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
     if (pTargetDrone != nullptr)
-        sendMessage(pTargetDrone->currentStatus());
+    {
+        sendMessage(Core::SerializeHelper::serializeDroneStatus(*pTargetDrone, m_pScheduler->simulationTime()));
+        m_pStatusTracker->markReported(pTargetDrone->slot());
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -134,7 +307,10 @@ void DroneManager::onSafetyPlanChanged(const QString &sDroneUID)
 {
     Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
     if (pTargetDrone != nullptr)
-        sendMessage(pTargetDrone->currentStatus());
+    {
+        sendMessage(Core::SerializeHelper::serializeDroneStatus(*pTargetDrone, m_pScheduler->simulationTime()));
+        m_pStatusTracker->markReported(pTargetDrone->slot());
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -143,21 +319,38 @@ void DroneManager::onLandingPlanChanged(const QString &sDroneUID)
 {
     Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
     if (pTargetDrone != nullptr)
-        sendMessage(pTargetDrone->currentStatus());
+    {
+        sendMessage(Core::SerializeHelper::serializeDroneStatus(*pTargetDrone, m_pScheduler->simulationTime()));
+        m_pStatusTracker->markReported(pTargetDrone->slot());
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::onZoneEvent(int iSlot, int iZone, SpyCore::ZoneType eZoneType, SpyCore::GeofenceEvent eEvent)
+{
+    postMessage(Core::SerializeHelper::serializeGeofenceEvent(m_pFleetState->uid(iSlot), iZone, eZoneType, eEvent));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::onProximityChanged(int iSlot, int iOtherSlot, double dDistance, bool bConflict)
+{
+    postMessage(Core::SerializeHelper::serializeProximityAlert(m_pFleetState->uid(iSlot), m_pFleetState->uid(iOtherSlot), dDistance, bConflict));
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DroneManager::onDroneError(const SpyCore::DroneError &eDroneError, const QString &sDroneUID)
 {
-    sendMessage(Core::SerializeHelper::serializeDroneError(eDroneError, sDroneUID).toString());
+    sendMessage(Core::SerializeHelper::serializeDroneError(eDroneError, sDroneUID));
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DroneManager::onFailSafeDone(const QString &sDroneUID)
 {
-    sendMessage(Core::SerializeHelper::serializeFailSafeDone(sDroneUID).toString());
+    sendMessage(Core::SerializeHelper::serializeFailSafeDone(sDroneUID));
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -169,97 +362,182 @@ void DroneManager::onNewConnectionFromGroundStation()
 
 //-------------------------------------------------------------------------------------------------
 
-void DroneManager::onIncomingMessage(const QString &sIcominMessage)
-{    
-    qDebug() << "DroneManager::onIncomingMessage " << sIcominMessage;
+void DroneManager::onIncomingMessage(const QByteArray &baIncomingMessage)
+{
+    // Parse (XML, JSON or CBOR)
+    Core::CXMLNode msgNode = Core::CXMLNode::parse(baIncomingMessage);
 
     // Retrieve message type
-    QString sMessageType = Core::SerializeHelper::messageType(sIcominMessage);
+    QString sMessageType = Core::SerializeHelper::messageType(msgNode);
+    qDebug() << "DroneManager::onIncomingMessage " << sMessageType;
+
+    QSharedPointer<Reply> pReply(new Reply);
+
+    // Batch: process every message as one unit, then acknowledge once
+    if (sMessageType == Core::Schema::Batch::name())
+    {
+        // Sender understands batches: coalesce its outgoing messages from now on
+        if (m_pServer != nullptr)
+            m_pServer->acceptBatches();
+
+        pReply->bBatch = true;
+        foreach (Core::CXMLNode singleMsgNode, Core::SerializeHelper::deserializeBatch(msgNode))
+            processMessage(singleMsgNode, pReply);
+    }
+    else
+        processMessage(msgNode, pReply);
+    pReply->bComplete = true;
+    sendReply(pReply);
+}
 
-    // Parse
-    Core::CXMLNode msgNode = Core::CXMLNode::parseJSON(sIcominMessage);
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::processMessage(const Core::CXMLNode &msgNode, const QSharedPointer<Reply> &pReply)
+{
+    // Retrieve message type
+    QString sMessageType = Core::SerializeHelper::messageType(msgNode);
 
     // Safety plan
-    if (sMessageType == TAG_SAFETY_PLAN)
+    if (sMessageType == Core::Schema::SafetyPlan::name())
     {
         QString sDroneUID;
         QGeoPath geoPath;
-        Core::SerializeHelper::deserializeSafetyPlan(sIcominMessage, geoPath, sDroneUID);
+        Core::SerializeHelper::deserializeSafetyPlan(msgNode, geoPath, sDroneUID);
 
         // Retrieve target drone
-        Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
+        Core::DroneEmulator *pTargetDrone = targetDrone(msgNode, sDroneUID);
         if (pTargetDrone != nullptr)
         {
             // Set safety plan
             pTargetDrone->setSafetyPlan(geoPath);
 
-            // Notify back client
-            sendMessage(Core::SerializeHelper::serializeSafetyPlan(geoPath, sDroneUID).toJsonString());
+            // Notify back client (with validation issues)
+            validatePlan(Core::SerializeHelper::serializeSafetyPlan(geoPath, sDroneUID), geoPath.size(),
+                         [geoPath]() { return Core::PlanValidator::validateSafetyPlan(geoPath); }, pReply);
         }
     }
     else
     // Mission plan
-    if (sMessageType == TAG_MISSION_PLAN)
+    if (sMessageType == Core::Schema::MissionPlan::name())
     {
         QString sDroneUID;
         WayPointList vWayPointList;
-        Core::SerializeHelper::deserializeMissionPlan(sIcominMessage, vWayPointList, sDroneUID);
+        Core::SerializeHelper::deserializeMissionPlan(msgNode, vWayPointList, sDroneUID);
 
         // Retrieve target drone
-        Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
+        Core::DroneEmulator *pTargetDrone = targetDrone(msgNode, sDroneUID);
         if (pTargetDrone != nullptr)
         {
             // Set mission plan
             pTargetDrone->setMissionPlan(vWayPointList);
 
-            // Notify back client
-            sendMessage(Core::SerializeHelper::serializeMissionPlan(vWayPointList, sDroneUID).toJsonString());
+            // Notify back client (with validation issues)
+            QGeoPath safetyPlan = pTargetDrone->safetyPlan();
+            QList<QGeoShape> lExclusionArea = pTargetDrone->exclusionArea();
+            Core::TerrainCache *pTerrain = m_pTerrain;
+            double dClearance = m_options.dTerrainClearance;
+            validatePlan(Core::SerializeHelper::serializeMissionPlan(vWayPointList, sDroneUID), vWayPointList.size(),
+                         [vWayPointList, safetyPlan, lExclusionArea, pTerrain, dClearance]() { return Core::PlanValidator::validateMissionPlan(vWayPointList, safetyPlan, lExclusionArea, pTerrain, dClearance); }, pReply);
         }
     }
     else
     // Landing plan
-    if (sMessageType == TAG_LANDING_PLAN)
+    if (sMessageType == Core::Schema::LandingPlan::name())
     {
         QString sDroneUID;
         WayPointList vWayPointList;
-        Core::SerializeHelper::deserializeLandingPlan(sIcominMessage, vWayPointList, sDroneUID);
+        Core::SerializeHelper::deserializeLandingPlan(msgNode, vWayPointList, sDroneUID);
 
         // Retrieve target drone
-        Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
+        Core::DroneEmulator *pTargetDrone = targetDrone(msgNode, sDroneUID);
         if (pTargetDrone != nullptr)
         {
             // Set landing plan
             pTargetDrone->setLandingPlan(vWayPointList);
 
+            // Notify back client (with validation issues)
+            QGeoPath safetyPlan = pTargetDrone->safetyPlan();
+            QList<QGeoShape> lExclusionArea = pTargetDrone->exclusionArea();
+            Core::TerrainCache *pTerrain = m_pTerrain;
+            double dClearance = m_options.dTerrainClearance;
+            validatePlan(Core::SerializeHelper::serializeLandingPlan(vWayPointList, sDroneUID), vWayPointList.size(),
+                         [vWayPointList, safetyPlan, lExclusionArea, pTerrain, dClearance]() { return Core::PlanValidator::validateLandingPlan(vWayPointList, safetyPlan, lExclusionArea, pTerrain, dClearance); }, pReply);
+        }
+    }
+    else
+    // Exclusion area
+    if (sMessageType == Core::Schema::ExclusionArea::name())
+    {
+        QString sDroneUID;
+        QList<QGeoShape> lExclusionArea;
+        Core::SerializeHelper::deserializeExclusionArea(msgNode, lExclusionArea, sDroneUID);
+
+        // Retrieve target drone
+        Core::DroneEmulator *pTargetDrone = targetDrone(msgNode, sDroneUID);
+        if (pTargetDrone != nullptr)
+        {
+            // Set exclusion area
+            pTargetDrone->setExclusionArea(lExclusionArea);
+
             // Notify back client
-            sendMessage(Core::SerializeHelper::serializeLandingPlan(vWayPointList, sDroneUID).toJsonString());
+            pReply->vNodes << Core::SerializeHelper::serializeExclusionArea(lExclusionArea, sDroneUID);
+        }
+    }
+    else
+    // Route request: detour around the drone exclusion areas (mission plans are flown in a loop)
+    if (sMessageType == Core::Schema::Route::name())
+    {
+        QString sDroneUID;
+        WayPointList vWayPointList;
+        Core::SerializeHelper::deserializeRoute(msgNode, vWayPointList, sDroneUID);
+
+        // Retrieve target drone
+        Core::DroneEmulator *pTargetDrone = targetDrone(msgNode, sDroneUID);
+        if (pTargetDrone != nullptr)
+        {
+            WayPointList vRoute;
+            QVector<int> vUnroutedLegs;
+            m_pRoutePlanner->route(vWayPointList, pTargetDrone->exclusionArea(), vWayPointList.size() > 2, vRoute, vUnroutedLegs);
+
+            // Answer with the route, legs without a way around are reported
+            QVector<Core::PlanValidator::Issue> vIssues;
+            foreach (int iLeg, vUnroutedLegs)
+            {
+                Core::PlanValidator::Issue issue;
+                issue.eError = SpyCore::MISSION_PLAN_IN_EXCLUSION_AREA;
+                issue.iIndex = iLeg;
+                vIssues << issue;
+            }
+            Core::CXMLNode routeNode = Core::SerializeHelper::serializeRoute(vRoute, sDroneUID);
+            Core::SerializeHelper::appendPlanErrors(routeNode, vIssues);
+            pReply->vNodes << routeNode;
         }
     }
     else
     // Take off
-    if (sMessageType == TAG_TAKE_OFF)
+    if (sMessageType == Core::Schema::TakeOff::name())
     {
         // Retrieve take off node
-        Core::CXMLNode takeOffNode = msgNode.getNodeByTagName(TAG_TAKE_OFF);
+        Core::CXMLNode takeOffNode = Core::Schema::TakeOff::find(msgNode);
 
         // Deserialize
         QString sDroneUID;
         Core::SerializeHelper::deserializeTakeOffRequest(takeOffNode, sDroneUID);
-        Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
+        Core::DroneEmulator *pTargetDrone = targetDrone(msgNode, sDroneUID);
         if (pTargetDrone != nullptr)
-            pTargetDrone->takeOff();
+            takeOff(pTargetDrone);
     }
     else
     // Fail safe
-    if (sMessageType == TAG_FAIL_SAFE)
+    if (sMessageType == Core::Schema::FailSafe::name())
     {
         // Retrieve fail safe node
-        Core::CXMLNode failSafeNode = msgNode.getNodeByTagName(TAG_FAIL_SAFE);
+        Core::CXMLNode failSafeNode = Core::Schema::FailSafe::find(msgNode);
 
         // Deserialize
         QString sDroneUID;
         Core::SerializeHelper::deserializeTakeOffRequest(failSafeNode, sDroneUID);
-        Core::DroneEmulator *pTargetDrone = getDrone(sDroneUID);
+        Core::DroneEmulator *pTargetDrone = targetDrone(msgNode, sDroneUID);
         if (pTargetDrone != nullptr)
             pTargetDrone->failSafe();
     }
@@ -267,7 +545,175 @@ void DroneManager::onIncomingMessage(const QString &sIcominMessage)
 
 //-------------------------------------------------------------------------------------------------
 
+void DroneManager::onFlushMessages()
+{
+    // Batches go to the ground stations which sent one, the others get messages one by one
+    if ((m_pServer != nullptr) && !m_vPendingMessages.isEmpty())
+        m_pServer->sendMessages(m_vPendingMessages);
+    m_vPendingMessages.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::onTickOverrun(qint64 iTick, qint64 iLateMs)
+{
+    // Summarize instead of logging each overrun: an overloaded run overruns on every tick
+    m_iWorstLateMs = qMax(m_iWorstLateMs, iLateMs);
+    if (m_overrunLogTimer.isValid() && (m_overrunLogTimer.elapsed() < OVERRUN_LOG_PERIOD_MS))
+        return;
+    qint64 iOverrunCount = m_pScheduler->overrunCount();
+    qDebug() << "DroneManager::onTickOverrun " << iOverrunCount-m_iLoggedOverruns << "overruns up to tick" << iTick
+             << "worst" << m_iWorstLateMs << "ms late," << iOverrunCount << "in total";
+    m_overrunLogTimer.start();
+    m_iLoggedOverruns = iOverrunCount;
+    m_iWorstLateMs = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::validatePlan(const Core::CXMLNode &echoNode, int iPointCount, const std::function<QVector<Core::PlanValidator::Issue>()> &validation, const QSharedPointer<Reply> &pReply)
+{
+    // Small plan: validate right away
+    if (iPointCount < ASYNC_VALIDATION_POINTS)
+    {
+        Core::CXMLNode replyNode = echoNode;
+        Core::SerializeHelper::appendPlanErrors(replyNode, validation());
+        pReply->vNodes << replyNode;
+        return;
+    }
+
+    // Large plan: keep the event loop running, the echo holds its place in the reply until validated
+    int iIndex = pReply->vNodes.size();
+    pReply->vNodes << echoNode;
+    pReply->iPending++;
+    QFutureWatcher<QVector<Core::PlanValidator::Issue>> *pWatcher = new QFutureWatcher<QVector<Core::PlanValidator::Issue>>(this);
+    connect(pWatcher, &QFutureWatcher<QVector<Core::PlanValidator::Issue>>::finished, this, [this, pWatcher, pReply, iIndex]() {
+        Core::SerializeHelper::appendPlanErrors(pReply->vNodes[iIndex], pWatcher->result());
+        pReply->iPending--;
+        sendReply(pReply);
+        pWatcher->deleteLater();
+    });
+    pWatcher->setFuture(QtConcurrent::run(validation));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::sendReply(const QSharedPointer<Reply> &pReply)
+{
+    if (!pReply->bComplete || (pReply->iPending > 0) || !pReply->bSend || (m_pServer == nullptr))
+        return;
+
+    // Batch: one acknowledgement (ground stations which do not read batches get its messages one by one)
+    if (pReply->bBatch)
+    {
+        if (!pReply->vNodes.isEmpty())
+            m_pServer->sendMessages(pReply->vNodes);
+    }
+    else
+    {
+        foreach (Core::CXMLNode replyNode, pReply->vNodes)
+            sendMessage(replyNode);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
 void DroneManager::onUploadPlans()
 {
     m_bUploadPlans = true;
+
+    // The new ground station needs every drone, parked ones included
+    m_pStatusTracker->invalidate();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DroneManager::loadMission(const QString &sFileName)
+{
+    Core::CXMLNode msgNode = Core::CXMLNode::load(sFileName);
+    if (msgNode.nodes().isEmpty())
+        return false;
+
+    // Replies are only meaningful to a ground station
+    QSharedPointer<Reply> pReply(new Reply);
+    pReply->bSend = false;
+    if (Core::SerializeHelper::messageType(msgNode) == Core::Schema::Batch::name())
+    {
+        foreach (Core::CXMLNode singleMsgNode, Core::SerializeHelper::deserializeBatch(msgNode))
+            processMessage(singleMsgNode, pReply);
+    }
+    else
+        processMessage(msgNode, pReply);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+Core::CXMLNode DroneManager::summary() const
+{
+    // Fleet statistics
+    int iFlyingCount = 0;
+    int iMinBattery = 100;
+    double dBatterySum = 0;
+    int iDroneCount = m_pFleetState->activeCount();
+    const uchar *pActive = m_pFleetState->activeFlags();
+    for (int iSlot=0; iSlot<m_pFleetState->slotCount(); iSlot++)
+    {
+        if (!pActive[iSlot])
+            continue;
+        if (m_pFleetState->flightStatus(iSlot) == SpyCore::FLYING)
+            iFlyingCount++;
+        iMinBattery = qMin(iMinBattery, m_pFleetState->batteryLevel(iSlot));
+        dBatterySum += m_pFleetState->batteryLevel(iSlot);
+    }
+
+    // Run statistics
+    qint64 iSimulationTime = m_pScheduler->simulationTime();
+    qint64 iWallTime = m_pScheduler->wallTime();
+    Core::CXMLNode rootNode;
+    Core::CXMLNode summaryNode = Core::Schema::Summary::create();
+    Core::Schema::Summary::SimulationTime::write(summaryNode, iSimulationTime);
+    Core::Schema::Summary::WallTime::write(summaryNode, iWallTime);
+    Core::Schema::Summary::SpeedUp::write(summaryNode, (double)iSimulationTime/qMax((qint64)1, iWallTime));
+    Core::Schema::Summary::Ticks::write(summaryNode, m_pScheduler->tick());
+    Core::Schema::Summary::Overruns::write(summaryNode, m_pScheduler->overrunCount());
+    Core::Schema::Summary::Drones::write(summaryNode, iDroneCount);
+    Core::Schema::Summary::Flying::write(summaryNode, iFlyingCount);
+    Core::Schema::Summary::MinBattery::write(summaryNode, iDroneCount > 0 ? iMinBattery : 0);
+    Core::Schema::Summary::MeanBattery::write(summaryNode, iDroneCount > 0 ? dBatterySum/iDroneCount : 0);
+    Core::Schema::Summary::GeofenceEvents::write(summaryNode, m_pGeofence->eventCount());
+
+    // Proximity detection cost
+    const Core::ProximityMonitor::Counters &proximityCounters = m_pProximity->counters();
+    Core::Schema::Summary::ProximityAlerts::write(summaryNode, proximityCounters.iAlerts);
+    Core::Schema::Summary::ProximityConflicts::write(summaryNode, proximityCounters.iConflicts);
+    Core::Schema::Summary::ProximityMeanUs::write(summaryNode, proximityCounters.iTotalNs/1000./qMax((qint64)1, proximityCounters.iChecks));
+    Core::Schema::Summary::ProximityMaxUs::write(summaryNode, proximityCounters.iMaxNs/1000.);
+
+    // Status traffic
+    Core::Schema::Summary::StatusChanges::write(summaryNode, m_pStatusTracker->counters().iChanges);
+    Core::Schema::Summary::StatusHeartbeats::write(summaryNode, m_pStatusTracker->counters().iHeartbeats);
+    Core::Schema::Summary::StartupMs::write(summaryNode, m_iStartupMs);
+
+    // Final state of each drone
+    foreach (Core::CXMLNode statusNode, Core::SerializeHelper::serializeFleetStatus(*m_pFleetState))
+        summaryNode.nodes() << statusNode.nodes();
+    rootNode.nodes() << summaryNode;
+    return rootNode;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneManager::onSimulationEnd()
+{
+    m_pScheduler->stop();
+
+    Core::CXMLNode summaryNode = summary();
+    if (m_options.sSummaryFile.isEmpty())
+        QTextStream(stdout) << summaryNode.toJsonString() << "\n";
+    else
+    if (!summaryNode.save(m_options.sSummaryFile))
+        qWarning() << "DroneManager::onSimulationEnd can't write" << m_options.sSummaryFile;
+
+    QCoreApplication::quit();
 }
@@ -6,15 +6,76 @@
 #include <QVector>
 #include <QHash>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+
+// Std
+#include <functional>
 
 // Application
 #include <spycore.h>
+#include <cxmlnode.h>
+#include <simulationcontext.h>
+#include <planvalidator.h>
 namespace Core {
     class DroneEmulator;
     class TCPServer;
+    class SimulationScheduler;
+    class FleetState;
+    class FleetKinematics;
+    class WorkerPool;
+    class GeofenceEngine;
+    class ProximityMonitor;
+    class RoutePlanner;
+    class StatusTracker;
+    class TerrainCache;
+    class Scenario;
 }
 
 namespace Model {
+//! Run options (see main.cpp for the command line)
+struct RunOptions
+{
+    //! Headless: no ground station server, stop after iDurationMs and write a summary
+    bool bHeadless = false;
+
+    //! Scheduler speed factor (1: real time, 0: as fast as possible)
+    double dSpeedFactor = 1;
+
+    //! Simulated duration (ms, headless only)
+    qint64 iDurationMs = 0;
+
+    //! Drones spawned at startup (.json, .xml or .cbor, empty: default fleet)
+    QString sScenarioFile;
+
+    //! Messages (plans, take off...) processed at startup, as if sent by a ground station
+    QString sMissionFile;
+
+    //! Summary file (.json, .xml or .cbor, standard output if empty)
+    QString sSummaryFile;
+
+    //! Worker threads (-1: one per core besides the main thread)
+    int iThreadCount = -1;
+
+    //! Minimum separation between flying drones (m)
+    double dSeparation = 50;
+
+    //! Status period of drones whose status does not change (ms)
+    int iHeartbeatMs = 5000;
+
+    //! Dead reckoning error bound of moving drones (m, 0: status sent on every move)
+    double dErrorBound = 0;
+
+    //! Push planned trajectory at take off, then report flying drones only when off schedule
+    bool bTrajectory = false;
+
+    //! Terrain elevation tiles (SRTM .hgt, empty: flat earth)
+    QString sTerrainDirectory;
+
+    //! Minimum height above ground of flying drones and plans (m, with terrain only)
+    double dTerrainClearance = 30;
+};
+
 class DroneManager : public QObject
 {
     Q_OBJECT
@@ -25,34 +86,140 @@ public:
     //-------------------------------------------------------------------------------------------------
 
     //! Constructor
-    DroneManager(QObject *pParent=nullptr);
+    DroneManager(const RunOptions &options=RunOptions(), QObject *pParent=nullptr);
 
     //! Destructor
     ~DroneManager();
 
     //! Send message
-    void sendMessage(const QString &sMessage);
+    void sendMessage(const Core::CXMLNode &messageNode);
+
+    //! Post message (sent with the other messages posted in the same event loop iteration)
+    void postMessage(const Core::CXMLNode &messageNode);
 
 private:
+    //! Replies to one incoming message (a batch is acknowledged once, after its last plan validation)
+    struct Reply
+    {
+        //! Reply messages, in the order of the messages they answer
+        QVector<Core::CXMLNode> vNodes;
+
+        //! Validations still running on a worker thread
+        int iPending = 0;
+
+        //! Every message processed?
+        bool bComplete = false;
+
+        //! Answer to a batch?
+        bool bBatch = false;
+
+        //! Send it? (messages loaded from a file are answered to nobody)
+        bool bSend = true;
+    };
+
     //! Get drone by UID
     Core::DroneEmulator *getDrone(const QString &sDroneUID) const;
 
+    //! Get drone by handle (see FleetState::handle(), null if stale)
+    Core::DroneEmulator *getDrone(int iHandle) const;
+
+    //! Get drone targeted by a message, by handle if it carries one, by UID otherwise (sDroneUID set to the drone UID)
+    Core::DroneEmulator *targetDrone(const Core::CXMLNode &msgNode, QString &sDroneUID) const;
+
+    //! Return fleet spawned when no scenario file is given
+    static Core::Scenario defaultScenario();
+
+    //! Create drones of a scenario, set their plans and take off those asked to
+    void spawn(const Core::Scenario &scenario);
+
+    //! Take off drone (and push its trajectory if requested)
+    void takeOff(Core::DroneEmulator *pDrone);
+
+    //! Process a single message, replies are appended to pReply
+    void processMessage(const Core::CXMLNode &msgNode, const QSharedPointer<Reply> &pReply);
+
+    //! Validate plan and append issues to its echo (large plans are validated on a worker thread, their echo keeps its place in the reply)
+    void validatePlan(const Core::CXMLNode &echoNode, int iPointCount, const std::function<QVector<Core::PlanValidator::Issue>()> &validation, const QSharedPointer<Reply> &pReply);
+
+    //! Send reply once every message is processed and validated
+    void sendReply(const QSharedPointer<Reply> &pReply);
+
+    //! Process messages of a file (single message or batch)
+    bool loadMission(const QString &sFileName);
+
+    //! Return final state and statistics of the run
+    Core::CXMLNode summary() const;
+
 private:
     //! Drones
     QVector<Core::DroneEmulator *> m_vDrones;
 
+    //! Drones by UID
+    QHash<QString, Core::DroneEmulator *> m_hDrones;
+
+    //! Drones by fleet state slot (null for free slots)
+    QVector<Core::DroneEmulator *> m_vSlotDrones;
+
     //! TCPServer
     Core::TCPServer *m_pServer = nullptr;
 
+    //! Simulation scheduler
+    Core::SimulationScheduler *m_pScheduler = nullptr;
+
+    //! Fleet state
+    Core::FleetState *m_pFleetState = nullptr;
+
+    //! Fleet kinematics
+    Core::FleetKinematics *m_pKinematics = nullptr;
+
+    //! Worker pool
+    Core::WorkerPool *m_pWorkerPool = nullptr;
+
+    //! Geofence engine
+    Core::GeofenceEngine *m_pGeofence = nullptr;
+
+    //! Proximity monitor
+    Core::ProximityMonitor *m_pProximity = nullptr;
+
+    //! Route planner (detours around exclusion areas)
+    Core::RoutePlanner *m_pRoutePlanner = nullptr;
+
+    //! Status tracker
+    Core::StatusTracker *m_pStatusTracker = nullptr;
+
+    //! Terrain elevation (null if no tiles)
+    Core::TerrainCache *m_pTerrain = nullptr;
+
+    //! Simulation context (handed to each drone)
+    Core::SimulationContext m_context;
+
+    //! Run options
+    RunOptions m_options;
+
     //! Upload plans?
     bool m_bUploadPlans = false;
 
-public slots:
-    //! Drone time out
-    void onDroneTimeOut();
+    //! Pending outgoing messages
+    QVector<Core::CXMLNode> m_vPendingMessages;
+
+    //! Flush timer
+    QTimer m_flushTimer;
+
+    //! Wall time spent loading and spawning the scenario (ms)
+    qint64 m_iStartupMs = 0;
+
+    //! Wall time since the last overrun log
+    QElapsedTimer m_overrunLogTimer;
+
+    //! Overrun count at the last overrun log
+    qint64 m_iLoggedOverruns = 0;
 
-    //! Take off drone
-    void onTakeOffRequest(const QString &DroneUID);
+    //! Worst overrun since the last overrun log (ms)
+    qint64 m_iWorstLateMs = 0;
+
+public slots:
+    //! Drone status changed (or heartbeat due)
+    void onStatusChanged(int iSlot);
 
     //! Fail safe
     void onFailSafeRequest(const QString &DroneUID);
@@ -66,6 +233,12 @@ public slots:
     //! Landing plan changed
     void onLandingPlanChanged(const QString &sDroneUID);
 
+    //! Drone entered or left a geofence zone
+    void onZoneEvent(int iSlot, int iZone, SpyCore::ZoneType eZoneType, SpyCore::GeofenceEvent eEvent);
+
+    //! Two drones came too close or moved apart again
+    void onProximityChanged(int iSlot, int iOtherSlot, double dDistance, bool bConflict);
+
     //! Drone error
     void onDroneError(const SpyCore::DroneError &eDroneError, const QString &sDroneUID);
 
@@ -76,11 +249,20 @@ public slots:
     void onNewConnectionFromGroundStation();
 
     //! Process incoming message
-    void onIncomingMessage(const QString &sIcominMessage);
+    void onIncomingMessage(const QByteArray &baIncomingMessage);
 
     //! Upload plans
     void onUploadPlans();
 
+    //! Flush pending outgoing messages
+    void onFlushMessages();
+
+    //! Simulation tick overrun
+    void onTickOverrun(qint64 iTick, qint64 iLateMs);
+
+    //! End of headless run
+    void onSimulationEnd();
+
 signals:
     //! Upload plans
     void uploadPlans();
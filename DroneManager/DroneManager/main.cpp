@@ -1,6 +1,7 @@
 // Qt
 #include <QApplication>
 #include <QSettings>
+#include <QCommandLineParser>
 
 // Application
 #include "dronemanager.h"
@@ -8,6 +9,54 @@
 int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
-    new Model::DroneManager(nullptr);
+
+    // Command line
+    QCommandLineParser parser;
+    parser.setApplicationDescription("SpyC drone manager");
+    parser.addHelpOption();
+    QCommandLineOption headlessOption("headless", "Run without ground station server, stop after --duration and write a summary.");
+    QCommandLineOption durationOption("duration", "Simulated duration in seconds (headless).", "seconds");
+    QCommandLineOption speedOption("speed", "Speed factor: 1 is real time, 0 is as fast as possible.", "factor", "1");
+    QCommandLineOption scenarioOption("scenario", "Drones spawned at startup (.json, .xml or .cbor), three default drones otherwise.", "file");
+    QCommandLineOption missionOption("mission", "Messages (plans, take off...) processed at startup (.json, .xml or .cbor).", "file");
+    QCommandLineOption summaryOption("summary", "Summary file (.json, .xml or .cbor), standard output by default.", "file");
+    QCommandLineOption threadsOption("threads", "Worker threads besides the main thread.", "count", "-1");
+    QCommandLineOption separationOption("separation", "Minimum separation between flying drones in meters.", "meters", "50");
+    QCommandLineOption heartbeatOption("heartbeat", "Status period of drones whose status does not change, in seconds.", "seconds", "5");
+    QCommandLineOption errorBoundOption("error-bound", "Send status of moving drones only when clients extrapolating the last one are further off, in meters (0: every move).", "meters", "0");
+    QCommandLineOption terrainOption("terrain", "Directory of SRTM elevation tiles (.hgt) for terrain following and clearance checks.", "directory");
+    QCommandLineOption clearanceOption("clearance", "Minimum height above ground in meters (with --terrain).", "meters", "30");
+    QCommandLineOption trajectoryOption("trajectory", "Push the planned trajectory at take off, then send status of flying drones only when off schedule.");
+    parser.addOption(headlessOption);
+    parser.addOption(durationOption);
+    parser.addOption(speedOption);
+    parser.addOption(scenarioOption);
+    parser.addOption(missionOption);
+    parser.addOption(summaryOption);
+    parser.addOption(threadsOption);
+    parser.addOption(separationOption);
+    parser.addOption(heartbeatOption);
+    parser.addOption(errorBoundOption);
+    parser.addOption(trajectoryOption);
+    parser.addOption(terrainOption);
+    parser.addOption(clearanceOption);
+    parser.process(a);
+
+    Model::RunOptions options;
+    options.bHeadless = parser.isSet(headlessOption);
+    options.iDurationMs = qRound64(parser.value(durationOption).toDouble()*1000);
+    options.dSpeedFactor = parser.value(speedOption).toDouble();
+    options.sScenarioFile = parser.value(scenarioOption);
+    options.sMissionFile = parser.value(missionOption);
+    options.sSummaryFile = parser.value(summaryOption);
+    options.iThreadCount = parser.value(threadsOption).toInt();
+    options.dSeparation = parser.value(separationOption).toDouble();
+    options.iHeartbeatMs = qRound(parser.value(heartbeatOption).toDouble()*1000);
+    options.dErrorBound = parser.value(errorBoundOption).toDouble();
+    options.bTrajectory = parser.isSet(trajectoryOption);
+    options.sTerrainDirectory = parser.value(terrainOption);
+    options.dTerrainClearance = parser.value(clearanceOption).toDouble();
+
+    new Model::DroneManager(options, nullptr);
     return a.exec();
 }
@@ -55,7 +55,27 @@ HEADERS += \
     spyclib_global.h \
     tcpserver.h \
     tcpclient.h \
-    defs.h
+    defs.h \
+    messageschema.h \
+    simulationscheduler.h \
+    fleetstate.h \
+    kinematicskernel.h \
+    fleetkinematics.h \
+    simulationcontext.h \
+    geoutils.h \
+    energymodel.h \
+    geofenceengine.h \
+    proximitymonitor.h \
+    planvalidator.h \
+    routeplanner.h \
+    statustracker.h \
+    terraincache.h \
+    scenario.h \
+    simulatorobserver.h \
+    simulatorsignals.h \
+    geopoint.h \
+    flightpath.h \
+    workerpool.h
 
 SOURCES += \
     spycore.cpp \
@@ -66,4 +86,21 @@ SOURCES += \
     batterysimulator.cpp \
     flightsimulator.cpp \
     tcpserver.cpp \
-    tcpclient.cpp
+    tcpclient.cpp \
+    messageschema.cpp \
+    simulationscheduler.cpp \
+    fleetstate.cpp \
+    kinematicskernel.cpp \
+    fleetkinematics.cpp \
+    geoutils.cpp \
+    energymodel.cpp \
+    geofenceengine.cpp \
+    proximitymonitor.cpp \
+    planvalidator.cpp \
+    routeplanner.cpp \
+    statustracker.cpp \
+    terraincache.cpp \
+    scenario.cpp \
+    simulatorsignals.cpp \
+    flightpath.cpp \
+    workerpool.cpp
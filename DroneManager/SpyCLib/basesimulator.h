@@ -1,46 +1,63 @@
 #ifndef BASESIMULATOR_H
 #define BASESIMULATOR_H
 
-// Qt
-#include <QObject>
-#include <QTimer>
-
 // Application
+#include "simulationscheduler.h"
+#include "fleetstate.h"
+#include "simulatorobserver.h"
 #include "spyclib_global.h"
 
 namespace Core {
-class SPYCLIBSHARED_EXPORT BaseSimulator : public QObject
+class SPYCLIBSHARED_EXPORT BaseSimulator
 {
-    Q_OBJECT
-
 public:
     //-------------------------------------------------------------------------------------------------
     // Constructors and destructor
     //-------------------------------------------------------------------------------------------------
 
-    //! Constructor
-    explicit BaseSimulator(QObject *pParent=nullptr) : QObject(pParent) {}
+    //! Constructor (no scheduler task if iPeriodMs <= 0: simulator is driven from outside, pObserver: optional output observer)
+    BaseSimulator(int iPeriodMs, SimulationScheduler *pScheduler, FleetState *pFleetState, int iSlot, SimulatorObserver *pObserver=nullptr) :
+        m_pScheduler(pScheduler), m_pFleetState(pFleetState), m_iSlot(iSlot), m_pObserver(pObserver)
+    {
+        if (iPeriodMs > 0)
+            m_iTaskId = m_pScheduler->addTask(iPeriodMs, [this]() { onTimeOut(); }, false);
+    }
 
     //! Destructor
-    virtual ~BaseSimulator() {}
+    virtual ~BaseSimulator()
+    {
+        if (m_iTaskId >= 0)
+            m_pScheduler->removeTask(m_iTaskId);
+    }
 
     //-------------------------------------------------------------------------------------------------
     // Control methods
     //-------------------------------------------------------------------------------------------------
 
     //! Start
-    virtual void start() = 0;
+    virtual void start() { if (m_iTaskId >= 0) m_pScheduler->setTaskEnabled(m_iTaskId, true); }
 
     //! Stop
-    virtual void stop() = 0;
+    virtual void stop() { if (m_iTaskId >= 0) m_pScheduler->setTaskEnabled(m_iTaskId, false); }
 
-protected:
-    //! Timer
-    QTimer m_timer;
-
-public slots:
     //! Time out
     virtual void onTimeOut() {}
+
+protected:
+    //! Scheduler
+    SimulationScheduler *m_pScheduler = nullptr;
+
+    //! Scheduler task id
+    int m_iTaskId = -1;
+
+    //! Fleet state (simulators write their output there)
+    FleetState *m_pFleetState = nullptr;
+
+    //! Drone slot in fleet state
+    int m_iSlot = -1;
+
+    //! Output observer (null: fleet state is the only output)
+    SimulatorObserver *m_pObserver = nullptr;
 };
 }
 
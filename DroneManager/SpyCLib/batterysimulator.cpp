@@ -1,16 +1,20 @@
 // Qt
+#include <QtMath>
 #include <QDebug>
 
 // Application
 #include "batterysimulator.h"
+#include "energymodel.h"
+#include "flightpath.h"
+#define BATTERY_PERIOD_MS 500
+#define RETURN_RESERVE 5.
 using namespace Core;
 
 //-------------------------------------------------------------------------------------------------
 
-BatterySimulator::BatterySimulator(QObject *pParent) : BaseSimulator(pParent)
+BatterySimulator::BatterySimulator(SimulationScheduler *pScheduler, FleetState *pFleetState, int iSlot, SimulatorObserver *pObserver) : BaseSimulator(BATTERY_PERIOD_MS, pScheduler, pFleetState, iSlot, pObserver)
 {
-    m_timer.setInterval(500);
-    connect(&m_timer, &QTimer::timeout, this, &BatterySimulator::onTimeOut, Qt::QueuedConnection);
+
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -24,24 +28,75 @@ BatterySimulator::~BatterySimulator()
 
 void BatterySimulator::start()
 {
-    m_timer.start();
+    // Fresh battery on each take off
+    m_dBatteryLevel = 100;
+    m_bLowAlarm = false;
+    m_pFleetState->batteryLevel(m_iSlot) = 100;
+    BaseSimulator::start();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void BatterySimulator::setRoute(const QSharedPointer<const FlightPath> &pFlightPath, double dLandingEnergy)
+{
+    m_pFlightPath = pFlightPath;
+    m_dLandingEnergy = dLandingEnergy;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void BatterySimulator::setAlarmHandler(const AlarmHandler &alarmHandler)
+{
+    m_alarmHandler = alarmHandler;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double BatterySimulator::returnEnergy() const
+{
+    if (m_pFlightPath.isNull() || m_pFlightPath->isEmpty())
+        return m_dLandingEnergy;
+
+    // Prefix sums: energy left on the path loop is total minus energy spent so far on the current leg
+    int iLeg = m_pFleetState->pathCursor(m_iSlot);
+    double dDistance = m_pFleetState->pathDistance(m_iSlot)+m_pFleetState->segmentDistance(m_iSlot);
+    return m_pFlightPath->energy()-m_pFlightPath->energyAt(dDistance, iLeg)+m_dLandingEnergy;
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void BatterySimulator::onTimeOut()
 {
-    emit batteryLevelChanged(m_iBatteryLevel, m_iReturnLevel);
+    double dDeltaTime = BATTERY_PERIOD_MS/1000.;
+    m_dBatteryLevel = qMax(0., m_dBatteryLevel-Energy::power(m_pFleetState->speed(m_iSlot))*dDeltaTime);
+
+    int iBatteryLevel = qFloor(m_dBatteryLevel);
+    int iReturnLevel = qMin(100, qCeil(returnEnergy()+RETURN_RESERVE));
+    m_pFleetState->batteryLevel(m_iSlot) = iBatteryLevel;
+    m_pFleetState->returnLevel(m_iSlot) = iReturnLevel;
+    if (m_pObserver != nullptr)
+        m_pObserver->onBatteryLevelChanged(m_iSlot);
 
-    m_iBatteryLevel--;
-    if (m_iBatteryLevel < 0)
-        m_iBatteryLevel = 100;
-    m_iReturnLevel = (100-m_iBatteryLevel)/2;
+    // Empty: nothing left to fly on, the handler lands the drone where it is
+    if (iBatteryLevel <= 0)
+    {
+        stop();
+        if (m_alarmHandler)
+            m_alarmHandler(SpyCore::BATTERY_EMPTY);
+    }
+    else
+    // Time to head home: raised once, the ground station decides (fail safe, new landing plan...)
+    if (!m_bLowAlarm && (iBatteryLevel <= iReturnLevel))
+    {
+        m_bLowAlarm = true;
+        if (m_alarmHandler)
+            m_alarmHandler(SpyCore::BATTERY_LOW);
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void BatterySimulator::stop()
 {
-    m_timer.stop();
+    BaseSimulator::stop();
 }
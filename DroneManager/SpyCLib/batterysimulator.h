@@ -2,25 +2,30 @@
 #define BATTERYSIMULATOR_H
 
 // Qt
-#include <QObject>
-#include <QTimer>
+#include <QSharedPointer>
+
+// Std
+#include <functional>
 
 // Application
 #include "basesimulator.h"
+#include "spycore.h"
 #include "spyclib_global.h"
 
 namespace Core {
+class FlightPath;
 class SPYCLIBSHARED_EXPORT BatterySimulator : public Core::BaseSimulator
 {
-    Q_OBJECT
-
 public:
+    //! Alarm handler (BATTERY_LOW once per flight when the level reaches the return level, BATTERY_EMPTY at 0%)
+    typedef std::function<void(SpyCore::DroneError)> AlarmHandler;
+
     //-------------------------------------------------------------------------------------------------
     // Constructors and destructor
     //-------------------------------------------------------------------------------------------------
 
     //! Constructor
-    BatterySimulator(QObject *pParent=nullptr);
+    BatterySimulator(SimulationScheduler *pScheduler, FleetState *pFleetState, int iSlot, SimulatorObserver *pObserver=nullptr);
 
     //! Destructor
     ~BatterySimulator();
@@ -29,26 +34,43 @@ public:
     // Control methods
     //-------------------------------------------------------------------------------------------------
 
-    //! Start
+    //! Start with a full battery (take off)
     virtual void start();
 
     //! Stop
     virtual void stop();
 
+    //! Time out
+    virtual void onTimeOut();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Set route home: remainder of flight path, then dLandingEnergy (battery %) to fly the landing plan
+    void setRoute(const QSharedPointer<const FlightPath> &pFlightPath, double dLandingEnergy);
+
+    //! Return energy needed to reach the end of the landing plan from current position (battery %)
+    double returnEnergy() const;
+
+    //! Set alarm handler (the simulator stops by itself once the battery is empty)
+    void setAlarmHandler(const AlarmHandler &alarmHandler);
+
 private:
-    //! Battery level
-    int m_iBatteryLevel = 100;
+    //! Battery level (%)
+    double m_dBatteryLevel = 100;
 
-    //! Return level
-    int m_iReturnLevel = 0;
+    //! Flight path flown
+    QSharedPointer<const FlightPath> m_pFlightPath;
 
-public slots:
-    //! Time out
-    void onTimeOut();
+    //! Energy to fly the landing plan from the flight path end (battery %)
+    double m_dLandingEnergy = 0;
+
+    //! Alarm handler
+    AlarmHandler m_alarmHandler;
 
-signals:
-    //! Battery level changed
-    void batteryLevelChanged(int iLevel, int iReturn);
+    //! Low battery alarm raised during this flight?
+    bool m_bLowAlarm = false;
 };
 }
 
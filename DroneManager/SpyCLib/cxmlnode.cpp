@@ -20,6 +20,26 @@ using namespace Core;
 QString const CXMLNode::sExtension_XML = ".xml";
 QString const CXMLNode::sExtension_QRC = ".qrc";
 QString const CXMLNode::sExtension_JSON = ".json";
+QString const CXMLNode::sExtension_CBOR = ".cbor";
+
+//-------------------------------------------------------------------------------------------------
+
+/*!
+    Reads a (possibly chunked) CBOR text string from \a reader.
+*/
+static QString readCBORString(QCborStreamReader& reader)
+{
+    QString sResult;
+    QCborStreamReader::StringResult<QString> result = reader.readString();
+
+    while (result.status == QCborStreamReader::Ok)
+    {
+        sResult += result.data;
+        result = reader.readString();
+    }
+
+    return sResult;
+}
 
 //-------------------------------------------------------------------------------------------------
 
@@ -142,7 +162,7 @@ QVector<CXMLNode>& CXMLNode::nodes()
 //-------------------------------------------------------------------------------------------------
 
 /*!
-    Returns a CXMLNode hierarchy loaded from the file named \a sFileName (XML or JSON).
+    Returns a CXMLNode hierarchy loaded from the file named \a sFileName (XML, JSON or CBOR).
 */
 CXMLNode CXMLNode::load(const QString& sFileName)
 {
@@ -154,6 +174,10 @@ CXMLNode CXMLNode::load(const QString& sFileName)
     {
         return loadJSONFromFile(sFileName);
     }
+    else if (sFileName.toLower().endsWith(sExtension_CBOR))
+    {
+        return loadCBORFromFile(sFileName);
+    }
 
     return CXMLNode();
 }
@@ -161,7 +185,7 @@ CXMLNode CXMLNode::load(const QString& sFileName)
 //-------------------------------------------------------------------------------------------------
 
 /*!
-    Saves this CXMLNode tree to the file named \a sFileName (XML or JSON). \br
+    Saves this CXMLNode tree to the file named \a sFileName (XML, JSON or CBOR). \br
     Returns \c true if successful, \c false otherwise.
 */
 bool CXMLNode::save(const QString& sFileName)
@@ -180,6 +204,10 @@ bool CXMLNode::save(const QString& sFileName)
     {
         return saveJSONToFile(sFileName);
     }
+    else if (sLowerFileName.endsWith(sExtension_CBOR))
+    {
+        return saveCBORToFile(sFileName);
+    }
 
     return false;
 }
@@ -232,6 +260,29 @@ CXMLNode CXMLNode::loadJSONFromFile(const QString& sFileName)
 
 //-------------------------------------------------------------------------------------------------
 
+/*!
+    Returns a CXMLNode hierarchy loaded from the CBOR file named \a sFileName.
+*/
+CXMLNode CXMLNode::loadCBORFromFile(const QString& sFileName)
+{
+    QFile cborFile(sFileName);
+
+    if (cborFile.exists())
+    {
+        if (cborFile.open(QIODevice::ReadOnly))
+        {
+            QByteArray baData = cborFile.readAll();
+            cborFile.close();
+
+            return parseCBOR(baData);
+        }
+    }
+
+    return CXMLNode();
+}
+
+//-------------------------------------------------------------------------------------------------
+
 /*!
     Returns a CXMLNode tree parsed from the \a node.
 */
@@ -372,6 +423,104 @@ CXMLNode CXMLNode::parseJSON(QString sText)
 
 //-------------------------------------------------------------------------------------------------
 
+/*!
+    Parses a CBOR map from \a reader, using \a sTagName as a tag name. \br
+    The map layout is the same as the JSON one: text values are attributes, maps are child nodes
+    and arrays are lists of child nodes sharing the same tag.
+*/
+CXMLNode CXMLNode::parseCBORNode(QCborStreamReader& reader, QString sTagName)
+{
+    CXMLNode tNode;
+
+    tNode.m_sTag = sTagName;
+    tNode.m_sValue = "";
+
+    if (tNode.m_sTag.isEmpty())
+    {
+        tNode.m_sTag = QString("NOTAG");
+    }
+
+    if (reader.isMap() == false)
+    {
+        reader.next();
+        return tNode;
+    }
+
+    reader.enterContainer();
+
+    while (reader.lastError() == QCborError::NoError && reader.hasNext())
+    {
+        if (reader.isString() == false)
+        {
+            // Only text keys are part of the logical tree
+            reader.next();
+            reader.next();
+            continue;
+        }
+
+        QString sKey = readCBORString(reader);
+
+        if (reader.isMap())
+        {
+            tNode.m_vNodes.append(CXMLNode::parseCBORNode(reader, sKey));
+        }
+        else if (reader.isArray())
+        {
+            reader.enterContainer();
+
+            while (reader.lastError() == QCborError::NoError && reader.hasNext())
+            {
+                tNode.m_vNodes.append(CXMLNode::parseCBORNode(reader, sKey));
+            }
+
+            reader.leaveContainer();
+        }
+        else if (reader.isString())
+        {
+            tNode.m_vAttributes[sKey] = readCBORString(reader);
+        }
+        else if (reader.isInteger())
+        {
+            tNode.m_vAttributes[sKey] = QString::number(reader.toInteger());
+            reader.next();
+        }
+        else if (reader.isDouble())
+        {
+            tNode.m_vAttributes[sKey] = QString::number(reader.toDouble());
+            reader.next();
+        }
+        else
+        {
+            reader.next();
+        }
+    }
+
+    reader.leaveContainer();
+
+    return tNode;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+/*!
+    Returns a CBOR hierarchy from \a baData, as a CXMLNode tree.
+*/
+CXMLNode CXMLNode::parseCBOR(const QByteArray& baData)
+{
+    CXMLNode tNode;
+
+    if (baData.isEmpty() == false)
+    {
+        QCborStreamReader reader(baData);
+
+        tNode = CXMLNode::parseCBORNode(reader, "");
+    }
+
+    return tNode;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 /*!
     Returns a string containing the textual XML equivalent of this CXMLNode tree. \br\br
     If \a bXMLHeader is \c true, the xml file will contain a header of the type <?xml version="1.0" encoding="UTF-8"?>
@@ -511,6 +660,174 @@ QJsonObject CXMLNode::toJsonObject() const
 
 //-------------------------------------------------------------------------------------------------
 
+/*!
+    Writes this CXMLNode tree as a CBOR map to \a writer, using the JSON layout.
+*/
+void CXMLNode::toCborStream(QCborStreamWriter& writer) const
+{
+    QStringList sTagList;
+
+    for (int iIndex = 0; iIndex < m_vNodes.count(); iIndex++)
+    {
+        if (sTagList.contains(m_vNodes[iIndex].tag()) == false)
+        {
+            sTagList << m_vNodes[iIndex].tag();
+        }
+    }
+
+    writer.startMap(quint64(m_vAttributes.count() + sTagList.count()));
+
+    for (QMap<QString, QString>::const_iterator it = m_vAttributes.constBegin(); it != m_vAttributes.constEnd(); ++it)
+    {
+        writer.append(it.key());
+        writer.append(it.value());
+    }
+
+    foreach (QString sTag, sTagList)
+    {
+        QVector<CXMLNode> vNodes = getNodesByTagName(sTag);
+
+        writer.append(sTag);
+
+        if (vNodes.count() > 1)
+        {
+            writer.startArray(quint64(vNodes.count()));
+
+            foreach (CXMLNode xNode, vNodes)
+            {
+                xNode.toCborStream(writer);
+            }
+
+            writer.endArray();
+        }
+        else
+        {
+            vNodes[0].toCborStream(writer);
+        }
+    }
+
+    writer.endMap();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+/*!
+    Returns the CBOR equivalent of this CXMLNode tree.
+*/
+QByteArray CXMLNode::toCbor() const
+{
+    QByteArray baData;
+    QCborStreamWriter writer(&baData);
+
+    toCborStream(writer);
+
+    return baData;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+/*!
+    Returns this message encoded as \a eFormat. \br
+    Messages are rooted on an untagged node; in XML the single message node becomes the document element.
+*/
+QByteArray CXMLNode::serialize(Format eFormat) const
+{
+    switch (eFormat)
+    {
+    case XML:
+        if (m_sTag.isEmpty() && m_vNodes.count() == 1)
+        {
+            return m_vNodes[0].toString().toUtf8();
+        }
+        return toString().toUtf8();
+
+    case CBOR:
+        return toCbor();
+
+    case JSON:
+    default:
+        return toJsonDocument().toJson(QJsonDocument::Compact);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+/*!
+    Returns the message tree decoded from \a baData as \a eFormat. \br
+    The tree always has the same shape whatever the format: an untagged root whose children are the messages.
+*/
+CXMLNode CXMLNode::deserialize(const QByteArray& baData, Format eFormat)
+{
+    switch (eFormat)
+    {
+    case XML:
+    {
+        CXMLNode rootNode;
+        CXMLNode messageNode = parseXML(QString::fromUtf8(baData));
+
+        if (messageNode.isEmpty() == false)
+        {
+            rootNode.m_vNodes.append(messageNode);
+        }
+
+        return rootNode;
+    }
+
+    case CBOR:
+        return parseCBOR(baData);
+
+    case JSON:
+    default:
+        return parseJSON(QString::fromUtf8(baData));
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+/*!
+    Returns the message tree decoded from \a baData, whatever its format.
+*/
+CXMLNode CXMLNode::parse(const QByteArray& baData)
+{
+    return deserialize(baData, detectFormat(baData));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+/*!
+    Returns the format of \a baData. \br
+    A CBOR message always starts with a map header (major type 5), which can neither be
+    the '{' of a JSON object nor the '<' of a XML document.
+*/
+CXMLNode::Format CXMLNode::detectFormat(const QByteArray& baData)
+{
+    for (int iIndex = 0; iIndex < baData.size(); iIndex++)
+    {
+        uchar cByte = (uchar)baData.at(iIndex);
+
+        if ((cByte & 0xE0) == 0xA0)
+        {
+            return CBOR;
+        }
+        else if (cByte == '<')
+        {
+            return XML;
+        }
+        else if (cByte == '{')
+        {
+            return JSON;
+        }
+        else if (cByte != ' ' && cByte != '\t' && cByte != '\r' && cByte != '\n')
+        {
+            break;
+        }
+    }
+
+    return JSON;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 /*!
     Saves this CXMLNode tree as XML in the file named \a sFileName. \br
     If \a bXMLHeader is \c true, the xml file will contain a header of the type <?xml version="1.0" encoding="UTF-8"?> \br
@@ -554,6 +871,27 @@ bool CXMLNode::saveJSONToFile(const QString& sFileName)
 
 //-------------------------------------------------------------------------------------------------
 
+/*!
+    Saves this CXMLNode tree as CBOR in the file named \a sFileName. \br
+    Returns \c true if successful, \c false otherwise.
+*/
+bool CXMLNode::saveCBORToFile(const QString& sFileName)
+{
+    QFile cborFile(sFileName);
+
+    if (cborFile.open(QIODevice::WriteOnly))
+    {
+        cborFile.write(toCbor());
+        cborFile.close();
+
+        return true;
+    }
+
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 /*!
     Appends \a value to the child nodes of this node.
 */
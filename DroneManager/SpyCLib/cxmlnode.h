@@ -13,6 +13,8 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
 
 //-------------------------------------------------------------------------------------------------
 
@@ -22,6 +24,10 @@ class SPYCLIBSHARED_EXPORT CXMLNode
 {
 public:
 
+    //! Format d'encodage
+    //! Encoding format
+    enum Format {XML, JSON, CBOR};
+
     //-------------------------------------------------------------------------------------------------
     // Constructeurs et destructeur
     // Constructors and destructor
@@ -113,6 +119,10 @@ public:
     //! Reads a JSON file given a file name
     static CXMLNode loadJSONFromFile(const QString& sFileName);
 
+    //! Lit un fichier CBOR d'apr�s un nom de fichier
+    //! Reads a CBOR file given a file name
+    static CXMLNode loadCBORFromFile(const QString& sFileName);
+
     //! Convertit en QString
     //! Converts the document to a string
     QString toString(bool bXMLHeader = true) const;
@@ -125,6 +135,26 @@ public:
     //! Saves a XML file
     bool saveJSONToFile(const QString& sFileName);
 
+    //! Ecrit un fichier CBOR
+    //! Saves a CBOR file
+    bool saveCBORToFile(const QString& sFileName);
+
+    //! Encode un message dans le format donn�
+    //! Encodes a message in the given format
+    QByteArray serialize(Format eFormat) const;
+
+    //! D�code un message dans le format donn�
+    //! Decodes a message in the given format
+    static CXMLNode deserialize(const QByteArray& baData, Format eFormat);
+
+    //! D�code un message en d�tectant son format
+    //! Decodes a message, detecting its format
+    static CXMLNode parse(const QByteArray& baData);
+
+    //! D�tecte le format d'un message
+    //! Detects the format of a message
+    static Format detectFormat(const QByteArray& baData);
+
     //! Ajoute un noeud aux noeuds enfants de ce noeud
     //! Appends a node to the child nodes of this node
     CXMLNode& operator << (CXMLNode value);
@@ -152,6 +182,14 @@ public:
     //! Reads a JSON file
     static CXMLNode parseJSON(QString sText);
 
+    //! Lit un objet CBOR
+    //! Reads a CBOR map
+    static CXMLNode parseCBORNode(QCborStreamReader& reader, QString sTagName);
+
+    //! Lit un document CBOR
+    //! Reads a CBOR document
+    static CXMLNode parseCBOR(const QByteArray& baData);
+
     //! Convertit en QDomDocument
     //! Converts the node to a QDomDocument
     QDomDocument toQDomDocument(bool bXMLHeader = true) const;
@@ -171,6 +209,14 @@ public:
     //!
     QJsonObject toJsonObject() const;
 
+    //! Ecrit ce noeud dans 'writer'
+    //! Writes the node to 'writer'
+    void toCborStream(QCborStreamWriter& writer) const;
+
+    //! Convertit en CBOR
+    //! Converts the node to CBOR
+    QByteArray toCbor() const;
+
     //! Fusionne le noeud 'target' avec ce noeud
     //! Merges the 'target' node into this node
     void merge(const CXMLNode& xTarget);
@@ -189,6 +235,7 @@ public:
     static const QString sExtension_XML;
     static const QString sExtension_QRC;
     static const QString sExtension_JSON;
+    static const QString sExtension_CBOR;
 
     //-------------------------------------------------------------------------------------------------
     // Propri�t�s
@@ -1,46 +1,110 @@
 #ifndef DEFS_H
 #define DEFS_H
 
-#define TAG_DRONE_STATUS "DRONESTATUS"
-#define TAG_PAYLOAD "PAYLOAD"
-#define ATTR_VIDEO_URL "VIDEOURL"
+//-------------------------------------------------------------------------------------------------
+// Message schema
+//
+// Single declaration point for every tag and attribute exchanged with the ground station.
+// Each entry is X(key, wire name).
+// The key enum, the name table and the typed field codecs of messageschema.h are generated
+// from this list: to add a field, append it here.
+//-------------------------------------------------------------------------------------------------
 
-#define TAG_POSITION "POSITION"
-#define ATTR_DRONE_UID "DRONEUID"
-#define ATTR_LONGITUDE "LONGITUDE"
-#define ATTR_LATITUDE "LATITUDE"
-#define ATTR_ALTITUDE "ALTITUDE"
-#define ATTR_HEADING "HEADING"
-#define ATTR_FLIGHT_STATUS "FLIGHTSTATUS"
-
-#define TAG_BATTERY "BATTERY"
-#define ATTR_LEVEL "LEVEL"
-#define ATTR_RETURN "RETURN"
-
-#define TAG_MISSION_PLAN "MISSIONPLAN"
-#define TAG_WAY_POINT "WAYPOINT"
-#define TAG_WAY_POINT_METADATA "WAYPOINTMETADATA"
-#define ATTR_WAY_POINT_TYPE "TYPE"
-#define ATTR_WAY_POINT_SPEED "SPEED"
-#define ATTR_WAY_POINT_CLOCKWISE "CLOCKWISE"
-
-#define TAG_SAFETY_PLAN "SAFETY"
-
-#define TAG_LANDING_PLAN "LANDINGPLAN"
-
-#define TAG_DRONE_ERROR "DRONEERROR"
-#define ATTR_ERROR "ERROR"
-
-#define TAG_RECTANGLE "RECTANGLE"
-
-#define TAG_CIRCLE "CIRCLE"
-#define ATTR_RADIUS "RADIUS"
-#define ATTR_CENTER "CENTER"
-#define TAG_TRIANGLE "TRIANGLE"
-#define TAG_COORD "COORD"
-
-#define TAG_TAKE_OFF "TAKEOFF"
-#define TAG_FAIL_SAFE "FAILSAFE"
-#define TAG_FAIL_SAFE_DONE "FAILSAFEDONE"
+#define SPYC_SCHEMA_KEYS(X) \
+    X(TAG_DRONE_STATUS,         "DRONESTATUS") \
+    X(TAG_PAYLOAD,              "PAYLOAD") \
+    X(ATTR_VIDEO_URL,           "VIDEOURL") \
+    X(ATTR_TIMESTAMP,           "TIMESTAMP") \
+    \
+    X(TAG_POSITION,             "POSITION") \
+    X(ATTR_DRONE_UID,           "DRONEUID") \
+    X(ATTR_DRONE_HANDLE,        "HANDLE") \
+    X(ATTR_LONGITUDE,           "LONGITUDE") \
+    X(ATTR_LATITUDE,            "LATITUDE") \
+    X(ATTR_ALTITUDE,            "ALTITUDE") \
+    X(ATTR_HEADING,             "HEADING") \
+    X(ATTR_FLIGHT_STATUS,       "FLIGHTSTATUS") \
+    X(ATTR_VELOCITY_NORTH,      "VNORTH") \
+    X(ATTR_VELOCITY_EAST,       "VEAST") \
+    \
+    X(TAG_BATTERY,              "BATTERY") \
+    X(ATTR_LEVEL,               "LEVEL") \
+    X(ATTR_RETURN,              "RETURN") \
+    \
+    X(TAG_MISSION_PLAN,         "MISSIONPLAN") \
+    X(TAG_WAY_POINT,            "WAYPOINT") \
+    X(TAG_WAY_POINT_METADATA,   "WAYPOINTMETADATA") \
+    X(ATTR_WAY_POINT_TYPE,      "TYPE") \
+    X(ATTR_WAY_POINT_SPEED,     "SPEED") \
+    X(ATTR_WAY_POINT_CLOCKWISE, "CLOCKWISE") \
+    X(ATTR_PATTERN_LENGTH,      "LENGTH") \
+    X(ATTR_PATTERN_TURNS,       "TURNS") \
+    X(ATTR_PATTERN_ORIENTATION, "ORIENTATION") \
+    \
+    X(TAG_SAFETY_PLAN,          "SAFETY") \
+    \
+    X(TAG_LANDING_PLAN,         "LANDINGPLAN") \
+    \
+    X(TAG_PLAN_ERROR,           "PLANERROR") \
+    X(ATTR_INDEX,               "INDEX") \
+    \
+    X(TAG_ROUTE,                "ROUTE") \
+    \
+    X(TAG_TRAJECTORY,           "TRAJECTORY") \
+    X(ATTR_PROGRESS,            "PROGRESS") \
+    \
+    X(TAG_DRONE_ERROR,          "DRONEERROR") \
+    X(ATTR_ERROR,               "ERROR") \
+    \
+    X(TAG_RECTANGLE,            "RECTANGLE") \
+    \
+    X(TAG_CIRCLE,               "CIRCLE") \
+    X(ATTR_RADIUS,              "RADIUS") \
+    X(ATTR_CENTER,              "CENTER") \
+    X(TAG_TRIANGLE,             "TRIANGLE") \
+    X(TAG_COORD,                "COORD") \
+    X(TAG_EXCLUSION_AREA,       "EXCLUSIONAREA") \
+    \
+    X(TAG_GEOFENCE,             "GEOFENCE") \
+    X(ATTR_ZONE,                "ZONE") \
+    X(ATTR_ZONE_TYPE,           "ZONETYPE") \
+    X(ATTR_EVENT,               "EVENT") \
+    \
+    X(TAG_PROXIMITY,            "PROXIMITY") \
+    X(ATTR_OTHER_DRONE_UID,     "OTHERDRONEUID") \
+    X(ATTR_DISTANCE,            "DISTANCE") \
+    X(ATTR_CONFLICT,            "CONFLICT") \
+    \
+    X(TAG_TAKE_OFF,             "TAKEOFF") \
+    X(TAG_FAIL_SAFE,            "FAILSAFE") \
+    X(TAG_FAIL_SAFE_DONE,       "FAILSAFEDONE") \
+    \
+    X(TAG_BATCH,                "BATCH") \
+    X(TAG_BATCH_ENTRY,          "ENTRY") \
+    \
+    X(TAG_SCENARIO,             "SCENARIO") \
+    X(TAG_DRONE,                "DRONE") \
+    X(ATTR_COUNT,               "COUNT") \
+    X(ATTR_UID_PREFIX,          "UIDPREFIX") \
+    X(ATTR_SPACING,             "SPACING") \
+    \
+    X(TAG_SUMMARY,              "SUMMARY") \
+    X(ATTR_SIMULATION_TIME,     "SIMULATIONTIME") \
+    X(ATTR_WALL_TIME,           "WALLTIME") \
+    X(ATTR_SPEED_UP,            "SPEEDUP") \
+    X(ATTR_TICKS,               "TICKS") \
+    X(ATTR_OVERRUNS,            "OVERRUNS") \
+    X(ATTR_DRONES,              "DRONES") \
+    X(ATTR_FLYING,              "FLYING") \
+    X(ATTR_MIN_BATTERY,         "MINBATTERY") \
+    X(ATTR_MEAN_BATTERY,        "MEANBATTERY") \
+    X(ATTR_GEOFENCE_EVENTS,     "GEOFENCEEVENTS") \
+    X(ATTR_PROXIMITY_ALERTS,    "PROXIMITYALERTS") \
+    X(ATTR_PROXIMITY_CONFLICTS, "PROXIMITYCONFLICTS") \
+    X(ATTR_PROXIMITY_MEAN_US,   "PROXIMITYMEANUS") \
+    X(ATTR_PROXIMITY_MAX_US,    "PROXIMITYMAXUS") \
+    X(ATTR_STATUS_CHANGES,      "STATUSCHANGES") \
+    X(ATTR_STATUS_HEARTBEATS,   "STATUSHEARTBEATS") \
+    X(ATTR_STARTUP_MS,          "STARTUPMS")
 
 #endif // DEFS_H
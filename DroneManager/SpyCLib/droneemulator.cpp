@@ -1,44 +1,49 @@
 // Qt
 #include <QDebug>
-#include <QTime>
 
 // Application
 #include <cxmlnode.h>
 #include "droneemulator.h"
 #include "flightsimulator.h"
 #include "batterysimulator.h"
+#include "simulationscheduler.h"
+#include "fleetstate.h"
+#include "energymodel.h"
+#include "geofenceengine.h"
 #include "serializehelper.h"
 using namespace Core;
 
 //-------------------------------------------------------------------------------------------------
 
-DroneEmulator::DroneEmulator(const QString &sDroneUID, const QString &sVideoUrl, const QGeoCoordinate &initalPosition, QObject *pParent) : QObject(pParent),
-    m_sDroneUID(sDroneUID), m_sVideoUrl(sVideoUrl), m_position(initalPosition)
+DroneEmulator::DroneEmulator(const QString &sDroneUID, const QString &sVideoUrl, const QGeoCoordinate &initalPosition, const SimulationContext &context, QObject *pParent) : QObject(pParent),
+    m_sDroneUID(sDroneUID), m_sVideoUrl(sVideoUrl), m_pFleetState(context.pFleetState), m_pScheduler(context.pScheduler), m_pGeofence(context.pGeofence)
 {
-    // Register type
-    qRegisterMetaType<SpyCore::DroneError>("SpyCore::DroneError");
+    // Fleet state slot
+    m_iSlot = m_pFleetState->allocateSlot(sDroneUID, sVideoUrl, initalPosition);
+
+    // Register type (first emulator only)
+    static const int iDroneErrorType = qRegisterMetaType<SpyCore::DroneError>("SpyCore::DroneError");
+    Q_UNUSED(iDroneErrorType);
 
     // Flight simulator
-    m_pFlightSimulator = new FlightSimulator(this);
-    connect(m_pFlightSimulator, &FlightSimulator::positionChanged, this, &DroneEmulator::onPositionChanged, Qt::QueuedConnection);
+    m_pFlightSimulator = new FlightSimulator(m_pScheduler, m_pFleetState, context.pKinematics, m_iSlot, context.pObserver);
+    m_pFlightSimulator->setTerrain(context.pTerrain, context.dTerrainClearance);
 
     // Battery simulator
-    m_pBatterySimulator = new BatterySimulator(this);
-    connect(m_pBatterySimulator, &BatterySimulator::batteryLevelChanged, this, &DroneEmulator::onBatteryLevelChanged, Qt::QueuedConnection);
-
-    // Timer
-    QTime time = QTime::currentTime();
-    qsrand((uint)time.msec());
-    m_droneTimer.setInterval(250);
-    connect(&m_droneTimer, &QTimer::timeout, this, &DroneEmulator::timeOut, Qt::QueuedConnection);
-    m_droneTimer.start();
+    m_pBatterySimulator = new BatterySimulator(m_pScheduler, m_pFleetState, m_iSlot, context.pObserver);
+    m_pBatterySimulator->setAlarmHandler([this](SpyCore::DroneError eAlarm) { onBatteryAlarm(eAlarm); });
 }
 
 //-------------------------------------------------------------------------------------------------
 
 DroneEmulator::~DroneEmulator()
 {
-
+    // Simulators still write into the slot until they are deleted
+    delete m_pFlightSimulator;
+    delete m_pBatterySimulator;
+    if (m_pGeofence != nullptr)
+        m_pGeofence->removeZones(m_iSlot);
+    m_pFleetState->releaseSlot(m_iSlot);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -50,9 +55,23 @@ const QString &DroneEmulator::uid() const
 
 //-------------------------------------------------------------------------------------------------
 
-const SpyCore::FlightStatus &DroneEmulator::flightStatus() const
+const FleetState *DroneEmulator::fleetState() const
+{
+    return m_pFleetState;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DroneEmulator::slot() const
 {
-    return m_eFlightStatus;
+    return m_iSlot;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+SpyCore::FlightStatus DroneEmulator::flightStatus() const
+{
+    return m_pFleetState->flightStatus(m_iSlot);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -65,30 +84,30 @@ QString DroneEmulator::currentStatus() const
 
 //-------------------------------------------------------------------------------------------------
 
-const QGeoCoordinate &DroneEmulator::position() const
+QGeoCoordinate DroneEmulator::position() const
 {
-    return m_position;
+    return m_pFleetState->position(m_iSlot);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 double DroneEmulator::heading() const
 {
-    return m_dHeading;
+    return m_pFleetState->heading(m_iSlot);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 int DroneEmulator::batteryLevel() const
 {
-    return m_iLevel;
+    return m_pFleetState->batteryLevel(m_iSlot);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 int DroneEmulator::returnLevel() const
 {
-    return m_iReturnLevel;
+    return m_pFleetState->returnLevel(m_iSlot);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -100,41 +119,40 @@ const QGeoPath &DroneEmulator::safetyPlan() const
 
 //-------------------------------------------------------------------------------------------------
 
-const QVector<WayPoint> &DroneEmulator::missionPlan() const
+const QList<QGeoShape> &DroneEmulator::exclusionArea() const
 {
-    return m_missionPlan;
+    return m_lExclusionArea;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-const QVector<WayPoint> &DroneEmulator::landingPlan() const
+const QVector<WayPoint> &DroneEmulator::missionPlan() const
 {
-    return m_landingPlan;
+    return m_missionPlan;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-const QString &DroneEmulator::videoUrl() const
+const QVector<WayPoint> &DroneEmulator::landingPlan() const
 {
-    return m_sVideoUrl;
+    return m_landingPlan;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DroneEmulator::onPositionChanged(const QGeoCoordinate &geoCoord, double dHeading)
+QSharedPointer<const FlightPath> DroneEmulator::flightPath() const
 {
-    m_position = geoCoord;
-    m_dHeading = dHeading;
+    return m_pFlightSimulator->flightPath();
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DroneEmulator::onBatteryLevelChanged(int iLevel, int iReturn)
+const QString &DroneEmulator::videoUrl() const
 {
-    m_iLevel = iLevel;
-    m_iReturnLevel = iReturn;
+    return m_sVideoUrl;
 }
 
+
 //-------------------------------------------------------------------------------------------------
 
 void DroneEmulator::takeOff()
@@ -151,8 +169,9 @@ void DroneEmulator::takeOff()
     {
         m_pFlightSimulator->computeFlightPath(m_missionPlan);
         m_pFlightSimulator->start();
+        m_pBatterySimulator->setRoute(m_pFlightSimulator->flightPath(), Energy::routeEnergy(m_missionPlan.first().point(), m_landingPlan));
         m_pBatterySimulator->start();
-        m_eFlightStatus = SpyCore::FlightStatus::FLYING;
+        m_pFleetState->setFlightStatus(m_iSlot, SpyCore::FlightStatus::FLYING);
     }
 }
 
@@ -162,7 +181,18 @@ void DroneEmulator::failSafe()
 {
     m_pFlightSimulator->stop();
     m_pBatterySimulator->stop();
-    m_eFlightStatus = SpyCore::FlightStatus::IDLE;
+    m_pFleetState->setFlightStatus(m_iSlot, SpyCore::FlightStatus::IDLE);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneEmulator::onBatteryAlarm(SpyCore::DroneError eAlarm)
+{
+    emit droneError(eAlarm, m_sDroneUID);
+
+    // Empty battery: forced landing at current position
+    if (eAlarm == SpyCore::BATTERY_EMPTY)
+        failSafe();
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -170,6 +200,8 @@ void DroneEmulator::failSafe()
 void DroneEmulator::setSafetyPlan(const QGeoPath &geoPath)
 {
     m_safetyPlan = geoPath;
+    if (m_pGeofence != nullptr)
+        m_pGeofence->setZones(m_iSlot, m_safetyPlan, m_lExclusionArea);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -185,3 +217,12 @@ void DroneEmulator::setLandingPlan(const WayPointList &vWayPointList)
 {
     m_landingPlan = vWayPointList;
 }
+
+//-------------------------------------------------------------------------------------------------
+
+void DroneEmulator::setExclusionArea(const QList<QGeoShape> &lExclusionArea)
+{
+    m_lExclusionArea = lExclusionArea;
+    if (m_pGeofence != nullptr)
+        m_pGeofence->setZones(m_iSlot, m_safetyPlan, m_lExclusionArea);
+}
@@ -3,19 +3,23 @@
 
 // Qt
 #include <QObject>
-#include <QTimer>
 #include <QGeoCoordinate>
 #include <QGeoPath>
+#include <QGeoShape>
 #include <QVector>
+#include <QSharedPointer>
 
 // Application
 #include "spyclib_global.h"
+#include "simulationcontext.h"
 #include <waypoint.h>
 #include <spycore.h>
 
 namespace Core {
 class FlightSimulator;
+class FlightPath;
 class BatterySimulator;
+class GeofenceEngine;
 class SPYCLIBSHARED_EXPORT DroneEmulator : public QObject
 {
     Q_OBJECT
@@ -26,7 +30,7 @@ public:
     //-------------------------------------------------------------------------------------------------
 
     //! Constructor
-    DroneEmulator(const QString &sDroneUID, const QString &sVideoUrl, const QGeoCoordinate &initialPos, QObject *pParent=nullptr);
+    DroneEmulator(const QString &sDroneUID, const QString &sVideoUrl, const QGeoCoordinate &initialPos, const SimulationContext &context, QObject *pParent=nullptr);
 
     //! Destructor
     virtual ~DroneEmulator();
@@ -38,14 +42,20 @@ public:
     //! Return uid
     const QString &uid() const;
 
+    //! Return fleet state
+    const FleetState *fleetState() const;
+
+    //! Return slot in fleet state
+    int slot() const;
+
     //! Return fly status
-    const SpyCore::FlightStatus &flightStatus() const;
+    SpyCore::FlightStatus flightStatus() const;
 
     //! Return current status
     QString currentStatus() const;
 
     //! Return position
-    const QGeoCoordinate &position() const;
+    QGeoCoordinate position() const;
 
     //! Return heading
     double heading() const;
@@ -59,12 +69,18 @@ public:
     //! Return safety plan
     const QGeoPath &safetyPlan() const;
 
+    //! Return exclusion area
+    const QList<QGeoShape> &exclusionArea() const;
+
     //! Return mission plan
     const QVector<WayPoint> &missionPlan() const;
 
     //! Return landing plan
     const QVector<WayPoint> &landingPlan() const;
 
+    //! Return flight path (computed from mission plan at take off)
+    QSharedPointer<const FlightPath> flightPath() const;
+
     //! Return video url
     const QString &videoUrl() const;
 
@@ -87,13 +103,17 @@ public:
     //! Set landing plan
     void setLandingPlan(const WayPointList &vWayPointList);
 
+    //! Set exclusion area
+    void setExclusionArea(const QList<QGeoShape> &lExclusionArea);
+
+private:
+    //! Battery alarm (BATTERY_LOW reported, BATTERY_EMPTY also lands the drone)
+    void onBatteryAlarm(SpyCore::DroneError eAlarm);
+
 private:
     //! UID
     QString m_sDroneUID = "";
 
-    //! Status
-    SpyCore::FlightStatus m_eFlightStatus = SpyCore::IDLE;
-
     //! Video url
     QString m_sVideoUrl = "";
 
@@ -107,7 +127,7 @@ private:
     QVector<WayPoint> m_landingPlan;
 
     //! Exclusion area
-    QList<QGeoPath> m_lExclusionArea;
+    QList<QGeoShape> m_lExclusionArea;
 
     //! Flight simulator
     FlightSimulator *m_pFlightSimulator = nullptr;
@@ -115,32 +135,19 @@ private:
     //! Battery simulator
     BatterySimulator *m_pBatterySimulator = nullptr;
 
-    //! Current position
-    QGeoCoordinate m_position;
-
-    //! Heading
-    double m_dHeading = 0;
+    //! Fleet state (position, heading, battery, flight status...)
+    FleetState *m_pFleetState = nullptr;
 
-    //! Battery level
-    int m_iLevel = 0;
+    //! Slot in fleet state
+    int m_iSlot = -1;
 
-    //! Return level
-    int m_iReturnLevel = 0;
+    //! Scheduler
+    SimulationScheduler *m_pScheduler = nullptr;
 
-    //! Drone timer
-    QTimer m_droneTimer;
-
-public slots:
-    //! Position changed
-    void onPositionChanged(const QGeoCoordinate &geoCoord, double dHeading);
-
-    //! Battery level changed
-    void onBatteryLevelChanged(int iLevel, int iReturn);
+    //! Geofence engine
+    GeofenceEngine *m_pGeofence = nullptr;
 
 signals:
-    //! Time out
-    void timeOut();
-
     //! New message
     void droneError(const SpyCore::DroneError &eDroneError, const QString &sDroneUID);
 };
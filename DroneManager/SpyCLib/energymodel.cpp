@@ -0,0 +1,41 @@
+// Application
+#include "energymodel.h"
+#include "flightsimulator.h"
+#include "geoutils.h"
+
+// About 80 min hover, 55 min (33 km) at eco speed, 17 min at fast speed on a full battery
+#define HOVER_POWER 0.02
+#define DRAG_COEFFICIENT 1e-5
+#define MIN_SPEED 1.
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+double Energy::power(double dSpeed)
+{
+    return HOVER_POWER+DRAG_COEFFICIENT*dSpeed*dSpeed*dSpeed;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double Energy::perMeter(double dSpeed)
+{
+    dSpeed = qMax(dSpeed, MIN_SPEED);
+    return power(dSpeed)/dSpeed;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double Energy::routeEnergy(const GeoPoint &from, const QVector<WayPoint> &vWayPoints)
+{
+    double dEnergy = 0;
+    GeoPoint previous = from;
+    double dSpeed = FlightSimulator::cruiseSpeed(SpyCore::ECO);
+    foreach (const WayPoint &wayPoint, vWayPoints)
+    {
+        dEnergy += GeoUtils::distance(previous, wayPoint.point())*perMeter(dSpeed);
+        previous = wayPoint.point();
+        dSpeed = FlightSimulator::cruiseSpeed(wayPoint.speed());
+    }
+    return dEnergy;
+}
@@ -0,0 +1,25 @@
+#ifndef ENERGYMODEL_H
+#define ENERGYMODEL_H
+
+// Qt
+#include <QVector>
+#include <QGeoCoordinate>
+
+// Application
+#include "waypoint.h"
+#include "spyclib_global.h"
+
+namespace Core {
+namespace Energy {
+//! Return power drawn at dSpeed m/s (battery %/s): hover power plus parasitic drag
+SPYCLIBSHARED_EXPORT double power(double dSpeed);
+
+//! Return energy spent per meter flown at dSpeed m/s (battery %/m)
+SPYCLIBSHARED_EXPORT double perMeter(double dSpeed);
+
+//! Return energy (battery %) spent flying through way points in order, starting at from (no loop)
+SPYCLIBSHARED_EXPORT double routeEnergy(const GeoPoint &from, const QVector<WayPoint> &vWayPoints);
+}
+}
+
+#endif // ENERGYMODEL_H
@@ -0,0 +1,153 @@
+// Qt
+#include <QDebug>
+
+// Application
+#include "fleetkinematics.h"
+#include "simulationscheduler.h"
+#include "fleetstate.h"
+#include "flightsimulator.h"
+#include "workerpool.h"
+#define MAX_KERNEL_DEVIATION 1e-9
+#define CHUNK_SIZE 256 // Multiple of every SIMD width: slots go through the same kernel lanes whatever the partition
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+FleetKinematics::FleetKinematics(SimulationScheduler *pScheduler, FleetState *pFleetState, WorkerPool *pWorkerPool, int iPeriodMs) :
+    m_pScheduler(pScheduler), m_pFleetState(pFleetState), m_pWorkerPool(pWorkerPool)
+{
+    // Step duration is the period the scheduler actually runs the task at
+    int iTicks = qMax(1, qRound((double)iPeriodMs/m_pScheduler->stepMs()));
+    m_dDeltaTime = iTicks*m_pScheduler->stepMs()/1000.;
+    m_iTaskId = m_pScheduler->addTask(iPeriodMs, [this]() { step(); });
+#ifdef QT_DEBUG
+    m_bVerify = true;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+
+FleetKinematics::~FleetKinematics()
+{
+    m_pScheduler->removeTask(m_iTaskId);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetKinematics::setSimulator(int iSlot, FlightSimulator *pSimulator)
+{
+    if (iSlot < 0)
+        return;
+    if (iSlot >= m_vSimulators.size())
+        m_vSimulators.resize(iSlot+1);
+    m_vSimulators[iSlot] = pSimulator;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetKinematics::setVerifyEnabled(bool bEnabled)
+{
+    m_bVerify = bEnabled;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool FleetKinematics::verifyEnabled() const
+{
+    return m_bVerify;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double FleetKinematics::maxDeviation() const
+{
+    return m_dMaxDeviation;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetKinematics::step()
+{
+    Kinematics::SegmentBatch batch = m_pFleetState->segmentBatch();
+    if (batch.iCount == 0)
+        return;
+    if (m_vSimulators.size() < batch.iCount)
+        m_vSimulators.resize(batch.iCount);
+    m_vSegmentChanged.fill(0, batch.iCount);
+
+    if (m_bVerify)
+        stepReference(batch);
+
+    // Slots only depend on themselves: same result whatever the thread count
+    if (m_pWorkerPool != nullptr)
+        m_pWorkerPool->run(batch.iCount, CHUNK_SIZE, [this, &batch](int iBegin, int iEnd) { stepRange(batch, iBegin, iEnd); });
+    else
+        stepRange(batch, 0, batch.iCount);
+
+    if (m_bVerify)
+        compareWithReference(batch);
+
+    // Observers are notified from this thread, once every worker is done
+    for (int i=0; i<batch.iCount; i++)
+        if (m_vSegmentChanged[i])
+            m_vSimulators[i]->notifyPositionChanged();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetKinematics::stepRange(const Kinematics::SegmentBatch &batch, int iBegin, int iEnd)
+{
+    Kinematics::step(batch, m_dDeltaTime, iBegin, iEnd);
+
+    // Segment changes are rare and branchy: done per drone by its simulator
+    for (int i=iBegin; i<iEnd; i++)
+    {
+        if (batch.pSegmentDone[i] && (m_vSimulators[i] != nullptr))
+        {
+            m_vSimulators[i]->onSegmentDone();
+            m_vSegmentChanged[i] = 1;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetKinematics::stepReference(const Kinematics::SegmentBatch &batch)
+{
+    m_vReferenceDistance.resize(batch.iCount);
+    m_vReferenceLatitude.resize(batch.iCount);
+    m_vReferenceLongitude.resize(batch.iCount);
+    m_vReferenceHeading.resize(batch.iCount);
+    m_vReferenceDone.resize(batch.iCount);
+    std::copy(batch.pDistance, batch.pDistance+batch.iCount, m_vReferenceDistance.begin());
+    std::copy(batch.pLatitude, batch.pLatitude+batch.iCount, m_vReferenceLatitude.begin());
+    std::copy(batch.pLongitude, batch.pLongitude+batch.iCount, m_vReferenceLongitude.begin());
+
+    Kinematics::SegmentBatch reference = batch;
+    reference.pDistance = m_vReferenceDistance.data();
+    reference.pLatitude = m_vReferenceLatitude.data();
+    reference.pLongitude = m_vReferenceLongitude.data();
+    reference.pHeading = m_vReferenceHeading.data();
+    reference.pSegmentDone = m_vReferenceDone.data();
+    Kinematics::stepScalar(reference, m_dDeltaTime, 0, batch.iCount);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetKinematics::compareWithReference(const Kinematics::SegmentBatch &batch)
+{
+    double dDeviation = 0;
+    int iMismatchCount = 0;
+    for (int i=0; i<batch.iCount; i++)
+    {
+        dDeviation = qMax(dDeviation, qAbs(batch.pLatitude[i]-m_vReferenceLatitude[i]));
+        dDeviation = qMax(dDeviation, qAbs(batch.pLongitude[i]-m_vReferenceLongitude[i]));
+        dDeviation = qMax(dDeviation, qAbs(batch.pHeading[i]-m_vReferenceHeading[i]));
+        dDeviation = qMax(dDeviation, qAbs(batch.pDistance[i]-m_vReferenceDistance[i]));
+        if (batch.pSegmentDone[i] != m_vReferenceDone[i])
+            iMismatchCount++;
+    }
+    m_dMaxDeviation = qMax(m_dMaxDeviation, dDeviation);
+    if ((dDeviation > MAX_KERNEL_DEVIATION) || (iMismatchCount > 0))
+        qWarning() << "FleetKinematics::step vectorized kernel differs from scalar path, deviation:" << dDeviation << "segment mismatches:" << iMismatchCount;
+}
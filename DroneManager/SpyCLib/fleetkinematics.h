@@ -0,0 +1,107 @@
+#ifndef FLEETKINEMATICS_H
+#define FLEETKINEMATICS_H
+
+// Qt
+#include <QVector>
+
+// Application
+#include "kinematicskernel.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class SimulationScheduler;
+class FleetState;
+class FlightSimulator;
+class WorkerPool;
+class SPYCLIBSHARED_EXPORT FleetKinematics
+{
+public:
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor (fleet is stepped on the calling thread if pWorkerPool is null)
+    FleetKinematics(SimulationScheduler *pScheduler, FleetState *pFleetState, WorkerPool *pWorkerPool=nullptr, int iPeriodMs=100);
+
+    //! Destructor
+    ~FleetKinematics();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Set flight simulator of a slot (nullptr to unregister)
+    void setSimulator(int iSlot, FlightSimulator *pSimulator);
+
+    //! Check vectorized step against scalar path on each step
+    void setVerifyEnabled(bool bEnabled);
+
+    //! Return true if vectorized step is checked against scalar path
+    bool verifyEnabled() const;
+
+    //! Return largest deviation between vectorized and scalar steps seen so far
+    double maxDeviation() const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Advance whole fleet by one period
+    void step();
+
+private:
+    //! Advance drones [iBegin, iEnd[ (run by worker threads: touches these slots only)
+    void stepRange(const Kinematics::SegmentBatch &batch, int iBegin, int iEnd);
+
+    //! Run scalar step on a copy of the output columns
+    void stepReference(const Kinematics::SegmentBatch &batch);
+
+    //! Compare vectorized step with reference
+    void compareWithReference(const Kinematics::SegmentBatch &batch);
+
+private:
+    //! Scheduler
+    SimulationScheduler *m_pScheduler = nullptr;
+
+    //! Scheduler task id
+    int m_iTaskId = -1;
+
+    //! Fleet state
+    FleetState *m_pFleetState = nullptr;
+
+    //! Worker pool
+    WorkerPool *m_pWorkerPool = nullptr;
+
+    //! Step duration (s)
+    double m_dDeltaTime = 0;
+
+    //! Flight simulators (slot indexed)
+    QVector<FlightSimulator *> m_vSimulators;
+
+    //! Segment changed during last step (slot indexed)
+    QVector<uchar> m_vSegmentChanged;
+
+    //! Verify flag
+    bool m_bVerify = false;
+
+    //! Largest deviation
+    double m_dMaxDeviation = 0;
+
+    //! Reference distance
+    QVector<double> m_vReferenceDistance;
+
+    //! Reference latitude
+    QVector<double> m_vReferenceLatitude;
+
+    //! Reference longitude
+    QVector<double> m_vReferenceLongitude;
+
+    //! Reference heading
+    QVector<double> m_vReferenceHeading;
+
+    //! Reference segment done flag
+    QVector<uchar> m_vReferenceDone;
+};
+}
+
+#endif // FLEETKINEMATICS_H
@@ -0,0 +1,207 @@
+// Qt
+#include <QtMath>
+
+// Application
+#include "fleetstate.h"
+#include "geoutils.h"
+#define MIN_SEGMENT_LENGTH 1e-3
+#define HANDLE_SLOT_BITS 20 // Slot part of a handle, generation modulo 2^11 in the other bits
+#define HANDLE_GENERATION_MASK 0x7ff
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+FleetState::FleetState()
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+FleetState::~FleetState()
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int FleetState::allocateSlot(const QString &sDroneUID, const QString &sVideoUrl, const QGeoCoordinate &initialPos)
+{
+    int iSlot = 0;
+    if (!m_vFreeSlots.isEmpty())
+    {
+        iSlot = m_vFreeSlots.takeLast();
+    }
+    else
+    {
+        iSlot = slotCount();
+        m_vLatitude << 0;
+        m_vLongitude << 0;
+        m_vAltitude << 0;
+        m_vHeading << 0;
+        m_vBatteryLevel << 0;
+        m_vReturnLevel << 0;
+        m_vPathCursor << 0;
+        m_vPathDistance << 0;
+        m_vSegmentStartLatitude << 0;
+        m_vSegmentStartLongitude << 0;
+        m_vSegmentDeltaLatitude << 0;
+        m_vSegmentDeltaLongitude << 0;
+        m_vSegmentLength << 1;
+        m_vSegmentDistance << 0;
+        m_vSegmentHeading << 0;
+        m_vSpeed << 0;
+        m_vSegmentDone << 0;
+        m_vFlightStatus << SpyCore::IDLE;
+        m_vActive << 0;
+        m_vGeneration << 0;
+        m_vDroneUID << QString();
+        m_vVideoUrl << QString();
+    }
+
+    setPosition(iSlot, initialPos);
+    m_vHeading[iSlot] = 0;
+    m_vBatteryLevel[iSlot] = 0;
+    m_vReturnLevel[iSlot] = 0;
+    m_vPathCursor[iSlot] = 0;
+    m_vPathDistance[iSlot] = 0;
+    holdPosition(iSlot);
+    m_vFlightStatus[iSlot] = SpyCore::IDLE;
+    m_vActive[iSlot] = 1;
+    m_vDroneUID[iSlot] = sDroneUID;
+    m_vVideoUrl[iSlot] = sVideoUrl;
+    return iSlot;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetState::releaseSlot(int iSlot)
+{
+    if ((iSlot >= 0) && (iSlot < slotCount()) && isActive(iSlot))
+    {
+        m_vActive[iSlot] = 0;
+        m_vGeneration[iSlot] = (m_vGeneration[iSlot]+1) & HANDLE_GENERATION_MASK;
+        holdPosition(iSlot);
+        m_vFlightStatus[iSlot] = SpyCore::IDLE;
+        m_vDroneUID[iSlot].clear();
+        m_vVideoUrl[iSlot].clear();
+        m_vFreeSlots << iSlot;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetState::reserve(int iCount)
+{
+    m_vLatitude.reserve(iCount);
+    m_vLongitude.reserve(iCount);
+    m_vAltitude.reserve(iCount);
+    m_vHeading.reserve(iCount);
+    m_vBatteryLevel.reserve(iCount);
+    m_vReturnLevel.reserve(iCount);
+    m_vPathCursor.reserve(iCount);
+    m_vPathDistance.reserve(iCount);
+    m_vSegmentStartLatitude.reserve(iCount);
+    m_vSegmentStartLongitude.reserve(iCount);
+    m_vSegmentDeltaLatitude.reserve(iCount);
+    m_vSegmentDeltaLongitude.reserve(iCount);
+    m_vSegmentLength.reserve(iCount);
+    m_vSegmentDistance.reserve(iCount);
+    m_vSegmentHeading.reserve(iCount);
+    m_vSpeed.reserve(iCount);
+    m_vSegmentDone.reserve(iCount);
+    m_vFlightStatus.reserve(iCount);
+    m_vActive.reserve(iCount);
+    m_vGeneration.reserve(iCount);
+    m_vDroneUID.reserve(iCount);
+    m_vVideoUrl.reserve(iCount);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int FleetState::handle(int iSlot) const
+{
+    if ((iSlot < 0) || (iSlot >= (1 << HANDLE_SLOT_BITS)))
+        return -1;
+    return (m_vGeneration[iSlot] << HANDLE_SLOT_BITS) | iSlot;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int FleetState::slot(int iHandle) const
+{
+    if (iHandle < 0)
+        return -1;
+    int iSlot = iHandle & ((1 << HANDLE_SLOT_BITS)-1);
+    if ((iSlot >= slotCount()) || !isActive(iSlot) || ((iHandle >> HANDLE_SLOT_BITS) != m_vGeneration[iSlot]))
+        return -1;
+    return iSlot;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetState::setSegment(int iSlot, const GeoPoint &start, const GeoPoint &end, double dLength, double dSpeed, double dHeading)
+{
+    m_vSegmentStartLatitude[iSlot] = start.dLatitude;
+    m_vSegmentStartLongitude[iSlot] = start.dLongitude;
+    m_vSegmentDeltaLatitude[iSlot] = end.dLatitude-start.dLatitude;
+    m_vSegmentDeltaLongitude[iSlot] = GeoUtils::wrapLongitude(end.dLongitude-start.dLongitude); // Across the antimeridian, not around the globe
+
+    // Zero length segments are done on next step (no division by zero in the kernel)
+    m_vSegmentLength[iSlot] = qMax(dLength, MIN_SEGMENT_LENGTH);
+    m_vSegmentDistance[iSlot] = 0;
+    m_vSegmentHeading[iSlot] = dHeading;
+    m_vSpeed[iSlot] = qMax(0., dSpeed);
+    m_vSegmentDone[iSlot] = 0;
+    if (!qIsNaN(end.dAltitude))
+        m_vAltitude[iSlot] = end.dAltitude;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetState::velocity(int iSlot, double &dNorth, double &dEast) const
+{
+    dNorth = 0;
+    dEast = 0;
+    if ((m_vFlightStatus[iSlot] != SpyCore::FLYING) || m_vSegmentDone[iSlot])
+        return;
+    double dHeading = qDegreesToRadians(m_vSegmentHeading[iSlot]);
+    dNorth = m_vSpeed[iSlot]*qCos(dHeading);
+    dEast = m_vSpeed[iSlot]*qSin(dHeading);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FleetState::holdPosition(int iSlot)
+{
+    m_vSegmentStartLatitude[iSlot] = m_vLatitude[iSlot];
+    m_vSegmentStartLongitude[iSlot] = m_vLongitude[iSlot];
+    m_vSegmentDeltaLatitude[iSlot] = 0;
+    m_vSegmentDeltaLongitude[iSlot] = 0;
+    m_vSegmentLength[iSlot] = 1;
+    m_vSegmentDistance[iSlot] = 0;
+    m_vSegmentHeading[iSlot] = m_vHeading[iSlot];
+    m_vSpeed[iSlot] = 0;
+    m_vSegmentDone[iSlot] = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+Kinematics::SegmentBatch FleetState::segmentBatch()
+{
+    Kinematics::SegmentBatch batch;
+    batch.pStartLatitude = m_vSegmentStartLatitude.constData();
+    batch.pStartLongitude = m_vSegmentStartLongitude.constData();
+    batch.pDeltaLatitude = m_vSegmentDeltaLatitude.constData();
+    batch.pDeltaLongitude = m_vSegmentDeltaLongitude.constData();
+    batch.pLength = m_vSegmentLength.constData();
+    batch.pSpeed = m_vSpeed.constData();
+    batch.pSegmentHeading = m_vSegmentHeading.constData();
+    batch.pDistance = m_vSegmentDistance.data();
+    batch.pLatitude = m_vLatitude.data();
+    batch.pLongitude = m_vLongitude.data();
+    batch.pHeading = m_vHeading.data();
+    batch.pSegmentDone = m_vSegmentDone.data();
+    batch.iCount = slotCount();
+    return batch;
+}
@@ -0,0 +1,250 @@
+#ifndef FLEETSTATE_H
+#define FLEETSTATE_H
+
+// Qt
+#include <QVector>
+#include <QString>
+#include <QGeoCoordinate>
+
+// Application
+#include "kinematicskernel.h"
+#include "geopoint.h"
+#include "spycore.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class SPYCLIBSHARED_EXPORT FleetState
+{
+public:
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor
+    FleetState();
+
+    //! Destructor
+    ~FleetState();
+
+    //-------------------------------------------------------------------------------------------------
+    // Slots
+    //-------------------------------------------------------------------------------------------------
+
+    //! Allocate a drone slot
+    int allocateSlot(const QString &sDroneUID, const QString &sVideoUrl, const QGeoCoordinate &initialPos);
+
+    //! Release a drone slot (will be reused)
+    void releaseSlot(int iSlot);
+
+    //! Return number of slots (active or not): arrays below have this size
+    int slotCount() const { return m_vLatitude.size(); }
+
+    //! Return number of active slots
+    int activeCount() const { return slotCount()-m_vFreeSlots.size(); }
+
+    //! Reserve room for iCount drones
+    void reserve(int iCount);
+
+    //! Return handle of a slot (slot and reuse generation, -1 beyond 2^20 slots)
+    int handle(int iSlot) const;
+
+    //! Return slot addressed by a handle (-1 if out of range or if the slot was released since)
+    int slot(int iHandle) const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Per drone access
+    //-------------------------------------------------------------------------------------------------
+
+    //! Is slot active?
+    bool isActive(int iSlot) const { return m_vActive[iSlot] != 0; }
+
+    //! Position
+    QGeoCoordinate position(int iSlot) const { return QGeoCoordinate(m_vLatitude[iSlot], m_vLongitude[iSlot], m_vAltitude[iSlot]); }
+
+    //! Set position
+    void setPosition(int iSlot, const QGeoCoordinate &position) { setPosition(iSlot, GeoPoint(position)); }
+
+    //! Position (internal)
+    GeoPoint point(int iSlot) const { return GeoPoint(m_vLatitude[iSlot], m_vLongitude[iSlot], m_vAltitude[iSlot]); }
+
+    //! Set position (internal)
+    void setPosition(int iSlot, const GeoPoint &position) { m_vLatitude[iSlot] = position.dLatitude; m_vLongitude[iSlot] = position.dLongitude; m_vAltitude[iSlot] = position.dAltitude; }
+
+    //! Latitude
+    double &latitude(int iSlot) { return m_vLatitude[iSlot]; }
+    double latitude(int iSlot) const { return m_vLatitude[iSlot]; }
+
+    //! Longitude
+    double &longitude(int iSlot) { return m_vLongitude[iSlot]; }
+    double longitude(int iSlot) const { return m_vLongitude[iSlot]; }
+
+    //! Altitude
+    double &altitude(int iSlot) { return m_vAltitude[iSlot]; }
+    double altitude(int iSlot) const { return m_vAltitude[iSlot]; }
+
+    //! Heading
+    double &heading(int iSlot) { return m_vHeading[iSlot]; }
+    double heading(int iSlot) const { return m_vHeading[iSlot]; }
+
+    //! Battery level
+    int &batteryLevel(int iSlot) { return m_vBatteryLevel[iSlot]; }
+    int batteryLevel(int iSlot) const { return m_vBatteryLevel[iSlot]; }
+
+    //! Return level
+    int &returnLevel(int iSlot) { return m_vReturnLevel[iSlot]; }
+    int returnLevel(int iSlot) const { return m_vReturnLevel[iSlot]; }
+
+    //! Path cursor (current leg of the flight path)
+    int &pathCursor(int iSlot) { return m_vPathCursor[iSlot]; }
+    int pathCursor(int iSlot) const { return m_vPathCursor[iSlot]; }
+
+    //! Distance flown from flight path start to current segment start (m)
+    double &pathDistance(int iSlot) { return m_vPathDistance[iSlot]; }
+    double pathDistance(int iSlot) const { return m_vPathDistance[iSlot]; }
+
+    //! Distance flown along flight path since its start (m, wrapped around path length)
+    double pathProgress(int iSlot) const { return m_vPathDistance[iSlot]+m_vSegmentDistance[iSlot]; }
+
+    //! Flight status
+    SpyCore::FlightStatus flightStatus(int iSlot) const { return m_vFlightStatus[iSlot]; }
+    void setFlightStatus(int iSlot, SpyCore::FlightStatus eFlightStatus) { m_vFlightStatus[iSlot] = eFlightStatus; }
+
+    //! Distance flown along current segment (m)
+    double &segmentDistance(int iSlot) { return m_vSegmentDistance[iSlot]; }
+    double segmentDistance(int iSlot) const { return m_vSegmentDistance[iSlot]; }
+
+    //! Current segment length (m)
+    double segmentLength(int iSlot) const { return m_vSegmentLength[iSlot]; }
+
+    //! Speed along current segment (m/s)
+    double speed(int iSlot) const { return m_vSpeed[iSlot]; }
+
+    //! Velocity (m/s, zero unless flying)
+    void velocity(int iSlot, double &dNorth, double &dEast) const;
+
+    //! Fly dLength m from start to end at dSpeed m/s (position is updated by the kinematics kernel)
+    void setSegment(int iSlot, const GeoPoint &start, const GeoPoint &end, double dLength, double dSpeed, double dHeading);
+
+    //! Hold drone at its current position
+    void holdPosition(int iSlot);
+
+    //! UID
+    const QString &uid(int iSlot) const { return m_vDroneUID[iSlot]; }
+
+    //! Video url
+    const QString &videoUrl(int iSlot) const { return m_vVideoUrl[iSlot]; }
+
+    //-------------------------------------------------------------------------------------------------
+    // Whole fleet access (contiguous, indexed by slot)
+    //-------------------------------------------------------------------------------------------------
+
+    //! Latitudes
+    double *latitudes() { return m_vLatitude.data(); }
+    const double *latitudes() const { return m_vLatitude.constData(); }
+
+    //! Longitudes
+    double *longitudes() { return m_vLongitude.data(); }
+    const double *longitudes() const { return m_vLongitude.constData(); }
+
+    //! Altitudes
+    double *altitudes() { return m_vAltitude.data(); }
+    const double *altitudes() const { return m_vAltitude.constData(); }
+
+    //! Headings
+    double *headings() { return m_vHeading.data(); }
+    const double *headings() const { return m_vHeading.constData(); }
+
+    //! Battery levels
+    int *batteryLevels() { return m_vBatteryLevel.data(); }
+    const int *batteryLevels() const { return m_vBatteryLevel.constData(); }
+
+    //! Return levels
+    int *returnLevels() { return m_vReturnLevel.data(); }
+    const int *returnLevels() const { return m_vReturnLevel.constData(); }
+
+    //! Path cursors
+    int *pathCursors() { return m_vPathCursor.data(); }
+    const int *pathCursors() const { return m_vPathCursor.constData(); }
+
+    //! Active flags
+    const uchar *activeFlags() const { return m_vActive.constData(); }
+
+    //! Segment done flags (set by the kinematics kernel)
+    const uchar *segmentDoneFlags() const { return m_vSegmentDone.constData(); }
+
+    //! Segment columns for the kinematics kernel
+    Kinematics::SegmentBatch segmentBatch();
+
+private:
+    //! Latitude
+    QVector<double> m_vLatitude;
+
+    //! Longitude
+    QVector<double> m_vLongitude;
+
+    //! Altitude
+    QVector<double> m_vAltitude;
+
+    //! Heading
+    QVector<double> m_vHeading;
+
+    //! Battery level
+    QVector<int> m_vBatteryLevel;
+
+    //! Return level
+    QVector<int> m_vReturnLevel;
+
+    //! Path cursor
+    QVector<int> m_vPathCursor;
+
+    //! Path distance
+    QVector<double> m_vPathDistance;
+
+    //! Segment start latitude
+    QVector<double> m_vSegmentStartLatitude;
+
+    //! Segment start longitude
+    QVector<double> m_vSegmentStartLongitude;
+
+    //! Segment latitude extent
+    QVector<double> m_vSegmentDeltaLatitude;
+
+    //! Segment longitude extent
+    QVector<double> m_vSegmentDeltaLongitude;
+
+    //! Segment length
+    QVector<double> m_vSegmentLength;
+
+    //! Distance flown along segment
+    QVector<double> m_vSegmentDistance;
+
+    //! Segment heading
+    QVector<double> m_vSegmentHeading;
+
+    //! Speed
+    QVector<double> m_vSpeed;
+
+    //! Segment done flag
+    QVector<uchar> m_vSegmentDone;
+
+    //! Flight status
+    QVector<SpyCore::FlightStatus> m_vFlightStatus;
+
+    //! Active flag
+    QVector<uchar> m_vActive;
+
+    //! Reuse generation (bumped on release: handles of released drones go stale)
+    QVector<int> m_vGeneration;
+
+    //! UID (cold)
+    QVector<QString> m_vDroneUID;
+
+    //! Video url (cold)
+    QVector<QString> m_vVideoUrl;
+
+    //! Free slots
+    QVector<int> m_vFreeSlots;
+};
+}
+
+#endif // FLEETSTATE_H
@@ -0,0 +1,427 @@
+// Qt
+#include <QtMath>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWeakPointer>
+#include <QStringList>
+#include <QVarLengthArray>
+#include <QPair>
+
+// Std
+#include <algorithm>
+
+// Application
+#include "flightpath.h"
+#include "flightsimulator.h"
+#include "energymodel.h"
+#include "geoutils.h"
+#include "messageschema.h"
+#define MIN_LEG_LENGTH 1e-3
+#define DEFAULT_PATTERN_RADIUS 100.
+#define MIN_PATTERN_RADIUS 1.
+#define MIN_COS_LATITUDE 1e-6
+#define MIN_SWEEP_SIZE 64 // Path cache entries
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+FlightPath::FlightPath()
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+FlightPath::FlightPath(const QVector<WayPoint> &vWayPoints)
+{
+    int iPathSize = vWayPoints.size();
+    if (iPathSize == 1)
+        appendPattern(vWayPoints.first(), 0);
+
+    // Leg to each way point, then its pattern. Path is flown in a loop, back to the first way point
+    for (int i=0; (iPathSize > 1) && (i<iPathSize); i++)
+    {
+        const WayPoint &fromWayPoint = vWayPoints[i];
+        const WayPoint &toWayPoint = vWayPoints[(i+1)%iPathSize];
+        appendLeg(fromWayPoint.point(), toWayPoint.point(), FlightSimulator::cruiseSpeed(fromWayPoint.speed()));
+        appendPattern(toWayPoint, GeoUtils::bearing(toWayPoint.point(), fromWayPoint.point())+180);
+    }
+    foreach (const Leg &leg, m_vLegs)
+        m_dDuration += leg.dLength/leg.dSpeed;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+FlightPath::~FlightPath()
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool FlightPath::isEmpty() const
+{
+    return m_vLegs.isEmpty();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double FlightPath::length() const
+{
+    return m_dLength;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int FlightPath::legCount() const
+{
+    return m_vLegs.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const FlightPath::Leg &FlightPath::leg(int iLeg) const
+{
+    return m_vLegs[iLeg];
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int FlightPath::legAt(double dDistance) const
+{
+    // Last leg starting at or before dDistance
+    int iLow = 0;
+    int iHigh = m_vLegs.size()-1;
+    while (iLow < iHigh)
+    {
+        int iMiddle = (iLow+iHigh+1)/2;
+        if (m_vLegs[iMiddle].dStart <= dDistance)
+            iLow = iMiddle;
+        else
+            iHigh = iMiddle-1;
+    }
+    return iLow;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QGeoCoordinate FlightPath::positionAt(double dDistance, int iLeg) const
+{
+    return pointAt(dDistance, iLeg).toCoordinate();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QGeoCoordinate FlightPath::positionAt(double dDistance) const
+{
+    return pointAt(dDistance).toCoordinate();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+GeoPoint FlightPath::pointAt(double dDistance, int iLeg) const
+{
+    const Leg &leg = m_vLegs[iLeg];
+    if (leg.eType != SpyCore::POINT)
+        return patternPointAt(leg, dDistance-leg.dStart);
+    double dFraction = qBound(0., (dDistance-leg.dStart)/leg.dLength, 1.);
+
+    // Altitude
+    double dAltitude = leg.dFromAltitude;
+    if (qIsNaN(dAltitude))
+        dAltitude = leg.dToAltitude;
+    else
+    if (!qIsNaN(leg.dToAltitude))
+        dAltitude += (leg.dToAltitude-leg.dFromAltitude)*dFraction;
+
+    // Spherical linear interpolation (legs are never degenerate)
+    double dSinAngle = qSin(leg.dAngle);
+    double dA = qSin((1-dFraction)*leg.dAngle)/dSinAngle;
+    double dB = qSin(dFraction*leg.dAngle)/dSinAngle;
+    double dX = dA*leg.dFromX+dB*leg.dToX;
+    double dY = dA*leg.dFromY+dB*leg.dToY;
+    double dZ = dA*leg.dFromZ+dB*leg.dToZ;
+    return GeoPoint(qRadiansToDegrees(qAtan2(dZ, qSqrt(dX*dX+dY*dY))), qRadiansToDegrees(qAtan2(dY, dX)), dAltitude);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+GeoPoint FlightPath::pointAt(double dDistance) const
+{
+    if (m_vLegs.isEmpty())
+        return GeoPoint();
+    dDistance = fmod(dDistance, m_dLength);
+    if (dDistance < 0)
+        dDistance += m_dLength;
+    return pointAt(dDistance, legAt(dDistance));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double FlightPath::duration() const
+{
+    return m_dDuration;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double FlightPath::distanceAfter(double dDistance, double dSeconds) const
+{
+    if (m_vLegs.isEmpty() || (m_dDuration <= 0))
+        return 0;
+    dDistance = fmod(dDistance, m_dLength);
+    if (dDistance < 0)
+        dDistance += m_dLength;
+    dSeconds = fmod(qMax(dSeconds, 0.), m_dDuration);
+
+    // Whole legs first, then part of the last one
+    int iLeg = legAt(dDistance);
+    for (int i=0; i<=m_vLegs.size(); i++)
+    {
+        const Leg &leg = m_vLegs[iLeg];
+        double dLegEnd = leg.dStart+leg.dLength;
+        double dLegSeconds = qMax(dLegEnd-dDistance, 0.)/leg.dSpeed;
+        if (dSeconds < dLegSeconds)
+            return dDistance+dSeconds*leg.dSpeed;
+        dSeconds -= dLegSeconds;
+        iLeg = (iLeg+1)%m_vLegs.size();
+        dDistance = m_vLegs[iLeg].dStart;
+    }
+    return dDistance;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double FlightPath::energy() const
+{
+    return m_dEnergy;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double FlightPath::energyAt(double dDistance, int iLeg) const
+{
+    const Leg &leg = m_vLegs[iLeg];
+    return leg.dEnergyStart+qBound(0., dDistance-leg.dStart, leg.dLength)*leg.dEnergyPerMeter;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FlightPath::appendLeg(const GeoPoint &from, const GeoPoint &to, double dSpeed)
+{
+    double dLength = GeoUtils::distance(from, to);
+    if (dLength < MIN_LEG_LENGTH)
+        return;
+
+    Leg leg;
+    double dFromLatitude = qDegreesToRadians(from.dLatitude);
+    double dFromLongitude = qDegreesToRadians(from.dLongitude);
+    double dToLatitude = qDegreesToRadians(to.dLatitude);
+    double dToLongitude = qDegreesToRadians(to.dLongitude);
+    leg.dFromX = qCos(dFromLatitude)*qCos(dFromLongitude);
+    leg.dFromY = qCos(dFromLatitude)*qSin(dFromLongitude);
+    leg.dFromZ = qSin(dFromLatitude);
+    leg.dToX = qCos(dToLatitude)*qCos(dToLongitude);
+    leg.dToY = qCos(dToLatitude)*qSin(dToLongitude);
+    leg.dToZ = qSin(dToLatitude);
+    leg.dFromAltitude = from.dAltitude;
+    leg.dToAltitude = to.dAltitude;
+    leg.dAngle = dLength/EARTH_RADIUS;
+    leg.dStart = m_dLength;
+    leg.dLength = dLength;
+    leg.dSpeed = dSpeed;
+    leg.dEnergyStart = m_dEnergy;
+    leg.dEnergyPerMeter = Energy::perMeter(dSpeed);
+    m_vLegs << leg;
+    m_dLength += dLength;
+    m_dEnergy += dLength*leg.dEnergyPerMeter;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FlightPath::appendPattern(const WayPoint &wayPoint, double dArrivalHeading)
+{
+    if (wayPoint.type() == SpyCore::POINT)
+        return;
+
+    // Parameters from metadata: pattern is oriented along arrival heading unless told otherwise
+    static const int iRadiusKey = WayPoint::metaDataKey(Schema::WayPointMetaData::Radius::name());
+    static const int iLengthKey = WayPoint::metaDataKey(Schema::WayPointMetaData::Length::name());
+    static const int iTurnsKey = WayPoint::metaDataKey(Schema::WayPointMetaData::Turns::name());
+    static const int iOrientationKey = WayPoint::metaDataKey(Schema::WayPointMetaData::Orientation::name());
+    double dRadius = qMax(wayPoint.metaData(iRadiusKey, DEFAULT_PATTERN_RADIUS), MIN_PATTERN_RADIUS);
+    double dStraight = qMax(wayPoint.metaData(iLengthKey, 2*dRadius), 0.);
+    int iTurns = qMax(1, qRound(wayPoint.metaData(iTurnsKey, 1.)));
+    double dOrientation = wayPoint.metaData(iOrientationKey, dArrivalHeading);
+
+    Leg leg;
+    leg.eType = wayPoint.type();
+    leg.dFromAltitude = wayPoint.point().dAltitude;
+    leg.dToAltitude = wayPoint.point().dAltitude;
+    leg.dCenterLatitude = wayPoint.point().dLatitude;
+    leg.dCenterLongitude = wayPoint.point().dLongitude;
+    leg.dOrientation = qDegreesToRadians(dOrientation);
+    leg.dRadius = dRadius;
+    leg.dSide = wayPoint.clockWise() ? 1 : -1;
+    if (leg.eType == SpyCore::LOITER)
+        leg.dLap = 2*M_PI*dRadius;
+    else
+    if (leg.eType == SpyCore::EIGHT)
+        leg.dLap = 4*M_PI*dRadius;
+    else
+    {
+        leg.dStraight = dStraight;
+        leg.dLap = 2*dStraight+2*M_PI*dRadius;
+    }
+    leg.dStart = m_dLength;
+    leg.dLength = iTurns*leg.dLap;
+    leg.dSpeed = FlightSimulator::cruiseSpeed(wayPoint.speed());
+    leg.dEnergyStart = m_dEnergy;
+    leg.dEnergyPerMeter = Energy::perMeter(leg.dSpeed);
+    m_vLegs << leg;
+    m_dLength += leg.dLength;
+    m_dEnergy += leg.dLength*leg.dEnergyPerMeter;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+GeoPoint FlightPath::patternPointAt(const Leg &leg, double dOffset)
+{
+    // Laps start and end on the way point, heading along orientation
+    double dDistance = fmod(qMax(0., dOffset), leg.dLap);
+    double dForwardX = qSin(leg.dOrientation);
+    double dForwardY = qCos(leg.dOrientation);
+    double dSideX = leg.dSide*qCos(leg.dOrientation);
+    double dSideY = -leg.dSide*qSin(leg.dOrientation);
+    double dHalfTurn = M_PI*leg.dRadius;
+
+    // East, north offsets from way point (m)
+    double dX = 0;
+    double dY = 0;
+    if (leg.eType == SpyCore::LOITER)
+        addArc(dForwardX, dForwardY, dSideX, dSideY, leg.dRadius, dDistance, dX, dY);
+    else
+    if (leg.eType == SpyCore::EIGHT)
+    {
+        // One circle on each side of the way point
+        if (dDistance < 2*dHalfTurn)
+            addArc(dForwardX, dForwardY, dSideX, dSideY, leg.dRadius, dDistance, dX, dY);
+        else
+            addArc(dForwardX, dForwardY, -dSideX, -dSideY, leg.dRadius, dDistance-2*dHalfTurn, dX, dY);
+    }
+    else
+    {
+        // Straight, half turn, straight back, half turn
+        double dStraight = leg.dStraight;
+        if (dDistance < dStraight)
+        {
+            dX = dForwardX*dDistance;
+            dY = dForwardY*dDistance;
+        }
+        else
+        if (dDistance < dStraight+dHalfTurn)
+        {
+            dX = dForwardX*dStraight;
+            dY = dForwardY*dStraight;
+            addArc(dForwardX, dForwardY, dSideX, dSideY, leg.dRadius, dDistance-dStraight, dX, dY);
+        }
+        else
+        if (dDistance < 2*dStraight+dHalfTurn)
+        {
+            double dBack = dDistance-dStraight-dHalfTurn;
+            dX = dForwardX*(dStraight-dBack)+2*leg.dRadius*dSideX;
+            dY = dForwardY*(dStraight-dBack)+2*leg.dRadius*dSideY;
+        }
+        else
+        {
+            dX = 2*leg.dRadius*dSideX;
+            dY = 2*leg.dRadius*dSideY;
+            addArc(-dForwardX, -dForwardY, -dSideX, -dSideY, leg.dRadius, dDistance-2*dStraight-dHalfTurn, dX, dY);
+        }
+    }
+
+    // Local tangent plane to geographic
+    double dCosLatitude = qMax(qCos(qDegreesToRadians(leg.dCenterLatitude)), MIN_COS_LATITUDE);
+    double dLatitude = leg.dCenterLatitude+qRadiansToDegrees(dY/EARTH_RADIUS);
+    double dLongitude = leg.dCenterLongitude+qRadiansToDegrees(dX/(EARTH_RADIUS*dCosLatitude));
+    return GeoPoint(dLatitude, dLongitude, leg.dFromAltitude);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FlightPath::addArc(double dForwardX, double dForwardY, double dSideX, double dSideY, double dRadius, double dDistance, double &dX, double &dY)
+{
+    double dAngle = dDistance/dRadius;
+    double dSideOffset = dRadius*(1-qCos(dAngle));
+    double dForwardOffset = dRadius*qSin(dAngle);
+    dX += dSideX*dSideOffset+dForwardX*dForwardOffset;
+    dY += dSideY*dSideOffset+dForwardY*dForwardOffset;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QByteArray FlightPath::cacheKey(const QVector<WayPoint> &vWayPoints)
+{
+    // Everything that shapes the path, byte for byte
+    QByteArray baKey;
+    foreach (const WayPoint &wayPoint, vWayPoints)
+    {
+        double vValues[] = {wayPoint.point().dLatitude, wayPoint.point().dLongitude, wayPoint.point().dAltitude};
+        int vFlags[] = {wayPoint.speed(), (int)wayPoint.type(), (int)wayPoint.clockWise()};
+        baKey.append(reinterpret_cast<const char *>(vValues), sizeof(vValues));
+        baKey.append(reinterpret_cast<const char *>(vFlags), sizeof(vFlags));
+
+        // Metadata by interned key, whatever order it was set in
+        QVarLengthArray<QPair<int, double>, WAYPOINT_INLINE_METADATA> vMetaData;
+        for (int i=0; i<wayPoint.metaDataCount(); i++)
+            vMetaData.append(qMakePair(wayPoint.metaDataKeyAt(i), wayPoint.metaDataValueAt(i)));
+        std::sort(vMetaData.begin(), vMetaData.end());
+        for (int i=0; i<vMetaData.size(); i++)
+        {
+            baKey.append(reinterpret_cast<const char *>(&vMetaData[i].first), sizeof(int));
+            baKey.append(reinterpret_cast<const char *>(&vMetaData[i].second), sizeof(double));
+        }
+    }
+    return baKey;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QSharedPointer<const FlightPath> FlightPath::shared(const QVector<WayPoint> &vWayPoints)
+{
+    // Paths live as long as a drone flies them
+    static QMutex mutex;
+    static QHash<QByteArray, QWeakPointer<const FlightPath> > hCache;
+    static int iSweepSize = MIN_SWEEP_SIZE;
+
+    QByteArray baKey = cacheKey(vWayPoints);
+    {
+        QMutexLocker locker(&mutex);
+        QSharedPointer<const FlightPath> pPath = hCache.value(baKey).toStrongRef();
+        if (!pPath.isNull())
+            return pPath;
+    }
+
+    // Computed outside the lock: a fleet spawned in parallel builds its paths concurrently
+    QSharedPointer<const FlightPath> pNewPath(new FlightPath(vWayPoints));
+    QMutexLocker locker(&mutex);
+    QSharedPointer<const FlightPath> pPath = hCache.value(baKey).toStrongRef();
+    if (!pPath.isNull())
+        return pPath;
+
+    // Drop paths nobody flies anymore (once the cache doubled, so that filling it stays linear)
+    if (hCache.size() >= iSweepSize)
+    {
+        for (QHash<QByteArray, QWeakPointer<const FlightPath> >::iterator it = hCache.begin(); it != hCache.end(); )
+        {
+            if (it->isNull())
+                it = hCache.erase(it);
+            else
+                ++it;
+        }
+        iSweepSize = qMax(2*hCache.size(), MIN_SWEEP_SIZE);
+    }
+    hCache[baKey] = pNewPath;
+    return pNewPath;
+}
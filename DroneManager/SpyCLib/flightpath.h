@@ -0,0 +1,171 @@
+#ifndef FLIGHTPATH_H
+#define FLIGHTPATH_H
+
+// Qt
+#include <QVector>
+#include <QGeoCoordinate>
+#include <QSharedPointer>
+
+// Application
+#include "waypoint.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class SPYCLIBSHARED_EXPORT FlightPath
+{
+public:
+    //! Path leg: great circle arc or pattern flown around a way point, evaluated on demand
+    struct Leg
+    {
+        //! Type (POINT: great circle arc, LOITER, EIGHT, HIPPODROM: pattern)
+        SpyCore::PointType eType = SpyCore::POINT;
+
+        //! Start unit vector (earth centered)
+        double dFromX = 0;
+        double dFromY = 0;
+        double dFromZ = 0;
+
+        //! End unit vector (earth centered)
+        double dToX = 0;
+        double dToY = 0;
+        double dToZ = 0;
+
+        //! Start altitude (NaN if unknown)
+        double dFromAltitude = 0;
+
+        //! End altitude (NaN if unknown)
+        double dToAltitude = 0;
+
+        //! Angle between start and end seen from the earth center (rad)
+        double dAngle = 0;
+
+        //! Distance from path start to leg start (m)
+        double dStart = 0;
+
+        //! Length (m)
+        double dLength = 0;
+
+        //! Cruise speed (m/s)
+        double dSpeed = 0;
+
+        //! Energy spent from path start to leg start (battery %)
+        double dEnergyStart = 0;
+
+        //! Energy spent per meter on this leg (battery %/m)
+        double dEnergyPerMeter = 0;
+
+        //! Pattern center (deg)
+        double dCenterLatitude = 0;
+        double dCenterLongitude = 0;
+
+        //! Pattern orientation (rad, clockwise from north)
+        double dOrientation = 0;
+
+        //! Pattern turn radius (m)
+        double dRadius = 0;
+
+        //! Hippodrome straight length (m)
+        double dStraight = 0;
+
+        //! Pattern lap length (m)
+        double dLap = 0;
+
+        //! Pattern turn side (1: clockwise, -1: counterclockwise)
+        double dSide = 1;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor
+    FlightPath();
+
+    //! Constructor (closed loop through way points)
+    FlightPath(const QVector<WayPoint> &vWayPoints);
+
+    //! Destructor
+    ~FlightPath();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Return true if there is nothing to fly
+    bool isEmpty() const;
+
+    //! Return length (m)
+    double length() const;
+
+    //! Return leg count
+    int legCount() const;
+
+    //! Return leg
+    const Leg &leg(int iLeg) const;
+
+    //! Return leg containing dDistance (0 <= dDistance < length())
+    int legAt(double dDistance) const;
+
+    //! Return position at dDistance, on leg iLeg
+    QGeoCoordinate positionAt(double dDistance, int iLeg) const;
+
+    //! Return position at dDistance (wrapped around path length)
+    QGeoCoordinate positionAt(double dDistance) const;
+
+    //! Return position at dDistance, on leg iLeg (internal)
+    GeoPoint pointAt(double dDistance, int iLeg) const;
+
+    //! Return position at dDistance (wrapped around path length, internal)
+    GeoPoint pointAt(double dDistance) const;
+
+    //! Return time to fly the whole path once at leg cruise speeds (s)
+    double duration() const;
+
+    //! Return distance reached flying dSeconds from dDistance at leg cruise speeds (wrapped around path length)
+    double distanceAfter(double dDistance, double dSeconds) const;
+
+    //! Return energy spent flying the whole path once (battery %)
+    double energy() const;
+
+    //! Return energy spent from path start to dDistance, on leg iLeg (battery %)
+    double energyAt(double dDistance, int iLeg) const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Cache
+    //-------------------------------------------------------------------------------------------------
+
+    //! Return path for way points (shared by every drone flying the same plan)
+    static QSharedPointer<const FlightPath> shared(const QVector<WayPoint> &vWayPoints);
+
+private:
+    //! Append great circle leg
+    void appendLeg(const GeoPoint &from, const GeoPoint &to, double dSpeed);
+
+    //! Append pattern of a LOITER, EIGHT or HIPPODROM way point (reached with heading dArrivalHeading)
+    void appendPattern(const WayPoint &wayPoint, double dArrivalHeading);
+
+    //! Return position dOffset m into pattern leg
+    static GeoPoint patternPointAt(const Leg &leg, double dOffset);
+
+    //! Add to (dX, dY) the offset after dDistance m on a circle entered with heading forward, turning towards side
+    static void addArc(double dForwardX, double dForwardY, double dSideX, double dSideY, double dRadius, double dDistance, double &dX, double &dY);
+
+    //! Return cache key for way points
+    static QByteArray cacheKey(const QVector<WayPoint> &vWayPoints);
+
+private:
+    //! Legs
+    QVector<Leg> m_vLegs;
+
+    //! Length
+    double m_dLength = 0;
+
+    //! Energy (prefix sum of leg energies)
+    double m_dEnergy = 0;
+
+    //! Duration (s)
+    double m_dDuration = 0;
+};
+}
+
+#endif // FLIGHTPATH_H
@@ -1,74 +1,176 @@
 // Qt
 #include <QDebug>
+#include <QtMath>
 
 // Application
 #include "flightsimulator.h"
+#include "fleetkinematics.h"
+#include "flightpath.h"
+#include "geoutils.h"
 #include "waypoint.h"
+#include "terraincache.h"
+#define ECO_SPEED 10.
+#define OBSERVATION_SPEED 5.
+#define FAST_SPEED 20.
+#define SAMPLE_INTERVAL 1.
+#define LEG_END_TOLERANCE 1e-6
+#define MAX_SEGMENTS_PER_STEP 64
 using namespace Core;
 
 //-------------------------------------------------------------------------------------------------
 
-FlightSimulator::FlightSimulator(QObject *pParent) : BaseSimulator(pParent)
+FlightSimulator::FlightSimulator(SimulationScheduler *pScheduler, FleetState *pFleetState, FleetKinematics *pKinematics, int iSlot, SimulatorObserver *pObserver) : BaseSimulator(0, pScheduler, pFleetState, iSlot, pObserver),
+    m_pKinematics(pKinematics)
 {
-    m_timer.setInterval(100);
-    connect(&m_timer, &QTimer::timeout, this, &FlightSimulator::onTimeOut, Qt::QueuedConnection);
+    m_pKinematics->setSimulator(m_iSlot, this);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 FlightSimulator::~FlightSimulator()
 {
-
+    m_pKinematics->setSimulator(m_iSlot, nullptr);
+    m_pFleetState->holdPosition(m_iSlot);
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void FlightSimulator::computeFlightPath(const QVector<WayPoint> &geoPath, int iPointCount)
+double FlightSimulator::cruiseSpeed(int iSpeed)
 {
-    m_iPointIndex++;
-    m_vDetailedPath.clear();
-    m_vHeading.clear();
-    int iPathSize = geoPath.size();
-    for (int i=0; i<iPathSize-1; i++)
+    switch (iSpeed)
     {
-        QGeoCoordinate firstCoord = geoPath[i].geoCoord();
-        QGeoCoordinate secondCoord = geoPath[i+1].geoCoord();
-        double m = (secondCoord.longitude()-firstCoord.longitude())/(secondCoord.latitude()-firstCoord.latitude());
-        double p = firstCoord.longitude()-m*firstCoord.latitude();
-        double dStep = (secondCoord.latitude()-firstCoord.latitude())/iPointCount;
-        double dHeading = atan2(firstCoord.longitude() - secondCoord.longitude(), firstCoord.latitude() - secondCoord.latitude());
-
-        for (int j=0; j<iPointCount; j++)
-        {
-            double dLatitude = geoPath[i].geoCoord().latitude()+j*dStep;
-            double dLongitude = m*dLatitude+p;
-            m_vDetailedPath << QGeoCoordinate(dLatitude, dLongitude);
-            m_vHeading << dHeading*180/M_PI+180;
-        }
+    case SpyCore::OBSERVATION:
+        return OBSERVATION_SPEED;
+    case SpyCore::FAST:
+        return FAST_SPEED;
+    default:
+        return ECO_SPEED;
     }
 }
 
 //-------------------------------------------------------------------------------------------------
 
+void FlightSimulator::setTerrain(TerrainCache *pTerrain, double dClearance)
+{
+    m_pTerrain = pTerrain;
+    m_dTerrainClearance = qMax(dClearance, 0.);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FlightSimulator::computeFlightPath(const QVector<WayPoint> &geoPath)
+{
+    m_pFlightPath = FlightPath::shared(geoPath);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QSharedPointer<const FlightPath> FlightSimulator::flightPath() const
+{
+    return m_pFlightPath;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 void FlightSimulator::start()
 {
-    m_iPointIndex = 0;
-    m_timer.start();
+    m_pFleetState->pathCursor(m_iSlot) = 0;
+    m_pFleetState->pathDistance(m_iSlot) = 0;
+    if (m_pFlightPath.isNull() || m_pFlightPath->isEmpty())
+    {
+        m_pFleetState->holdPosition(m_iSlot);
+        return;
+    }
+    m_pFleetState->setPosition(m_iSlot, aboveTerrain(m_pFlightPath->pointAt(0, 0)));
+    loadSegment();
+    BaseSimulator::start();
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void FlightSimulator::onTimeOut()
+void FlightSimulator::loadSegment()
 {
-    int iActualIndex = m_iPointIndex%m_vDetailedPath.size();
-    emit positionChanged(m_vDetailedPath[iActualIndex], m_vHeading[iActualIndex]);
-    m_iPointIndex++;
+    // Short chord of the current leg: the kernel interpolates it linearly
+    int iLeg = m_pFleetState->pathCursor(m_iSlot);
+    const FlightPath::Leg &leg = m_pFlightPath->leg(iLeg);
+    double dFrom = m_pFleetState->pathDistance(m_iSlot);
+    double dTo = qMin(dFrom+leg.dSpeed*SAMPLE_INTERVAL, leg.dStart+leg.dLength);
+    GeoPoint from = aboveTerrain(m_pFlightPath->pointAt(dFrom, iLeg));
+    GeoPoint to = aboveTerrain(m_pFlightPath->pointAt(dTo, iLeg));
+    m_pFleetState->setSegment(m_iSlot, from, to, dTo-dFrom, leg.dSpeed, GeoUtils::bearing(from, to));
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void FlightSimulator::stop()
+void FlightSimulator::advance(double dLength)
+{
+    int &iLeg = m_pFleetState->pathCursor(m_iSlot);
+    double &dPathDistance = m_pFleetState->pathDistance(m_iSlot);
+    const FlightPath::Leg &leg = m_pFlightPath->leg(iLeg);
+    dPathDistance += dLength;
+    if (dPathDistance >= leg.dStart+leg.dLength-LEG_END_TOLERANCE)
+    {
+        // Path is flown in a loop
+        iLeg = (iLeg+1)%m_pFlightPath->legCount();
+        dPathDistance = m_pFlightPath->leg(iLeg).dStart;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+GeoPoint FlightSimulator::aboveTerrain(const GeoPoint &position) const
 {
-    m_timer.stop();
+    if (m_pTerrain == nullptr)
+        return position;
+    double dGround = m_pTerrain->elevation(position.dLatitude, position.dLongitude);
+    if (qIsNaN(dGround))
+        return position;
+
+    // Unknown altitude: fly at the clearance
+    GeoPoint raised(position);
+    double dFloor = dGround+m_dTerrainClearance;
+    if (qIsNaN(position.dAltitude) || (position.dAltitude < dFloor))
+        raised.dAltitude = dFloor;
+    return raised;
 }
 
+//-------------------------------------------------------------------------------------------------
+
+void FlightSimulator::onSegmentDone()
+{
+    if (m_pFlightPath.isNull() || m_pFlightPath->isEmpty())
+    {
+        m_pFleetState->holdPosition(m_iSlot);
+        return;
+    }
+
+    // Carry distance flown past the end of the segment over the next ones
+    double dCarry = m_pFleetState->segmentDistance(m_iSlot);
+    int iSegmentCount = 0;
+    do
+    {
+        double dLength = m_pFleetState->segmentLength(m_iSlot);
+        dCarry -= dLength;
+        advance(dLength);
+        loadSegment();
+        iSegmentCount++;
+    }
+    while ((dCarry >= m_pFleetState->segmentLength(m_iSlot)) && (iSegmentCount < MAX_SEGMENTS_PER_STEP));
+    m_pFleetState->segmentDistance(m_iSlot) = qMin(dCarry, m_pFleetState->segmentLength(m_iSlot));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FlightSimulator::notifyPositionChanged()
+{
+    if (m_pObserver != nullptr)
+        m_pObserver->onPositionChanged(m_iSlot);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void FlightSimulator::stop()
+{
+    m_pFleetState->holdPosition(m_iSlot);
+    BaseSimulator::stop();
+}
@@ -2,11 +2,10 @@
 #define FLIGHTSIMULATOR_H
 
 // Qt
-#include <QObject>
 #include <QGeoCoordinate>
 #include <QGeoPath>
 #include <QVector>
-#include <QTimer>
+#include <QSharedPointer>
 
 // Application
 #include "basesimulator.h"
@@ -14,17 +13,18 @@
 #include "spyclib_global.h"
 
 namespace Core {
+class FleetKinematics;
+class FlightPath;
+class TerrainCache;
 class SPYCLIBSHARED_EXPORT FlightSimulator : public Core::BaseSimulator
 {
-    Q_OBJECT
-
 public:
     //-------------------------------------------------------------------------------------------------
     // Constructors and destructor
     //-------------------------------------------------------------------------------------------------
 
-    //! Constructor
-    FlightSimulator(QObject *pParent=nullptr);
+    //! Constructor (stepped by fleet kinematics)
+    FlightSimulator(SimulationScheduler *pScheduler, FleetState *pFleetState, FleetKinematics *pKinematics, int iSlot, SimulatorObserver *pObserver=nullptr);
 
     //! Destructor
     ~FlightSimulator();
@@ -33,8 +33,11 @@ public:
     // Control methods
     //-------------------------------------------------------------------------------------------------
 
-    //! Compute points
-    void computeFlightPath(const QVector<WayPoint> &geoPath, int iPointCount=100);
+    //! Compute flight path (great circle legs, shared with drones flying the same plan)
+    void computeFlightPath(const QVector<WayPoint> &geoPath);
+
+    //! Return flight path
+    QSharedPointer<const FlightPath> flightPath() const;
 
     //! Play
     virtual void start();
@@ -42,26 +45,40 @@ public:
     //! Stop
     virtual void stop();
 
+    //! End of current segment reached: move on to next ones (may run on a worker thread)
+    void onSegmentDone();
+
+    //! Notify observer of the new position (simulation thread, after kinematics step)
+    void notifyPositionChanged();
+
+    //! Follow terrain: keep at least dClearance m above ground (null: way point altitudes are flown as is)
+    void setTerrain(TerrainCache *pTerrain, double dClearance);
+
+    //! Return cruise speed (m/s) for a way point speed
+    static double cruiseSpeed(int iSpeed);
+
 private:
-    //! Detailed path
-    QVector<QGeoCoordinate> m_vDetailedPath;
+    //! Load next kinematics segment of current leg into fleet state
+    void loadSegment();
 
-    //! Heading
-    QVector<double> m_vHeading;
+    //! Move path distance dLength m forward (next leg if current one is done)
+    void advance(double dLength);
 
-    //! Timer
-    QTimer m_timer;
+    //! Return position raised to the terrain clearance if needed
+    GeoPoint aboveTerrain(const GeoPoint &position) const;
+
+private:
+    //! Fleet kinematics
+    FleetKinematics *m_pKinematics = nullptr;
 
-    //! Point index
-    int m_iPointIndex = 0;
+    //! Flight path
+    QSharedPointer<const FlightPath> m_pFlightPath;
 
-public slots:
-    //! Time out
-    void onTimeOut();
+    //! Terrain elevation
+    TerrainCache *m_pTerrain = nullptr;
 
-signals:
-    //! PositionChanged
-    void positionChanged(const QGeoCoordinate &geoCoord, double dHeading);
+    //! Terrain clearance (m)
+    double m_dTerrainClearance = 0;
 };
 }
 
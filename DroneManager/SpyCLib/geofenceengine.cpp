@@ -0,0 +1,335 @@
+// Qt
+#include <QtMath>
+#include <QGeoCircle>
+#include <QGeoRectangle>
+
+// Std
+#include <algorithm>
+
+// Application
+#include "geofenceengine.h"
+#include "simulationscheduler.h"
+#include "fleetstate.h"
+#include "geoutils.h"
+#define BASE_CELL_SIZE 0.01 // deg (about 1 km), cell size doubles on each level
+#define MAX_LEVEL 15
+#define MIN_COS_LATITUDE 1e-6
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+GeofenceEngine::GeofenceEngine(SimulationScheduler *pScheduler, FleetState *pFleetState, int iPeriodMs, QObject *pParent) : QObject(pParent),
+    m_pScheduler(pScheduler), m_pFleetState(pFleetState)
+{
+    qRegisterMetaType<SpyCore::ZoneType>("SpyCore::ZoneType");
+    qRegisterMetaType<SpyCore::GeofenceEvent>("SpyCore::GeofenceEvent");
+    m_iTaskId = m_pScheduler->addTask(iPeriodMs, [this]() { check(); });
+}
+
+//-------------------------------------------------------------------------------------------------
+
+GeofenceEngine::~GeofenceEngine()
+{
+    m_pScheduler->removeTask(m_iTaskId);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void GeofenceEngine::setZones(int iSlot, const QGeoPath &safetyPlan, const QList<QGeoShape> &lExclusionArea)
+{
+    removeZones(iSlot);
+
+    // Safety plan
+    Zone safetyZone;
+    safetyZone.iSlot = iSlot;
+    safetyZone.iZone = 0;
+    safetyZone.eType = SpyCore::SAFETY_ZONE;
+    for (int i=0; i<safetyPlan.size(); i++)
+    {
+        safetyZone.vLatitudes << safetyPlan.coordinateAt(i).latitude();
+        safetyZone.vLongitudes << safetyPlan.coordinateAt(i).longitude();
+    }
+    if (safetyZone.vLatitudes.size() > 2)
+        addZone(safetyZone);
+
+    // Exclusion areas
+    for (int i=0; i<lExclusionArea.size(); i++)
+    {
+        const QGeoShape &shape = lExclusionArea[i];
+        Zone exclusionZone;
+        exclusionZone.iSlot = iSlot;
+        exclusionZone.iZone = i+1;
+        exclusionZone.eType = SpyCore::EXCLUSION_ZONE;
+        if (shape.type() == QGeoShape::CircleType)
+        {
+            QGeoCircle circle(shape);
+            exclusionZone.bCircle = true;
+            exclusionZone.center = GeoPoint(circle.center());
+            exclusionZone.dRadius = circle.radius();
+        }
+        else
+        if (shape.type() == QGeoShape::RectangleType)
+        {
+            QGeoRectangle rectangle(shape);
+            exclusionZone.vLatitudes << rectangle.topLeft().latitude() << rectangle.topLeft().latitude() << rectangle.bottomRight().latitude() << rectangle.bottomRight().latitude();
+            exclusionZone.vLongitudes << rectangle.topLeft().longitude() << rectangle.bottomRight().longitude() << rectangle.bottomRight().longitude() << rectangle.topLeft().longitude();
+        }
+        else
+        if (shape.type() == QGeoShape::PathType)
+        {
+            QGeoPath path(shape);
+            for (int j=0; j<path.size(); j++)
+            {
+                exclusionZone.vLatitudes << path.coordinateAt(j).latitude();
+                exclusionZone.vLongitudes << path.coordinateAt(j).longitude();
+            }
+        }
+        // Degenerate areas (no radius, fewer than 3 vertices) enclose nothing
+        if ((exclusionZone.bCircle && (exclusionZone.dRadius > 0)) || (exclusionZone.vLatitudes.size() > 2))
+            addZone(exclusionZone);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void GeofenceEngine::removeZones(int iSlot)
+{
+    if ((iSlot < 0) || (iSlot >= m_vSlotZones.size()))
+        return;
+
+    foreach (int iId, m_vSlotZones[iSlot])
+    {
+        indexZone(iId, false);
+        m_vZones[iId] = Zone();
+        m_vFreeZones << iId;
+    }
+    m_vSlotZones[iSlot].clear();
+    m_vSlotLevels[iSlot] = 0;
+
+    // New zones are entered again on next check (no exit event for zones that no longer exist)
+    m_vInside[iSlot].clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int GeofenceEngine::zoneCount() const
+{
+    return m_vZones.size()-m_vFreeZones.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+qint64 GeofenceEngine::eventCount() const
+{
+    return m_iEventCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool GeofenceEngine::isInside(int iSlot, int iZone) const
+{
+    if ((iSlot < 0) || (iSlot >= m_vInside.size()))
+        return false;
+    return std::binary_search(m_vInside[iSlot].constBegin(), m_vInside[iSlot].constEnd(), iZone);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void GeofenceEngine::check()
+{
+    const uchar *pActive = m_pFleetState->activeFlags();
+    const double *pLatitudes = m_pFleetState->latitudes();
+    const double *pLongitudes = m_pFleetState->longitudes();
+    int iSlotCount = qMin(m_pFleetState->slotCount(), m_vSlotZones.size());
+    QVector<int> vInside;
+    for (int iSlot=0; iSlot<iSlotCount; iSlot++)
+    {
+        if (!pActive[iSlot] || m_vSlotZones[iSlot].isEmpty())
+            continue;
+
+        // Broad phase: one cell lookup per grid level used by the slot, whatever its zone count
+        double dLatitude = pLatitudes[iSlot];
+        double dLongitude = pLongitudes[iSlot];
+        vInside.clear();
+        quint32 iLevels = m_vSlotLevels[iSlot];
+        for (int iLevel=0; iLevels != 0; iLevel++, iLevels >>= 1)
+        {
+            if (!(iLevels & 1))
+                continue;
+            QHash<quint64, QVector<int> >::const_iterator it = m_hCells.constFind(cellKey(iSlot, iLevel, cellRow(dLatitude, iLevel), cellColumn(dLongitude, iLevel)));
+            if (it == m_hCells.constEnd())
+                continue;
+
+            // Narrow phase
+            foreach (int iId, it.value())
+                if (contains(m_vZones[iId], dLatitude, dLongitude))
+                    vInside << m_vZones[iId].iZone;
+        }
+        std::sort(vInside.begin(), vInside.end());
+
+        // Compare with previous check (both sorted)
+        QVector<int> &vWasInside = m_vInside[iSlot];
+        if (vInside == vWasInside)
+            continue;
+        int i = 0;
+        int j = 0;
+        while ((i < vInside.size()) || (j < vWasInside.size()))
+        {
+            if ((j == vWasInside.size()) || ((i < vInside.size()) && (vInside[i] < vWasInside[j])))
+            {
+                m_iEventCount++;
+                emit zoneEvent(iSlot, vInside[i], vInside[i] == 0 ? SpyCore::SAFETY_ZONE : SpyCore::EXCLUSION_ZONE, SpyCore::ZONE_ENTRY);
+                i++;
+            }
+            else
+            if ((i == vInside.size()) || (vWasInside[j] < vInside[i]))
+            {
+                m_iEventCount++;
+                emit zoneEvent(iSlot, vWasInside[j], vWasInside[j] == 0 ? SpyCore::SAFETY_ZONE : SpyCore::EXCLUSION_ZONE, SpyCore::ZONE_EXIT);
+                j++;
+            }
+            else
+            {
+                i++;
+                j++;
+            }
+        }
+        vWasInside = vInside;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void GeofenceEngine::addZone(const Zone &zone)
+{
+    int iId = 0;
+    if (!m_vFreeZones.isEmpty())
+    {
+        iId = m_vFreeZones.takeLast();
+        m_vZones[iId] = zone;
+    }
+    else
+    {
+        iId = m_vZones.size();
+        m_vZones << zone;
+    }
+    computeBounds(m_vZones[iId]);
+    indexZone(iId, true);
+
+    int iSlot = zone.iSlot;
+    if (iSlot >= m_vSlotZones.size())
+    {
+        m_vSlotZones.resize(iSlot+1);
+        m_vSlotLevels.resize(iSlot+1);
+        m_vInside.resize(iSlot+1);
+    }
+    m_vSlotZones[iSlot] << iId;
+    m_vSlotLevels[iSlot] |= 1u << m_vZones[iId].iLevel;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void GeofenceEngine::indexZone(int iId, bool bInsert)
+{
+    const Zone &zone = m_vZones[iId];
+    int iLastRow = cellRow(zone.dMaxLatitude, zone.iLevel);
+    int iLastColumn = cellColumn(zone.dMaxLongitude, zone.iLevel);
+    for (int iRow=cellRow(zone.dMinLatitude, zone.iLevel); iRow<=iLastRow; iRow++)
+    {
+        for (int iColumn=cellColumn(zone.dMinLongitude, zone.iLevel); iColumn<=iLastColumn; iColumn++)
+        {
+            quint64 iKey = cellKey(zone.iSlot, zone.iLevel, iRow, iColumn);
+            if (bInsert)
+                m_hCells[iKey] << iId;
+            else
+            {
+                QHash<quint64, QVector<int> >::iterator it = m_hCells.find(iKey);
+                if (it == m_hCells.end())
+                    continue;
+                it.value().removeOne(iId);
+                if (it.value().isEmpty())
+                    m_hCells.erase(it);
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void GeofenceEngine::computeBounds(Zone &zone)
+{
+    if (zone.bCircle)
+    {
+        double dLatitudeExtent = qRadiansToDegrees(zone.dRadius/EARTH_RADIUS);
+        double dLongitudeExtent = dLatitudeExtent/qMax(qCos(qDegreesToRadians(zone.center.dLatitude)), MIN_COS_LATITUDE);
+        zone.dMinLatitude = zone.center.dLatitude-dLatitudeExtent;
+        zone.dMaxLatitude = zone.center.dLatitude+dLatitudeExtent;
+        zone.dMinLongitude = zone.center.dLongitude-dLongitudeExtent;
+        zone.dMaxLongitude = zone.center.dLongitude+dLongitudeExtent;
+    }
+    else
+    {
+        zone.dMinLatitude = *std::min_element(zone.vLatitudes.constBegin(), zone.vLatitudes.constEnd());
+        zone.dMaxLatitude = *std::max_element(zone.vLatitudes.constBegin(), zone.vLatitudes.constEnd());
+        zone.dMinLongitude = *std::min_element(zone.vLongitudes.constBegin(), zone.vLongitudes.constEnd());
+        zone.dMaxLongitude = *std::max_element(zone.vLongitudes.constBegin(), zone.vLongitudes.constEnd());
+    }
+    zone.dMinLatitude = qMax(zone.dMinLatitude, -90.);
+    zone.dMaxLatitude = qMin(zone.dMaxLatitude, 90.);
+    zone.dMinLongitude = qMax(zone.dMinLongitude, -180.);
+    zone.dMaxLongitude = qMin(zone.dMaxLongitude, 180.);
+
+    // Coarsest cells needed: cell at least as large as the zone, so it overlaps 2x2 cells at most
+    double dExtent = qMax(zone.dMaxLatitude-zone.dMinLatitude, zone.dMaxLongitude-zone.dMinLongitude);
+    zone.iLevel = 0;
+    while ((zone.iLevel < MAX_LEVEL) && (BASE_CELL_SIZE*(1 << zone.iLevel) < dExtent))
+        zone.iLevel++;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool GeofenceEngine::contains(const Zone &zone, double dLatitude, double dLongitude)
+{
+    if ((dLatitude < zone.dMinLatitude) || (dLatitude > zone.dMaxLatitude) || (dLongitude < zone.dMinLongitude) || (dLongitude > zone.dMaxLongitude))
+        return false;
+    if (zone.bCircle)
+        return GeoUtils::distance(zone.center, GeoPoint(dLatitude, dLongitude)) <= zone.dRadius;
+
+    // Even-odd rule in the lat/lon plane (zones are small enough for edges to be straight)
+    bool bInside = false;
+    int iCount = zone.vLatitudes.size();
+    for (int i=0, j=iCount-1; i<iCount; j=i++)
+    {
+        double dLatitudeI = zone.vLatitudes[i];
+        double dLatitudeJ = zone.vLatitudes[j];
+        if ((dLatitudeI > dLatitude) != (dLatitudeJ > dLatitude))
+        {
+            double dCrossing = zone.vLongitudes[i]+(dLatitude-dLatitudeI)*(zone.vLongitudes[j]-zone.vLongitudes[i])/(dLatitudeJ-dLatitudeI);
+            if (dLongitude < dCrossing)
+                bInside = !bInside;
+        }
+    }
+    return bInside;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+quint64 GeofenceEngine::cellKey(int iSlot, int iLevel, int iRow, int iColumn)
+{
+    // Slot: 24 bits, level: 6 bits, row and column: 17 bits each (36000 columns at level 0)
+    return ((quint64)iSlot << 40) | ((quint64)iLevel << 34) | ((quint64)iRow << 17) | (quint64)iColumn;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int GeofenceEngine::cellRow(double dLatitude, int iLevel)
+{
+    return qFloor((dLatitude+90.)/(BASE_CELL_SIZE*(1 << iLevel)));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int GeofenceEngine::cellColumn(double dLongitude, int iLevel)
+{
+    return qFloor((dLongitude+180.)/(BASE_CELL_SIZE*(1 << iLevel)));
+}
@@ -0,0 +1,153 @@
+#ifndef GEOFENCEENGINE_H
+#define GEOFENCEENGINE_H
+
+// Qt
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QList>
+#include <QGeoPath>
+#include <QGeoShape>
+
+// Application
+#include "spycore.h"
+#include "geopoint.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class SimulationScheduler;
+class FleetState;
+class SPYCLIBSHARED_EXPORT GeofenceEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor
+    GeofenceEngine(SimulationScheduler *pScheduler, FleetState *pFleetState, int iPeriodMs=100, QObject *pParent=nullptr);
+
+    //! Destructor
+    ~GeofenceEngine();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Set zones of a slot: safety plan (zone 0) and exclusion areas (zones 1..n), previous zones are dropped
+    void setZones(int iSlot, const QGeoPath &safetyPlan, const QList<QGeoShape> &lExclusionArea);
+
+    //! Remove zones of a slot
+    void removeZones(int iSlot);
+
+    //! Return number of indexed zones
+    int zoneCount() const;
+
+    //! Return number of events raised so far
+    qint64 eventCount() const;
+
+    //! Return true if slot is inside zone iZone (as of last check)
+    bool isInside(int iSlot, int iZone) const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Check every active drone against its zones, raise entry and exit events
+    void check();
+
+private:
+    //! Zone: circle or polygon (lat/lon plane), indexed on the grid level where it spans at most 2x2 cells
+    struct Zone
+    {
+        //! Owner slot (-1: free)
+        int iSlot = -1;
+
+        //! Zone number for its owner (0: safety, 1..n: exclusion areas)
+        int iZone = 0;
+
+        //! Type
+        SpyCore::ZoneType eType = SpyCore::SAFETY_ZONE;
+
+        //! Circle?
+        bool bCircle = false;
+
+        //! Circle center (deg)
+        GeoPoint center;
+
+        //! Circle radius (m)
+        double dRadius = 0;
+
+        //! Polygon vertices (deg)
+        QVector<double> vLatitudes;
+        QVector<double> vLongitudes;
+
+        //! Bounding box (deg)
+        double dMinLatitude = 0;
+        double dMaxLatitude = 0;
+        double dMinLongitude = 0;
+        double dMaxLongitude = 0;
+
+        //! Grid level
+        int iLevel = 0;
+    };
+
+    //! Add zone of a slot to the index
+    void addZone(const Zone &zone);
+
+    //! Insert (or remove) zone iId in every cell its bounding box overlaps
+    void indexZone(int iId, bool bInsert);
+
+    //! Set bounding box and grid level of a zone
+    static void computeBounds(Zone &zone);
+
+    //! Return true if position is inside zone
+    static bool contains(const Zone &zone, double dLatitude, double dLongitude);
+
+    //! Return cell key of (slot, level, cell row, cell column)
+    static quint64 cellKey(int iSlot, int iLevel, int iRow, int iColumn);
+
+    //! Return cell row of a latitude, column of a longitude
+    static int cellRow(double dLatitude, int iLevel);
+    static int cellColumn(double dLongitude, int iLevel);
+
+private:
+    //! Scheduler
+    SimulationScheduler *m_pScheduler = nullptr;
+
+    //! Fleet state
+    FleetState *m_pFleetState = nullptr;
+
+    //! Check task id
+    int m_iTaskId = -1;
+
+    //! Zones (free ones are reused)
+    QVector<Zone> m_vZones;
+
+    //! Free zones
+    QVector<int> m_vFreeZones;
+
+    //! Grid cells: zones of a slot overlapping a cell
+    QHash<quint64, QVector<int> > m_hCells;
+
+    //! Zones of each slot
+    QVector<QVector<int> > m_vSlotZones;
+
+    //! Grid levels used by each slot (bit mask)
+    QVector<quint32> m_vSlotLevels;
+
+    //! Zones each slot is inside of (sorted zone numbers)
+    QVector<QVector<int> > m_vInside;
+
+    //! Event count
+    qint64 m_iEventCount = 0;
+
+signals:
+    //! Drone entered or left a zone (emitted from check(): receivers must not change zones synchronously)
+    void zoneEvent(int iSlot, int iZone, SpyCore::ZoneType eZoneType, SpyCore::GeofenceEvent eEvent);
+};
+}
+
+#endif // GEOFENCEENGINE_H
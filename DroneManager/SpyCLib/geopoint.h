@@ -0,0 +1,42 @@
+#ifndef GEOPOINT_H
+#define GEOPOINT_H
+
+// Qt
+#include <QtNumeric>
+#include <QGeoCoordinate>
+
+// Application
+#include "spyclib_global.h"
+
+namespace Core {
+//! Geographic point (deg, m) for internal hot paths: three doubles, no shared data, copied by value
+struct GeoPoint
+{
+    //! Latitude (deg, NaN if unknown)
+    double dLatitude = qQNaN();
+
+    //! Longitude (deg, NaN if unknown)
+    double dLongitude = qQNaN();
+
+    //! Altitude (m, NaN if unknown)
+    double dAltitude = qQNaN();
+
+    //! Constructor (invalid point)
+    GeoPoint() {}
+
+    //! Constructor
+    GeoPoint(double dLat, double dLon, double dAlt=qQNaN()) : dLatitude(dLat), dLongitude(dLon), dAltitude(dAlt) {}
+
+    //! Constructor (from public API)
+    explicit GeoPoint(const QGeoCoordinate &geoCoord) : dLatitude(geoCoord.latitude()), dLongitude(geoCoord.longitude()), dAltitude(geoCoord.altitude()) {}
+
+    //! Return coordinate (public API)
+    QGeoCoordinate toCoordinate() const { return QGeoCoordinate(dLatitude, dLongitude, dAltitude); }
+
+    //! Return true if latitude and longitude are in range
+    bool isValid() const { return (dLatitude >= -90) && (dLatitude <= 90) && (dLongitude >= -180) && (dLongitude <= 180); }
+};
+}
+Q_DECLARE_TYPEINFO(Core::GeoPoint, Q_MOVABLE_TYPE);
+
+#endif // GEOPOINT_H
@@ -0,0 +1,142 @@
+// Qt
+#include <QtMath>
+
+// Application
+#include "geoutils.h"
+#define MIN_CENTRAL_ANGLE 1e-12
+#define MIN_COS_LATITUDE 1e-6 // Poles
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+double GeoUtils::centralAngle(const GeoPoint &from, const GeoPoint &to)
+{
+    // Haversine: well conditioned for short distances
+    double dLat1 = qDegreesToRadians(from.dLatitude);
+    double dLat2 = qDegreesToRadians(to.dLatitude);
+    double dSinLat = qSin((dLat2-dLat1)/2);
+    double dSinLon = qSin(qDegreesToRadians(to.dLongitude-from.dLongitude)/2);
+    double dHaversine = dSinLat*dSinLat+qCos(dLat1)*qCos(dLat2)*dSinLon*dSinLon;
+    return 2*qAtan2(qSqrt(dHaversine), qSqrt(qMax(0., 1-dHaversine)));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double GeoUtils::distance(const GeoPoint &from, const GeoPoint &to)
+{
+    return EARTH_RADIUS*centralAngle(from, to);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double GeoUtils::bearing(const GeoPoint &from, const GeoPoint &to)
+{
+    double dLat1 = qDegreesToRadians(from.dLatitude);
+    double dLat2 = qDegreesToRadians(to.dLatitude);
+    double dDeltaLon = qDegreesToRadians(to.dLongitude-from.dLongitude);
+    double dY = qSin(dDeltaLon)*qCos(dLat2);
+    double dX = qCos(dLat1)*qSin(dLat2)-qSin(dLat1)*qCos(dLat2)*qCos(dDeltaLon);
+    double dBearing = qRadiansToDegrees(qAtan2(dY, dX));
+    return dBearing < 0 ? dBearing+360 : dBearing;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+GeoPoint GeoUtils::interpolate(const GeoPoint &from, const GeoPoint &to, double dFraction)
+{
+    // Altitude
+    double dAltitude = from.dAltitude;
+    if (qIsNaN(dAltitude))
+        dAltitude = to.dAltitude;
+    else
+    if (!qIsNaN(to.dAltitude))
+        dAltitude += (to.dAltitude-from.dAltitude)*dFraction;
+
+    // Coincident points
+    double dAngle = centralAngle(from, to);
+    if (dAngle < MIN_CENTRAL_ANGLE)
+        return GeoPoint(from.dLatitude, from.dLongitude, dAltitude);
+
+    // Spherical linear interpolation of unit vectors
+    double dLat1 = qDegreesToRadians(from.dLatitude);
+    double dLon1 = qDegreesToRadians(from.dLongitude);
+    double dLat2 = qDegreesToRadians(to.dLatitude);
+    double dLon2 = qDegreesToRadians(to.dLongitude);
+    double dA = qSin((1-dFraction)*dAngle)/qSin(dAngle);
+    double dB = qSin(dFraction*dAngle)/qSin(dAngle);
+    double dX = dA*qCos(dLat1)*qCos(dLon1)+dB*qCos(dLat2)*qCos(dLon2);
+    double dY = dA*qCos(dLat1)*qSin(dLon1)+dB*qCos(dLat2)*qSin(dLon2);
+    double dZ = dA*qSin(dLat1)+dB*qSin(dLat2);
+    double dLatitude = qRadiansToDegrees(qAtan2(dZ, qSqrt(dX*dX+dY*dY)));
+    double dLongitude = qRadiansToDegrees(qAtan2(dY, dX));
+    return GeoPoint(dLatitude, dLongitude, dAltitude);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double GeoUtils::wrapLongitude(double dLongitude)
+{
+    dLongitude = fmod(dLongitude+180, 360);
+    if (dLongitude < 0)
+        dLongitude += 360;
+    return dLongitude-180;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+GeoPoint GeoUtils::translate(const GeoPoint &position, double dNorth, double dEast)
+{
+    double dMetersPerDegree = qDegreesToRadians(EARTH_RADIUS);
+    double dLatitude = position.dLatitude+dNorth/dMetersPerDegree;
+    double dLongitude = position.dLongitude+dEast/(dMetersPerDegree*qMax(qCos(qDegreesToRadians(position.dLatitude)), MIN_COS_LATITUDE));
+    return GeoPoint(dLatitude, wrapLongitude(dLongitude), position.dAltitude);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+GeoPoint GeoUtils::extrapolate(const GeoPoint &position, double dVelocityNorth, double dVelocityEast, double dSeconds)
+{
+    return translate(position, dVelocityNorth*dSeconds, dVelocityEast*dSeconds);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double GeoUtils::centralAngle(const QGeoCoordinate &from, const QGeoCoordinate &to)
+{
+    return centralAngle(GeoPoint(from), GeoPoint(to));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double GeoUtils::distance(const QGeoCoordinate &from, const QGeoCoordinate &to)
+{
+    return distance(GeoPoint(from), GeoPoint(to));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double GeoUtils::bearing(const QGeoCoordinate &from, const QGeoCoordinate &to)
+{
+    return bearing(GeoPoint(from), GeoPoint(to));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QGeoCoordinate GeoUtils::interpolate(const QGeoCoordinate &from, const QGeoCoordinate &to, double dFraction)
+{
+    return interpolate(GeoPoint(from), GeoPoint(to), dFraction).toCoordinate();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QGeoCoordinate GeoUtils::translate(const QGeoCoordinate &position, double dNorth, double dEast)
+{
+    return translate(GeoPoint(position), dNorth, dEast).toCoordinate();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QGeoCoordinate GeoUtils::extrapolate(const QGeoCoordinate &position, double dVelocityNorth, double dVelocityEast, double dSeconds)
+{
+    return extrapolate(GeoPoint(position), dVelocityNorth, dVelocityEast, dSeconds).toCoordinate();
+}
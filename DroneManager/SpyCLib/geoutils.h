@@ -0,0 +1,63 @@
+#ifndef GEOUTILS_H
+#define GEOUTILS_H
+
+// Qt
+#include <QGeoCoordinate>
+
+// Application
+#include "geopoint.h"
+#include "spyclib_global.h"
+#define EARTH_RADIUS 6371007.2
+
+namespace Core {
+namespace GeoUtils {
+//-------------------------------------------------------------------------------------------------
+// GeoPoint (internal)
+//-------------------------------------------------------------------------------------------------
+
+//! Return angle (rad) between two points seen from the earth center
+SPYCLIBSHARED_EXPORT double centralAngle(const GeoPoint &from, const GeoPoint &to);
+
+//! Return great circle distance (m)
+SPYCLIBSHARED_EXPORT double distance(const GeoPoint &from, const GeoPoint &to);
+
+//! Return initial bearing (deg, [0, 360[) of the great circle from -> to
+SPYCLIBSHARED_EXPORT double bearing(const GeoPoint &from, const GeoPoint &to);
+
+//! Return longitude (deg) wrapped into [-180, 180[ (longitude differences too: shortest way around the antimeridian)
+SPYCLIBSHARED_EXPORT double wrapLongitude(double dLongitude);
+
+//! Return point moved dNorth m towards north and dEast m towards east (local plane)
+SPYCLIBSHARED_EXPORT GeoPoint translate(const GeoPoint &position, double dNorth, double dEast);
+
+//! Return point after dSeconds at constant velocity (m/s, local plane)
+SPYCLIBSHARED_EXPORT GeoPoint extrapolate(const GeoPoint &position, double dVelocityNorth, double dVelocityEast, double dSeconds);
+
+//! Return point at dFraction of the great circle from -> to (altitude is interpolated linearly)
+SPYCLIBSHARED_EXPORT GeoPoint interpolate(const GeoPoint &from, const GeoPoint &to, double dFraction);
+
+//-------------------------------------------------------------------------------------------------
+// QGeoCoordinate (public API, converted to GeoPoint)
+//-------------------------------------------------------------------------------------------------
+
+//! Return angle (rad) between two coordinates seen from the earth center
+SPYCLIBSHARED_EXPORT double centralAngle(const QGeoCoordinate &from, const QGeoCoordinate &to);
+
+//! Return great circle distance (m)
+SPYCLIBSHARED_EXPORT double distance(const QGeoCoordinate &from, const QGeoCoordinate &to);
+
+//! Return initial bearing (deg, [0, 360[) of the great circle from -> to
+SPYCLIBSHARED_EXPORT double bearing(const QGeoCoordinate &from, const QGeoCoordinate &to);
+
+//! Return position moved dNorth m towards north and dEast m towards east (local plane)
+SPYCLIBSHARED_EXPORT QGeoCoordinate translate(const QGeoCoordinate &position, double dNorth, double dEast);
+
+//! Return position after dSeconds at constant velocity (m/s, local plane: dead reckoning contract of drone status)
+SPYCLIBSHARED_EXPORT QGeoCoordinate extrapolate(const QGeoCoordinate &position, double dVelocityNorth, double dVelocityEast, double dSeconds);
+
+//! Return point at dFraction of the great circle from -> to (altitude is interpolated linearly)
+SPYCLIBSHARED_EXPORT QGeoCoordinate interpolate(const QGeoCoordinate &from, const QGeoCoordinate &to, double dFraction);
+}
+}
+
+#endif // GEOUTILS_H
@@ -0,0 +1,105 @@
+// Application
+#include "kinematicskernel.h"
+
+// Instruction set is chosen at compile time (-mavx, /arch:AVX); SSE2 is the x86-64 baseline
+#if defined(__AVX__)
+#define KINEMATICS_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define KINEMATICS_SSE2
+#include <emmintrin.h>
+#endif
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+Kinematics::InstructionSet Kinematics::instructionSet()
+{
+#if defined(KINEMATICS_AVX)
+    return AVX;
+#elif defined(KINEMATICS_SSE2)
+    return SSE2;
+#else
+    return SCALAR;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void Kinematics::stepScalar(const SegmentBatch &batch, double dDeltaTime, int iBegin, int iEnd)
+{
+    for (int i=iBegin; i<iEnd; i++)
+    {
+        double dDistance = batch.pDistance[i]+batch.pSpeed[i]*dDeltaTime;
+        double dRatio = dDistance/batch.pLength[i];
+        if (dRatio > 1.)
+            dRatio = 1.;
+        batch.pDistance[i] = dDistance;
+        batch.pLatitude[i] = batch.pStartLatitude[i]+batch.pDeltaLatitude[i]*dRatio;
+        double dLongitude = batch.pStartLongitude[i]+batch.pDeltaLongitude[i]*dRatio;
+        dLongitude -= dLongitude >= 180. ? 360. : 0.; // Segments crossing the antimeridian
+        dLongitude += dLongitude < -180. ? 360. : 0.;
+        batch.pLongitude[i] = dLongitude;
+        batch.pHeading[i] = batch.pSegmentHeading[i];
+        batch.pSegmentDone[i] = dDistance >= batch.pLength[i] ? 1 : 0;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void Kinematics::step(const SegmentBatch &batch, double dDeltaTime, int iBegin, int iEnd)
+{
+    int i = iBegin;
+
+    // Same operations in the same order as stepScalar (no fused multiply-add): results are identical
+#if defined(KINEMATICS_AVX)
+    const __m256d vDeltaTime = _mm256_set1_pd(dDeltaTime);
+    const __m256d vOne = _mm256_set1_pd(1.);
+    const __m256d vHalfTurn = _mm256_set1_pd(180.);
+    const __m256d vMinusHalfTurn = _mm256_set1_pd(-180.);
+    const __m256d vTurn = _mm256_set1_pd(360.);
+    for (; i+4<=iEnd; i+=4)
+    {
+        __m256d vLength = _mm256_loadu_pd(batch.pLength+i);
+        __m256d vDistance = _mm256_add_pd(_mm256_loadu_pd(batch.pDistance+i), _mm256_mul_pd(_mm256_loadu_pd(batch.pSpeed+i), vDeltaTime));
+        __m256d vRatio = _mm256_min_pd(_mm256_div_pd(vDistance, vLength), vOne);
+        _mm256_storeu_pd(batch.pDistance+i, vDistance);
+        _mm256_storeu_pd(batch.pLatitude+i, _mm256_add_pd(_mm256_loadu_pd(batch.pStartLatitude+i), _mm256_mul_pd(_mm256_loadu_pd(batch.pDeltaLatitude+i), vRatio)));
+        __m256d vLongitude = _mm256_add_pd(_mm256_loadu_pd(batch.pStartLongitude+i), _mm256_mul_pd(_mm256_loadu_pd(batch.pDeltaLongitude+i), vRatio));
+        vLongitude = _mm256_sub_pd(vLongitude, _mm256_and_pd(_mm256_cmp_pd(vLongitude, vHalfTurn, _CMP_GE_OQ), vTurn));
+        vLongitude = _mm256_add_pd(vLongitude, _mm256_and_pd(_mm256_cmp_pd(vLongitude, vMinusHalfTurn, _CMP_LT_OQ), vTurn));
+        _mm256_storeu_pd(batch.pLongitude+i, vLongitude);
+        _mm256_storeu_pd(batch.pHeading+i, _mm256_loadu_pd(batch.pSegmentHeading+i));
+        int iDone = _mm256_movemask_pd(_mm256_cmp_pd(vDistance, vLength, _CMP_GE_OQ));
+        batch.pSegmentDone[i] = iDone&1;
+        batch.pSegmentDone[i+1] = (iDone>>1)&1;
+        batch.pSegmentDone[i+2] = (iDone>>2)&1;
+        batch.pSegmentDone[i+3] = (iDone>>3)&1;
+    }
+#elif defined(KINEMATICS_SSE2)
+    const __m128d vDeltaTime = _mm_set1_pd(dDeltaTime);
+    const __m128d vOne = _mm_set1_pd(1.);
+    const __m128d vHalfTurn = _mm_set1_pd(180.);
+    const __m128d vMinusHalfTurn = _mm_set1_pd(-180.);
+    const __m128d vTurn = _mm_set1_pd(360.);
+    for (; i+2<=iEnd; i+=2)
+    {
+        __m128d vLength = _mm_loadu_pd(batch.pLength+i);
+        __m128d vDistance = _mm_add_pd(_mm_loadu_pd(batch.pDistance+i), _mm_mul_pd(_mm_loadu_pd(batch.pSpeed+i), vDeltaTime));
+        __m128d vRatio = _mm_min_pd(_mm_div_pd(vDistance, vLength), vOne);
+        _mm_storeu_pd(batch.pDistance+i, vDistance);
+        _mm_storeu_pd(batch.pLatitude+i, _mm_add_pd(_mm_loadu_pd(batch.pStartLatitude+i), _mm_mul_pd(_mm_loadu_pd(batch.pDeltaLatitude+i), vRatio)));
+        __m128d vLongitude = _mm_add_pd(_mm_loadu_pd(batch.pStartLongitude+i), _mm_mul_pd(_mm_loadu_pd(batch.pDeltaLongitude+i), vRatio));
+        vLongitude = _mm_sub_pd(vLongitude, _mm_and_pd(_mm_cmpge_pd(vLongitude, vHalfTurn), vTurn));
+        vLongitude = _mm_add_pd(vLongitude, _mm_and_pd(_mm_cmplt_pd(vLongitude, vMinusHalfTurn), vTurn));
+        _mm_storeu_pd(batch.pLongitude+i, vLongitude);
+        _mm_storeu_pd(batch.pHeading+i, _mm_loadu_pd(batch.pSegmentHeading+i));
+        int iDone = _mm_movemask_pd(_mm_cmpge_pd(vDistance, vLength));
+        batch.pSegmentDone[i] = iDone&1;
+        batch.pSegmentDone[i+1] = (iDone>>1)&1;
+    }
+#endif
+
+    // Remainder
+    stepScalar(batch, dDeltaTime, i, iEnd);
+}
@@ -0,0 +1,69 @@
+#ifndef KINEMATICSKERNEL_H
+#define KINEMATICSKERNEL_H
+
+// Qt
+#include <QtGlobal>
+
+// Application
+#include "spyclib_global.h"
+
+namespace Core {
+namespace Kinematics {
+//! Instruction set used by step()
+enum InstructionSet {SCALAR, SSE2, AVX};
+
+//! Segment columns of a fleet (slot indexed, see FleetState::segmentBatch())
+struct SegmentBatch
+{
+    //! Segment start latitude
+    const double *pStartLatitude = nullptr;
+
+    //! Segment start longitude
+    const double *pStartLongitude = nullptr;
+
+    //! Segment latitude extent
+    const double *pDeltaLatitude = nullptr;
+
+    //! Segment longitude extent
+    const double *pDeltaLongitude = nullptr;
+
+    //! Segment length (m, > 0)
+    const double *pLength = nullptr;
+
+    //! Speed (m/s)
+    const double *pSpeed = nullptr;
+
+    //! Segment heading
+    const double *pSegmentHeading = nullptr;
+
+    //! Distance flown along segment (m, in/out)
+    double *pDistance = nullptr;
+
+    //! Latitude (out)
+    double *pLatitude = nullptr;
+
+    //! Longitude (out, wrapped into [-180, 180[)
+    double *pLongitude = nullptr;
+
+    //! Heading (out)
+    double *pHeading = nullptr;
+
+    //! Set to 1 when the end of the segment is reached (out)
+    uchar *pSegmentDone = nullptr;
+
+    //! Number of drones
+    int iCount = 0;
+};
+
+//! Return instruction set used by step()
+SPYCLIBSHARED_EXPORT InstructionSet instructionSet();
+
+//! Advance drones [iBegin, iEnd[ by dDeltaTime seconds along their segment (reference implementation)
+SPYCLIBSHARED_EXPORT void stepScalar(const SegmentBatch &batch, double dDeltaTime, int iBegin, int iEnd);
+
+//! Advance drones [iBegin, iEnd[ by dDeltaTime seconds along their segment (vectorized)
+SPYCLIBSHARED_EXPORT void step(const SegmentBatch &batch, double dDeltaTime, int iBegin, int iEnd);
+}
+}
+
+#endif // KINEMATICSKERNEL_H
@@ -0,0 +1,19 @@
+// Application
+#include "messageschema.h"
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+// QStringLiteral builds the QString data at compile time: lookups never allocate nor convert
+static const QString s_keyNames[Schema::KEY_COUNT] = {
+#define SPYC_SCHEMA_LITERAL(eKey, sName) QStringLiteral(sName),
+    SPYC_SCHEMA_KEYS(SPYC_SCHEMA_LITERAL)
+#undef SPYC_SCHEMA_LITERAL
+};
+
+//-------------------------------------------------------------------------------------------------
+
+const QString &Schema::name(Key eKey)
+{
+    return s_keyNames[eKey];
+}
@@ -0,0 +1,331 @@
+#ifndef MESSAGESCHEMA_H
+#define MESSAGESCHEMA_H
+
+// Qt
+#include <QString>
+#include <QMap>
+
+// Application
+#include "cxmlnode.h"
+#include "spycore.h"
+#include "defs.h"
+#include "spyclib_global.h"
+
+namespace Core {
+namespace Schema {
+//-------------------------------------------------------------------------------------------------
+// Keys
+//-------------------------------------------------------------------------------------------------
+
+//! Message keys (tags and attributes)
+enum Key {
+#define SPYC_SCHEMA_ENUM(eKey, sName) eKey,
+    SPYC_SCHEMA_KEYS(SPYC_SCHEMA_ENUM)
+#undef SPYC_SCHEMA_ENUM
+    KEY_COUNT
+};
+
+//! Return wire name of a key (static string data, never allocated)
+SPYCLIBSHARED_EXPORT const QString &name(Key eKey);
+
+//-------------------------------------------------------------------------------------------------
+// Value codecs
+//-------------------------------------------------------------------------------------------------
+
+//! Enum codec (default)
+template <typename T>
+struct Codec
+{
+    static QString encode(T value) { return QString::number((int)value); }
+    static T decode(const QString &sValue) { return (T)sValue.toInt(); }
+};
+
+//! String codec
+template <>
+struct Codec<QString>
+{
+    static QString encode(const QString &sValue) { return sValue; }
+    static QString decode(const QString &sValue) { return sValue; }
+};
+
+//! Double codec
+template <>
+struct Codec<double>
+{
+    static QString encode(double dValue) { return QString::number(dValue); }
+    static double decode(const QString &sValue) { return sValue.toDouble(); }
+};
+
+//! Int codec
+template <>
+struct Codec<int>
+{
+    static QString encode(int iValue) { return QString::number(iValue); }
+    static int decode(const QString &sValue) { return sValue.toInt(); }
+};
+
+//! 64 bit int codec (timestamps)
+template <>
+struct Codec<qint64>
+{
+    static QString encode(qint64 iValue) { return QString::number(iValue); }
+    static qint64 decode(const QString &sValue) { return sValue.toLongLong(); }
+};
+
+//! Bool codec
+template <>
+struct Codec<bool>
+{
+    static QString encode(bool bValue) { return QString::number((int)bValue); }
+    static bool decode(const QString &sValue) { return (bool)sValue.toInt(); }
+};
+
+//-------------------------------------------------------------------------------------------------
+// Typed fields and messages
+//-------------------------------------------------------------------------------------------------
+
+//! Typed attribute
+template <Key K, typename T>
+struct Field
+{
+    static_assert(K < KEY_COUNT, "Unknown schema key");
+    typedef T Type;
+
+    //! Return wire name
+    static const QString &name() { return Schema::name(K); }
+
+    //! Write value into node
+    static void write(CXMLNode &node, const T &value) { node.attributes().insert(Schema::name(K), Codec<T>::encode(value)); }
+
+    //! Read value from node, defaultValue if the peer did not send it (older schema)
+    static T read(const CXMLNode &node, const T &defaultValue=T())
+    {
+        QMap<QString, QString>::const_iterator it = node.attributes().constFind(Schema::name(K));
+        return it != node.attributes().constEnd() ? Codec<T>::decode(it.value()) : defaultValue;
+    }
+};
+
+//! Typed message (node tag)
+template <Key K>
+struct Message
+{
+    static_assert(K < KEY_COUNT, "Unknown schema key");
+    static constexpr Key TAG = K;
+
+    //! Return wire name
+    static const QString &name() { return Schema::name(K); }
+
+    //! Create an empty message node
+    static CXMLNode create() { return CXMLNode(Schema::name(K)); }
+
+    //! Return true if node is this message
+    static bool is(const CXMLNode &node) { return node.tag() == Schema::name(K); }
+
+    //! Retrieve this message among the children of node
+    static CXMLNode find(const CXMLNode &node) { return node.getNodeByTagName(Schema::name(K)); }
+};
+template <Key K> constexpr Key Message<K>::TAG;
+
+//! Drone handle (announced in drone status, accepted instead of the drone UID in any message targeting a drone, stale once the drone is gone)
+typedef Field<ATTR_DRONE_HANDLE, int> DroneHandle;
+
+//! Drone status
+struct DroneStatus : public Message<TAG_DRONE_STATUS>
+{
+    typedef Field<ATTR_DRONE_UID, QString> DroneUID;
+    typedef DroneHandle Handle;
+    typedef Field<ATTR_FLIGHT_STATUS, SpyCore::FlightStatus> FlightStatus;
+    typedef Field<ATTR_VIDEO_URL, QString> VideoUrl;
+    typedef Field<ATTR_TIMESTAMP, qint64> Timestamp;
+    typedef Field<ATTR_PROGRESS, double> Progress;
+};
+
+//! Position
+struct Position : public Message<TAG_POSITION>
+{
+    typedef Field<ATTR_LATITUDE, double> Latitude;
+    typedef Field<ATTR_LONGITUDE, double> Longitude;
+    typedef Field<ATTR_ALTITUDE, double> Altitude;
+    typedef Field<ATTR_HEADING, double> Heading;
+    typedef Field<ATTR_VELOCITY_NORTH, double> VelocityNorth;
+    typedef Field<ATTR_VELOCITY_EAST, double> VelocityEast;
+};
+
+//! Battery
+struct Battery : public Message<TAG_BATTERY>
+{
+    typedef Field<ATTR_LEVEL, double> Level;
+    typedef Field<ATTR_RETURN, double> Return;
+};
+
+//! Plan (mission, safety or landing)
+template <Key K>
+struct Plan : public Message<K>
+{
+    typedef Field<ATTR_DRONE_UID, QString> DroneUID;
+    typedef DroneHandle Handle;
+};
+typedef Plan<TAG_MISSION_PLAN> MissionPlan;
+typedef Plan<TAG_SAFETY_PLAN> SafetyPlan;
+typedef Plan<TAG_LANDING_PLAN> LandingPlan;
+
+//! Route request (way points to detour around exclusion areas) and its answer
+typedef Plan<TAG_ROUTE> Route;
+
+//! Trajectory pushed at take off (mission way points, flown from Progress m at simulation time Timestamp)
+struct Trajectory : public Plan<TAG_TRAJECTORY>
+{
+    typedef Field<ATTR_TIMESTAMP, qint64> Timestamp;
+    typedef Field<ATTR_PROGRESS, double> Progress;
+};
+
+//! Plan validation error (child of the plan echo)
+struct PlanError : public Message<TAG_PLAN_ERROR>
+{
+    typedef Field<ATTR_ERROR, int> Error;
+    typedef Field<ATTR_INDEX, int> Index;
+};
+
+//! Way point
+struct WayPoint : public Message<TAG_WAY_POINT>
+{
+    typedef Field<ATTR_LATITUDE, double> Latitude;
+    typedef Field<ATTR_LONGITUDE, double> Longitude;
+    typedef Field<ATTR_ALTITUDE, double> Altitude;
+    typedef Field<ATTR_WAY_POINT_TYPE, SpyCore::PointType> Type;
+    typedef Field<ATTR_WAY_POINT_SPEED, SpyCore::PointSpeed> Speed;
+    typedef Field<ATTR_WAY_POINT_CLOCKWISE, bool> ClockWise;
+};
+
+//! Way point metadata (pattern parameters of LOITER, EIGHT and HIPPODROM way points)
+struct WayPointMetaData : public Message<TAG_WAY_POINT_METADATA>
+{
+    typedef Field<ATTR_RADIUS, double> Radius;
+    typedef Field<ATTR_PATTERN_LENGTH, double> Length;
+    typedef Field<ATTR_PATTERN_TURNS, double> Turns;
+    typedef Field<ATTR_PATTERN_ORIENTATION, double> Orientation;
+};
+
+//! Exclusion area (circles, rectangles and triangles)
+typedef Plan<TAG_EXCLUSION_AREA> ExclusionArea;
+
+//! Exclusion circle
+struct Circle : public Message<TAG_CIRCLE>
+{
+    typedef Field<ATTR_LATITUDE, double> Latitude;
+    typedef Field<ATTR_LONGITUDE, double> Longitude;
+    typedef Field<ATTR_RADIUS, double> Radius;
+};
+
+//! Exclusion rectangle (top left and bottom right coordinates)
+struct Rectangle : public Message<TAG_RECTANGLE>
+{
+};
+
+//! Exclusion triangle (three coordinates)
+struct Triangle : public Message<TAG_TRIANGLE>
+{
+};
+
+//! Shape coordinate
+struct Coord : public Message<TAG_COORD>
+{
+    typedef Field<ATTR_LATITUDE, double> Latitude;
+    typedef Field<ATTR_LONGITUDE, double> Longitude;
+    typedef Field<ATTR_ALTITUDE, double> Altitude;
+};
+
+//! Geofence event (drone entered or left a zone)
+struct Geofence : public Message<TAG_GEOFENCE>
+{
+    typedef Field<ATTR_DRONE_UID, QString> DroneUID;
+    typedef Field<ATTR_ZONE, int> Zone;
+    typedef Field<ATTR_ZONE_TYPE, SpyCore::ZoneType> ZoneType;
+    typedef Field<ATTR_EVENT, SpyCore::GeofenceEvent> Event;
+};
+
+//! Proximity alert (two drones closer than the separation, or apart again)
+struct Proximity : public Message<TAG_PROXIMITY>
+{
+    typedef Field<ATTR_DRONE_UID, QString> DroneUID;
+    typedef Field<ATTR_OTHER_DRONE_UID, QString> OtherDroneUID;
+    typedef Field<ATTR_DISTANCE, double> Distance;
+    typedef Field<ATTR_CONFLICT, bool> Conflict;
+};
+
+//! Drone error
+struct DroneError : public Message<TAG_DRONE_ERROR>
+{
+    typedef Field<ATTR_DRONE_UID, QString> DroneUID;
+    typedef Field<ATTR_ERROR, int> Error;
+};
+
+//! Drone request (take off, fail safe...)
+template <Key K>
+struct DroneRequest : public Message<K>
+{
+    typedef Field<ATTR_DRONE_UID, QString> DroneUID;
+    typedef DroneHandle Handle;
+};
+typedef DroneRequest<TAG_TAKE_OFF> TakeOff;
+typedef DroneRequest<TAG_FAIL_SAFE> FailSafe;
+typedef DroneRequest<TAG_FAIL_SAFE_DONE> FailSafeDone;
+
+//! Batch envelope (list of messages processed as one unit, each wrapped in an entry)
+struct Batch : public Message<TAG_BATCH>
+{
+};
+
+//! Batch entry (one message, Index keeps its rank: JSON and CBOR group children by tag)
+struct BatchEntry : public Message<TAG_BATCH_ENTRY>
+{
+    typedef Field<ATTR_INDEX, int> Index;
+};
+
+//! Scenario file (explicit drones first, then generated ones up to Count on a grid around Latitude/Longitude, fleet plans and TAKEOFF as children)
+struct Scenario : public Message<TAG_SCENARIO>
+{
+    typedef Field<ATTR_COUNT, int> Count;
+    typedef Field<ATTR_UID_PREFIX, QString> UIDPrefix;
+    typedef Field<ATTR_LATITUDE, double> Latitude;
+    typedef Field<ATTR_LONGITUDE, double> Longitude;
+    typedef Field<ATTR_ALTITUDE, double> Altitude;
+    typedef Field<ATTR_SPACING, double> Spacing;
+    typedef Field<ATTR_VIDEO_URL, QString> VideoUrl;
+};
+
+//! Scenario drone (own plans and TAKEOFF as children, fleet ones otherwise)
+struct ScenarioDrone : public Message<TAG_DRONE>
+{
+    typedef Field<ATTR_DRONE_UID, QString> DroneUID;
+    typedef Field<ATTR_LATITUDE, double> Latitude;
+    typedef Field<ATTR_LONGITUDE, double> Longitude;
+    typedef Field<ATTR_ALTITUDE, double> Altitude;
+    typedef Field<ATTR_VIDEO_URL, QString> VideoUrl;
+};
+
+//! Run summary (headless runs, final drone statuses as children)
+struct Summary : public Message<TAG_SUMMARY>
+{
+    typedef Field<ATTR_SIMULATION_TIME, qint64> SimulationTime;
+    typedef Field<ATTR_WALL_TIME, qint64> WallTime;
+    typedef Field<ATTR_SPEED_UP, double> SpeedUp;
+    typedef Field<ATTR_TICKS, qint64> Ticks;
+    typedef Field<ATTR_OVERRUNS, qint64> Overruns;
+    typedef Field<ATTR_DRONES, int> Drones;
+    typedef Field<ATTR_FLYING, int> Flying;
+    typedef Field<ATTR_MIN_BATTERY, int> MinBattery;
+    typedef Field<ATTR_MEAN_BATTERY, double> MeanBattery;
+    typedef Field<ATTR_GEOFENCE_EVENTS, qint64> GeofenceEvents;
+    typedef Field<ATTR_PROXIMITY_ALERTS, qint64> ProximityAlerts;
+    typedef Field<ATTR_PROXIMITY_CONFLICTS, int> ProximityConflicts;
+    typedef Field<ATTR_PROXIMITY_MEAN_US, double> ProximityMeanUs;
+    typedef Field<ATTR_PROXIMITY_MAX_US, double> ProximityMaxUs;
+    typedef Field<ATTR_STATUS_CHANGES, qint64> StatusChanges;
+    typedef Field<ATTR_STATUS_HEARTBEATS, qint64> StatusHeartbeats;
+    typedef Field<ATTR_STARTUP_MS, qint64> StartupMs;
+};
+}
+}
+
+#endif // MESSAGESCHEMA_H
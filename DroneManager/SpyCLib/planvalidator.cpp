@@ -0,0 +1,445 @@
+// Qt
+#include <QtMath>
+#include <QGeoCircle>
+#include <QGeoRectangle>
+
+// Std
+#include <algorithm>
+#include <set>
+#include <limits>
+#include <iterator>
+
+// Application
+#include "planvalidator.h"
+#include "geoutils.h"
+#include "terraincache.h"
+#define MIN_SAFETY_POINTS 3
+#define MIN_MISSION_PLAN_POINTS 2
+#define LANDING_PLAN_POINTS 2 // Approach and touch down
+#define CLEARANCE_STEP 30. // Leg sampling (m), about the post spacing of 1 arc second tiles
+#define MAX_CLEARANCE_SAMPLES 10000 // Per leg
+using namespace Core;
+
+namespace {
+//! Sweep line segment (p is the leftmost end)
+struct SweepSegment
+{
+    QPointF p;
+    QPointF q;
+};
+
+//! Sweep line event
+struct SweepEvent
+{
+    double dX;
+    int iType; // 0: segment start, 1: segment end (starts first: segments touching at dX meet in the sweep)
+    double dY;
+    int iSegment;
+
+    bool operator<(const SweepEvent &other) const
+    {
+        if (dX != other.dX)
+            return dX < other.dX;
+        if (iType != other.iType)
+            return iType < other.iType;
+        return dY < other.dY;
+    }
+};
+
+//! Order of segments crossed by the sweep line (bottom to top at current sweep position, ties: just left of it, or just right for segments starting there)
+struct SweepOrder
+{
+    const QVector<SweepSegment> *pSegments;
+    const double *pSweepX;
+
+    static double yAt(const SweepSegment &segment, double dX)
+    {
+        if (segment.q.x() == segment.p.x())
+            return segment.p.y();
+        return segment.p.y()+(segment.q.y()-segment.p.y())*(dX-segment.p.x())/(segment.q.x()-segment.p.x());
+    }
+
+    static double slope(const SweepSegment &segment)
+    {
+        if (segment.q.x() == segment.p.x())
+            return std::numeric_limits<double>::infinity();
+        return (segment.q.y()-segment.p.y())/(segment.q.x()-segment.p.x());
+    }
+
+    bool operator()(int iA, int iB) const
+    {
+        if (iA == iB)
+            return false;
+        const SweepSegment &a = (*pSegments)[iA];
+        const SweepSegment &b = (*pSegments)[iB];
+        double dYA = yAt(a, *pSweepX);
+        double dYB = yAt(b, *pSweepX);
+        if (dYA != dYB)
+            return dYA < dYB;
+        // Segments meeting at the sweep line keep the order they had left of it (the steeper one was below)
+        double dSlopeA = a.p.x() < *pSweepX ? -slope(a) : slope(a);
+        double dSlopeB = b.p.x() < *pSweepX ? -slope(b) : slope(b);
+        if (dSlopeA != dSlopeB)
+            return dSlopeA < dSlopeB;
+        return iA < iB;
+    }
+};
+
+//! Return orientation of (a, b, c): 1 counterclockwise, -1 clockwise, 0 collinear
+int orientation(const QPointF &a, const QPointF &b, const QPointF &c)
+{
+    double dCross = (b.x()-a.x())*(c.y()-a.y())-(b.y()-a.y())*(c.x()-a.x());
+    return dCross > 0 ? 1 : (dCross < 0 ? -1 : 0);
+}
+
+//! Return true if collinear point c lies on segment [a, b]
+bool onSegment(const QPointF &a, const QPointF &b, const QPointF &c)
+{
+    return (c.x() >= qMin(a.x(), b.x())) && (c.x() <= qMax(a.x(), b.x())) && (c.y() >= qMin(a.y(), b.y())) && (c.y() <= qMax(a.y(), b.y()));
+}
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<PlanValidator::Issue> PlanValidator::validateSafetyPlan(const QGeoPath &safetyPlan)
+{
+    QVector<Issue> vIssues;
+    if (safetyPlan.size() == 0)
+        addIssue(vIssues, SpyCore::EMPTY_SAFETY);
+    else
+    if (safetyPlan.size() < MIN_SAFETY_POINTS)
+        addIssue(vIssues, SpyCore::NOT_ENOUGH_POINTS_IN_SAFETY);
+    else
+    {
+        int iSegment = findSelfIntersection(toPoints(safetyPlan), true);
+        if (iSegment >= 0)
+            addIssue(vIssues, SpyCore::SELF_INTERSECTING_SAFETY, iSegment);
+    }
+    return vIssues;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<PlanValidator::Issue> PlanValidator::validateMissionPlan(const QVector<WayPoint> &vWayPoints, const QGeoPath &safetyPlan, const QList<QGeoShape> &lExclusionArea, TerrainCache *pTerrain, double dClearance)
+{
+    QVector<Issue> vIssues;
+    if (vWayPoints.isEmpty())
+    {
+        addIssue(vIssues, SpyCore::EMPTY_MISSION_PLAN);
+        return vIssues;
+    }
+    if (vWayPoints.size() < MIN_MISSION_PLAN_POINTS)
+        addIssue(vIssues, SpyCore::NOT_ENOUGH_POINTS_IN_MISSION_PLAN);
+
+    // Mission plan is flown in a loop
+    QVector<QPointF> vPoints = toPoints(vWayPoints);
+    bool bClosed = vPoints.size() > 2;
+    int iSegment = findSelfIntersection(vPoints, bClosed);
+    if (iSegment >= 0)
+        addIssue(vIssues, SpyCore::SELF_INTERSECTING_MISSION_PLAN, iSegment);
+    checkLegs(vPoints, bClosed, safetyPlan, lExclusionArea, SpyCore::MISSION_PLAN_IN_EXCLUSION_AREA, SpyCore::MISSION_PLAN_OUTSIDE_SAFETY, vIssues);
+    if (pTerrain != nullptr)
+        checkClearance(vWayPoints, bClosed, pTerrain, dClearance, SpyCore::MISSION_PLAN_BELOW_TERRAIN, vIssues);
+    return vIssues;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<PlanValidator::Issue> PlanValidator::validateLandingPlan(const QVector<WayPoint> &vWayPoints, const QGeoPath &safetyPlan, const QList<QGeoShape> &lExclusionArea, TerrainCache *pTerrain, double dClearance)
+{
+    QVector<Issue> vIssues;
+    if (vWayPoints.isEmpty())
+    {
+        addIssue(vIssues, SpyCore::EMPTY_LANDING_PLAN);
+        return vIssues;
+    }
+    if (vWayPoints.size() != LANDING_PLAN_POINTS)
+        addIssue(vIssues, SpyCore::UNEXPECTED_LANDING_PLAN_COUNT);
+    checkLegs(toPoints(vWayPoints), false, safetyPlan, lExclusionArea, SpyCore::LANDING_PLAN_IN_EXCLUSION_AREA, SpyCore::LANDING_PLAN_OUTSIDE_SAFETY, vIssues);
+
+    // Touch down is on the ground: only the approach is checked
+    if ((pTerrain != nullptr) && (vWayPoints.size() > 1))
+        checkClearance(vWayPoints.mid(0, 1), false, pTerrain, dClearance, SpyCore::LANDING_PLAN_BELOW_TERRAIN, vIssues);
+    return vIssues;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int PlanValidator::findSelfIntersection(const QVector<QPointF> &vPoints, bool bClosed)
+{
+    int iPointCount = vPoints.size();
+    int iSegmentCount = bClosed ? iPointCount : iPointCount-1;
+    if (iSegmentCount < 2)
+        return -1;
+
+    // Segments, left end first
+    QVector<SweepSegment> vSegments(iSegmentCount);
+    QVector<SweepEvent> vEvents;
+    vEvents.reserve(2*iSegmentCount);
+    for (int i=0; i<iSegmentCount; i++)
+    {
+        QPointF from = vPoints[i];
+        QPointF to = vPoints[(i+1)%iPointCount];
+        bool bSwap = (to.x() < from.x()) || ((to.x() == from.x()) && (to.y() < from.y()));
+        vSegments[i].p = bSwap ? to : from;
+        vSegments[i].q = bSwap ? from : to;
+        SweepEvent startEvent = {vSegments[i].p.x(), 0, vSegments[i].p.y(), i};
+        SweepEvent endEvent = {vSegments[i].q.x(), 1, vSegments[i].q.y(), i};
+        vEvents << startEvent << endEvent;
+    }
+    std::sort(vEvents.begin(), vEvents.end());
+
+    // Consecutive segments share a way point: that is not a crossing, unless the path turns back on itself
+    auto crossing = [&](int iA, int iB) {
+        int iFirst = -1;
+        if ((iB == iA+1) || (bClosed && (iA == iSegmentCount-1) && (iB == 0)))
+            iFirst = iA;
+        else
+        if ((iA == iB+1) || (bClosed && (iB == iSegmentCount-1) && (iA == 0)))
+            iFirst = iB;
+        if (iFirst < 0)
+            return segmentsIntersect(vSegments[iA].p, vSegments[iA].q, vSegments[iB].p, vSegments[iB].q);
+        const QPointF &previous = vPoints[iFirst];
+        const QPointF &shared = vPoints[(iFirst+1)%iPointCount];
+        const QPointF &next = vPoints[(iFirst+2)%iPointCount];
+        return (orientation(previous, shared, next) == 0) &&
+               ((previous.x()-shared.x())*(next.x()-shared.x())+(previous.y()-shared.y())*(next.y()-shared.y()) > 0);
+    };
+
+    // Shamos-Hoeffding: the first crossing is between segments that are neighbours in the sweep order
+    double dSweepX = 0;
+    SweepOrder order = {&vSegments, &dSweepX};
+    typedef std::set<int, SweepOrder> SweepStatus;
+    SweepStatus status(order);
+    QVector<SweepStatus::iterator> vPositions(iSegmentCount);
+    foreach (const SweepEvent &event, vEvents)
+    {
+        dSweepX = event.dX;
+        int iSegment = event.iSegment;
+        if (event.iType == 0)
+        {
+            SweepStatus::iterator it = status.insert(iSegment).first;
+            vPositions[iSegment] = it;
+            if (it != status.begin())
+            {
+                SweepStatus::iterator itBelow = std::prev(it);
+                if (crossing(*itBelow, iSegment))
+                    return qMin(*itBelow, iSegment);
+            }
+            SweepStatus::iterator itAbove = std::next(it);
+            if ((itAbove != status.end()) && crossing(*itAbove, iSegment))
+                return qMin(*itAbove, iSegment);
+        }
+        else
+        {
+            SweepStatus::iterator it = vPositions[iSegment];
+            if ((it != status.begin()) && (std::next(it) != status.end()))
+            {
+                int iBelow = *std::prev(it);
+                int iAbove = *std::next(it);
+                if (crossing(iBelow, iAbove))
+                    return qMin(iBelow, iAbove);
+            }
+            status.erase(it);
+        }
+    }
+    return -1;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool PlanValidator::segmentsIntersect(const QPointF &a1, const QPointF &a2, const QPointF &b1, const QPointF &b2)
+{
+    int iO1 = orientation(a1, a2, b1);
+    int iO2 = orientation(a1, a2, b2);
+    int iO3 = orientation(b1, b2, a1);
+    int iO4 = orientation(b1, b2, a2);
+    if ((iO1 != iO2) && (iO3 != iO4))
+        return true;
+    return ((iO1 == 0) && onSegment(a1, a2, b1)) || ((iO2 == 0) && onSegment(a1, a2, b2)) ||
+           ((iO3 == 0) && onSegment(b1, b2, a1)) || ((iO4 == 0) && onSegment(b1, b2, a2));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool PlanValidator::contains(const QVector<QPointF> &vPolygon, const QPointF &point)
+{
+    bool bInside = false;
+    int iCount = vPolygon.size();
+    for (int i=0, j=iCount-1; i<iCount; j=i++)
+    {
+        const QPointF &pi = vPolygon[i];
+        const QPointF &pj = vPolygon[j];
+        if ((pi.y() > point.y()) != (pj.y() > point.y()))
+        {
+            double dCrossing = pi.x()+(point.y()-pi.y())*(pj.x()-pi.x())/(pj.y()-pi.y());
+            if (point.x() < dCrossing)
+                bInside = !bInside;
+        }
+    }
+    return bInside;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<QPointF> PlanValidator::toPoints(const QVector<WayPoint> &vWayPoints)
+{
+    QVector<QPointF> vPoints;
+    vPoints.reserve(vWayPoints.size());
+    foreach (const WayPoint &wayPoint, vWayPoints)
+        vPoints << QPointF(wayPoint.point().dLongitude, wayPoint.point().dLatitude);
+    return vPoints;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<QPointF> PlanValidator::toPoints(const QGeoPath &geoPath)
+{
+    QVector<QPointF> vPoints;
+    vPoints.reserve(geoPath.size());
+    for (int i=0; i<geoPath.size(); i++)
+        vPoints << QPointF(geoPath.coordinateAt(i).longitude(), geoPath.coordinateAt(i).latitude());
+    return vPoints;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void PlanValidator::checkLegs(const QVector<QPointF> &vPoints, bool bClosed, const QGeoPath &safetyPlan, const QList<QGeoShape> &lExclusionArea,
+                              SpyCore::MissionPlanError eExclusionError, SpyCore::MissionPlanError eSafetyError, QVector<Issue> &vIssues)
+{
+    int iPointCount = vPoints.size();
+    int iLegCount = bClosed ? iPointCount : iPointCount-1;
+    QVector<QPointF> vSafety = toPoints(safetyPlan);
+    bool bCheckSafety = vSafety.size() >= MIN_SAFETY_POINTS;
+
+    // Way points inside safety plan
+    for (int i=0; bCheckSafety && (i<iPointCount); i++)
+    {
+        if (!contains(vSafety, vPoints[i]))
+        {
+            addIssue(vIssues, eSafetyError, i);
+            bCheckSafety = false;
+        }
+    }
+
+    // Legs: no crossing of the safety plan border, no exclusion area on the way (one issue per kind)
+    bool bCheckExclusion = !lExclusionArea.isEmpty();
+    for (int i=0; (bCheckSafety || bCheckExclusion) && (i<iLegCount); i++)
+    {
+        const QPointF &from = vPoints[i];
+        const QPointF &to = vPoints[(i+1)%iPointCount];
+        for (int j=0; bCheckSafety && (j<vSafety.size()); j++)
+        {
+            if (segmentsIntersect(from, to, vSafety[j], vSafety[(j+1)%vSafety.size()]))
+            {
+                addIssue(vIssues, eSafetyError, i);
+                bCheckSafety = false;
+            }
+        }
+        foreach (const QGeoShape &shape, lExclusionArea)
+        {
+            if (bCheckExclusion && crosses(from, to, shape))
+            {
+                addIssue(vIssues, eExclusionError, i);
+                bCheckExclusion = false;
+            }
+        }
+    }
+
+    // Single way point plans have no leg
+    if (bCheckExclusion && (iLegCount <= 0) && (iPointCount == 1))
+    {
+        foreach (const QGeoShape &shape, lExclusionArea)
+        {
+            if (bCheckExclusion && crosses(vPoints.first(), vPoints.first(), shape))
+            {
+                addIssue(vIssues, eExclusionError, 0);
+                bCheckExclusion = false;
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool PlanValidator::crosses(const QPointF &from, const QPointF &to, const QGeoShape &shape)
+{
+    QVector<QPointF> vPolygon;
+    if (shape.type() == QGeoShape::CircleType)
+    {
+        // Closest point of the segment to the center, in a local plane around the center (m)
+        QGeoCircle circle(shape);
+        double dCosLatitude = qCos(qDegreesToRadians(circle.center().latitude()));
+        double dScale = qDegreesToRadians(EARTH_RADIUS);
+        double dFromX = (from.x()-circle.center().longitude())*dCosLatitude*dScale;
+        double dFromY = (from.y()-circle.center().latitude())*dScale;
+        double dDeltaX = (to.x()-from.x())*dCosLatitude*dScale;
+        double dDeltaY = (to.y()-from.y())*dScale;
+        double dLength = dDeltaX*dDeltaX+dDeltaY*dDeltaY;
+        double dT = dLength > 0 ? qBound(0., -(dFromX*dDeltaX+dFromY*dDeltaY)/dLength, 1.) : 0.;
+        double dX = dFromX+dT*dDeltaX;
+        double dY = dFromY+dT*dDeltaY;
+        return dX*dX+dY*dY <= circle.radius()*circle.radius();
+    }
+    else
+    if (shape.type() == QGeoShape::RectangleType)
+    {
+        QGeoRectangle rectangle(shape);
+        vPolygon << QPointF(rectangle.topLeft().longitude(), rectangle.topLeft().latitude())
+                 << QPointF(rectangle.bottomRight().longitude(), rectangle.topLeft().latitude())
+                 << QPointF(rectangle.bottomRight().longitude(), rectangle.bottomRight().latitude())
+                 << QPointF(rectangle.topLeft().longitude(), rectangle.bottomRight().latitude());
+    }
+    else
+    if (shape.type() == QGeoShape::PathType)
+        vPolygon = toPoints(QGeoPath(shape));
+    if (vPolygon.size() < 3)
+        return false;
+
+    // Inside, or through an edge
+    if (contains(vPolygon, from) || contains(vPolygon, to))
+        return true;
+    for (int i=0; i<vPolygon.size(); i++)
+        if (segmentsIntersect(from, to, vPolygon[i], vPolygon[(i+1)%vPolygon.size()]))
+            return true;
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void PlanValidator::checkClearance(const QVector<WayPoint> &vWayPoints, bool bClosed, TerrainCache *pTerrain, double dClearance, SpyCore::MissionPlanError eError, QVector<Issue> &vIssues)
+{
+    // Way point alone (single point plan): leg of zero length
+    int iPointCount = vWayPoints.size();
+    int iLegCount = bClosed ? iPointCount : qMax(iPointCount-1, 1);
+    for (int i=0; i<iLegCount; i++)
+    {
+        const GeoPoint &from = vWayPoints[i].point();
+        const GeoPoint &to = vWayPoints[(i+1)%iPointCount].point();
+        if (qIsNaN(from.dAltitude) || qIsNaN(to.dAltitude))
+            continue;
+
+        // Samples, both ends included
+        int iSampleCount = qBound(1, qCeil(GeoUtils::distance(from, to)/CLEARANCE_STEP), MAX_CLEARANCE_SAMPLES);
+        for (int j=0; j<=iSampleCount; j++)
+        {
+            GeoPoint sample = GeoUtils::interpolate(from, to, (double)j/iSampleCount);
+            double dGround = pTerrain->elevation(sample.dLatitude, sample.dLongitude);
+            if (!qIsNaN(dGround) && (sample.dAltitude < dGround+dClearance))
+            {
+                addIssue(vIssues, eError, i);
+                break;
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void PlanValidator::addIssue(QVector<Issue> &vIssues, SpyCore::MissionPlanError eError, int iIndex)
+{
+    Issue issue;
+    issue.eError = eError;
+    issue.iIndex = iIndex;
+    vIssues << issue;
+}
@@ -0,0 +1,69 @@
+#ifndef PLANVALIDATOR_H
+#define PLANVALIDATOR_H
+
+// Qt
+#include <QVector>
+#include <QList>
+#include <QPointF>
+#include <QGeoPath>
+#include <QGeoShape>
+
+// Application
+#include "waypoint.h"
+#include "spycore.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class TerrainCache;
+class SPYCLIBSHARED_EXPORT PlanValidator
+{
+public:
+    //! Validation issue
+    struct Issue
+    {
+        //! Error
+        SpyCore::MissionPlanError eError = SpyCore::EMPTY_MISSION_PLAN;
+
+        //! Offending way point or leg (leg i goes from way point i to the next one), -1 for the whole plan
+        int iIndex = -1;
+    };
+
+    //! Check safety plan: point count, self intersection
+    static QVector<Issue> validateSafetyPlan(const QGeoPath &safetyPlan);
+
+    //! Check mission plan: point count, self intersection, exclusion areas, containment in safety plan, terrain clearance (if pTerrain is set)
+    static QVector<Issue> validateMissionPlan(const QVector<WayPoint> &vWayPoints, const QGeoPath &safetyPlan, const QList<QGeoShape> &lExclusionArea, TerrainCache *pTerrain=nullptr, double dClearance=0);
+
+    //! Check landing plan: point count, exclusion areas, containment in safety plan, terrain clearance of the approach (if pTerrain is set)
+    static QVector<Issue> validateLandingPlan(const QVector<WayPoint> &vWayPoints, const QGeoPath &safetyPlan, const QList<QGeoShape> &lExclusionArea, TerrainCache *pTerrain=nullptr, double dClearance=0);
+
+    //! Return index of a segment crossing another non adjacent one (sweep line, O(n log n)), -1 if none
+    static int findSelfIntersection(const QVector<QPointF> &vPoints, bool bClosed);
+
+    //! Return true if segments [a1, a2] and [b1, b2] intersect (touching included)
+    static bool segmentsIntersect(const QPointF &a1, const QPointF &a2, const QPointF &b1, const QPointF &b2);
+
+    //! Return true if point is inside polygon (even-odd rule)
+    static bool contains(const QVector<QPointF> &vPolygon, const QPointF &point);
+
+private:
+    //! Return points of a plan (x: longitude, y: latitude)
+    static QVector<QPointF> toPoints(const QVector<WayPoint> &vWayPoints);
+    static QVector<QPointF> toPoints(const QGeoPath &geoPath);
+
+    //! Check legs against exclusion areas and safety plan
+    static void checkLegs(const QVector<QPointF> &vPoints, bool bClosed, const QGeoPath &safetyPlan, const QList<QGeoShape> &lExclusionArea,
+                          SpyCore::MissionPlanError eExclusionError, SpyCore::MissionPlanError eSafetyError, QVector<Issue> &vIssues);
+
+    //! Check legs stay dClearance m above ground (legs with unknown altitudes are skipped)
+    static void checkClearance(const QVector<WayPoint> &vWayPoints, bool bClosed, TerrainCache *pTerrain, double dClearance, SpyCore::MissionPlanError eError, QVector<Issue> &vIssues);
+
+    //! Return true if segment crosses exclusion shape
+    static bool crosses(const QPointF &from, const QPointF &to, const QGeoShape &shape);
+
+    //! Append issue
+    static void addIssue(QVector<Issue> &vIssues, SpyCore::MissionPlanError eError, int iIndex=-1);
+};
+}
+
+#endif // PLANVALIDATOR_H
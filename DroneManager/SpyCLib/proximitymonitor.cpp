@@ -0,0 +1,212 @@
+// Qt
+#include <QtMath>
+#include <QElapsedTimer>
+#include <QDebug>
+
+// Application
+#include "proximitymonitor.h"
+#include "simulationscheduler.h"
+#include "fleetstate.h"
+#include "geoutils.h"
+#define CLEARING_FACTOR 1.2 // Conflict is cleared beyond separation*CLEARING_FACTOR (no alert flicker)
+#define MIN_SEPARATION 1.
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+ProximityMonitor::ProximityMonitor(SimulationScheduler *pScheduler, FleetState *pFleetState, double dSeparation, int iPeriodMs, QObject *pParent) : QObject(pParent),
+    m_pScheduler(pScheduler), m_pFleetState(pFleetState)
+{
+    setSeparation(dSeparation);
+    m_iTaskId = m_pScheduler->addTask(iPeriodMs, [this]() { check(); });
+}
+
+//-------------------------------------------------------------------------------------------------
+
+ProximityMonitor::~ProximityMonitor()
+{
+    m_pScheduler->removeTask(m_iTaskId);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void ProximityMonitor::setSeparation(double dSeparation)
+{
+    m_dSeparation = qMax(dSeparation, MIN_SEPARATION);
+    m_dCellSize = m_dSeparation*CLEARING_FACTOR;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double ProximityMonitor::separation() const
+{
+    return m_dSeparation;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const ProximityMonitor::Counters &ProximityMonitor::counters() const
+{
+    return m_counters;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void ProximityMonitor::check()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Broad phase: a drone can only be in conflict with drones of its own and the 8 surrounding cells
+    buildHash();
+    QSet<quint64> sConflicts;
+    qint64 iPairTests = 0;
+    const double *pLatitudes = m_pFleetState->latitudes();
+    const double *pLongitudes = m_pFleetState->longitudes();
+    foreach (int iSlot, m_vHashed)
+    {
+        for (int iRow=m_vRow[iSlot]-1; iRow<=m_vRow[iSlot]+1; iRow++)
+        {
+            // Rows have their own column count: neighbours are around the drone longitude in that row (wrapping at the antimeridian)
+            int iColumnCount = columnCount(iRow);
+            int iColumn = column(pLongitudes[iSlot], iColumnCount);
+            for (int i=0; i<qMin(3, iColumnCount); i++)
+            {
+                QHash<quint64, int>::const_iterator it = m_hCells.constFind(cellKey((iColumn-1+i+iColumnCount)%iColumnCount, iRow));
+                if (it == m_hCells.constEnd())
+                    continue;
+
+                // Narrow phase (each pair once)
+                for (int iOtherSlot=it.value(); iOtherSlot>=0; iOtherSlot=m_vNext[iOtherSlot])
+                {
+                    if (iOtherSlot <= iSlot)
+                        continue;
+                    double dNorth = EARTH_RADIUS*qDegreesToRadians(qAbs(pLatitudes[iOtherSlot]-pLatitudes[iSlot]));
+                    double dEast = EARTH_RADIUS*qDegreesToRadians(qAbs(GeoUtils::wrapLongitude(pLongitudes[iOtherSlot]-pLongitudes[iSlot])))*
+                            qCos(qDegreesToRadians(qMax(qAbs(pLatitudes[iSlot]), qAbs(pLatitudes[iOtherSlot]))));
+                    if ((dNorth > m_dCellSize) || (dEast > m_dCellSize))
+                        continue;
+                    iPairTests++;
+                    double dDistance = distance(iSlot, iOtherSlot);
+                    quint64 iPairKey = pairKey(iSlot, iOtherSlot);
+                    bool bWasInConflict = m_sConflicts.contains(iPairKey);
+                    if ((dDistance < m_dSeparation) || (bWasInConflict && (dDistance < m_dCellSize)))
+                    {
+                        sConflicts.insert(iPairKey);
+                        if (!bWasInConflict)
+                        {
+                            m_counters.iAlerts++;
+                            emit proximityChanged(iSlot, iOtherSlot, dDistance, true);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Conflicts not found again are over (drones apart, landed or removed)
+    foreach (quint64 iPairKey, m_sConflicts)
+    {
+        if (sConflicts.contains(iPairKey))
+            continue;
+        int iSlot = (int)(iPairKey >> 32);
+        int iOtherSlot = (int)(iPairKey & 0xFFFFFFFF);
+        bool bValid = (iOtherSlot < m_pFleetState->slotCount()) && m_pFleetState->isActive(iSlot) && m_pFleetState->isActive(iOtherSlot);
+        emit proximityChanged(iSlot, iOtherSlot, bValid ? distance(iSlot, iOtherSlot) : -1, false);
+    }
+    m_sConflicts = sConflicts;
+
+    // Counters
+    qint64 iElapsedNs = timer.nsecsElapsed();
+    m_counters.iChecks++;
+    m_counters.iLastNs = iElapsedNs;
+    m_counters.iMaxNs = qMax(m_counters.iMaxNs, iElapsedNs);
+    m_counters.iTotalNs += iElapsedNs;
+    m_counters.iDrones = m_vHashed.size();
+    m_counters.iPairTests = iPairTests;
+    m_counters.iConflicts = m_sConflicts.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void ProximityMonitor::buildHash()
+{
+    int iSlotCount = m_pFleetState->slotCount();
+    m_vColumn.resize(iSlotCount);
+    m_vRow.resize(iSlotCount);
+    m_vNext.resize(iSlotCount);
+    m_vHashed.clear();
+    m_hCells.clear();
+
+    const uchar *pActive = m_pFleetState->activeFlags();
+    const double *pLatitudes = m_pFleetState->latitudes();
+    const double *pLongitudes = m_pFleetState->longitudes();
+    for (int iSlot=0; iSlot<iSlotCount; iSlot++)
+    {
+        if (!pActive[iSlot] || (m_pFleetState->flightStatus(iSlot) != SpyCore::FLYING))
+            continue;
+
+        // Rows are latitude bands one cell high, cut into as many columns as fit around the earth at that latitude
+        m_vRow[iSlot] = qFloor(EARTH_RADIUS*qDegreesToRadians(pLatitudes[iSlot])/m_dCellSize);
+        m_vColumn[iSlot] = column(pLongitudes[iSlot], columnCount(m_vRow[iSlot]));
+
+        // Prepend to cell list
+        quint64 iKey = cellKey(m_vColumn[iSlot], m_vRow[iSlot]);
+        QHash<quint64, int>::iterator it = m_hCells.find(iKey);
+        if (it == m_hCells.end())
+        {
+            m_vNext[iSlot] = -1;
+            m_hCells.insert(iKey, iSlot);
+        }
+        else
+        {
+            m_vNext[iSlot] = it.value();
+            it.value() = iSlot;
+        }
+        m_vHashed << iSlot;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int ProximityMonitor::columnCount(int iRow) const
+{
+    // Columns are at least one cell wide over the row and both its neighbours (a neighbour is then at most one column away)
+    double dLowest = (iRow-1)*m_dCellSize/EARTH_RADIUS;
+    double dHighest = (iRow+2)*m_dCellSize/EARTH_RADIUS;
+    double dMaxLatitude = qMin(qMax(qAbs(dLowest), qAbs(dHighest)), M_PI/2);
+    return qMax(1, qFloor(2*M_PI*EARTH_RADIUS*qCos(dMaxLatitude)/m_dCellSize));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int ProximityMonitor::column(double dLongitude, int iColumnCount)
+{
+    double dTurn = (GeoUtils::wrapLongitude(dLongitude)+180)/360;
+    return qMin(iColumnCount-1, qFloor(dTurn*iColumnCount));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double ProximityMonitor::distance(int iSlot, int iOtherSlot) const
+{
+    double dDistance = GeoUtils::distance(m_pFleetState->point(iSlot), m_pFleetState->point(iOtherSlot));
+    double dHeight = m_pFleetState->altitude(iSlot)-m_pFleetState->altitude(iOtherSlot);
+    if (qIsNaN(dHeight))
+        return dDistance;
+    return qSqrt(dDistance*dDistance+dHeight*dHeight);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+quint64 ProximityMonitor::cellKey(int iColumn, int iRow)
+{
+    return ((quint64)(quint32)iColumn << 32) | (quint64)(quint32)iRow;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+quint64 ProximityMonitor::pairKey(int iSlot, int iOtherSlot)
+{
+    return ((quint64)qMin(iSlot, iOtherSlot) << 32) | (quint64)qMax(iSlot, iOtherSlot);
+}
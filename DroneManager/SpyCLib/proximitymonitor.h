@@ -0,0 +1,139 @@
+#ifndef PROXIMITYMONITOR_H
+#define PROXIMITYMONITOR_H
+
+// Qt
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+// Application
+#include "spyclib_global.h"
+
+namespace Core {
+class SimulationScheduler;
+class FleetState;
+class SPYCLIBSHARED_EXPORT ProximityMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Timing and workload counters
+    struct Counters
+    {
+        //! Checks run
+        qint64 iChecks = 0;
+
+        //! Duration of last check (ns)
+        qint64 iLastNs = 0;
+
+        //! Longest check (ns)
+        qint64 iMaxNs = 0;
+
+        //! Total check time (ns)
+        qint64 iTotalNs = 0;
+
+        //! Drones hashed by last check
+        int iDrones = 0;
+
+        //! Pairs measured by last check (narrow phase)
+        qint64 iPairTests = 0;
+
+        //! Pairs in conflict after last check
+        int iConflicts = 0;
+
+        //! Alerts raised so far
+        qint64 iAlerts = 0;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor
+    ProximityMonitor(SimulationScheduler *pScheduler, FleetState *pFleetState, double dSeparation=50, int iPeriodMs=100, QObject *pParent=nullptr);
+
+    //! Destructor
+    ~ProximityMonitor();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Set minimum separation (m)
+    void setSeparation(double dSeparation);
+
+    //! Return minimum separation (m)
+    double separation() const;
+
+    //! Return counters
+    const Counters &counters() const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Check every flying drone against its neighbours
+    void check();
+
+private:
+    //! Hash flying drones into cells of the conflict clearing distance
+    void buildHash();
+
+    //! Return number of columns of a row (latitude band one cell high)
+    int columnCount(int iRow) const;
+
+    //! Return column of a longitude (deg) in a row of iColumnCount columns, from the antimeridian eastwards
+    static int column(double dLongitude, int iColumnCount);
+
+    //! Return distance between two slots (m, altitude included when known)
+    double distance(int iSlot, int iOtherSlot) const;
+
+    //! Return cell key
+    static quint64 cellKey(int iColumn, int iRow);
+
+    //! Return pair key (smallest slot first)
+    static quint64 pairKey(int iSlot, int iOtherSlot);
+
+private:
+    //! Scheduler
+    SimulationScheduler *m_pScheduler = nullptr;
+
+    //! Fleet state
+    FleetState *m_pFleetState = nullptr;
+
+    //! Check task id
+    int m_iTaskId = -1;
+
+    //! Minimum separation
+    double m_dSeparation = 50;
+
+    //! Cell size (conflict clearing distance)
+    double m_dCellSize = 50;
+
+    //! Cell of each slot
+    QVector<int> m_vColumn;
+    QVector<int> m_vRow;
+
+    //! Next slot in the same cell (-1: last)
+    QVector<int> m_vNext;
+
+    //! Flying slots hashed by last check
+    QVector<int> m_vHashed;
+
+    //! First slot of each cell
+    QHash<quint64, int> m_hCells;
+
+    //! Pairs in conflict
+    QSet<quint64> m_sConflicts;
+
+    //! Counters
+    Counters m_counters;
+
+signals:
+    //! Two drones came closer than the separation (bConflict) or moved apart again
+    void proximityChanged(int iSlot, int iOtherSlot, double dDistance, bool bConflict);
+};
+}
+
+#endif // PROXIMITYMONITOR_H
@@ -0,0 +1,505 @@
+// Qt
+#include <QtMath>
+#include <QGeoCircle>
+#include <QGeoRectangle>
+#include <QGeoPath>
+
+// Std
+#include <queue>
+#include <algorithm>
+#include <limits>
+#include <functional>
+
+// Application
+#include "routeplanner.h"
+#include "planvalidator.h"
+#include "geoutils.h"
+#define CIRCLE_SIDES 16 // Circles are approximated by their circumscribed polygon
+#define NODE_MARGIN 1. // Graph nodes lie this far (m) outside the buffered areas, so that detours never graze them
+#define MIN_MITER 0.25 // Miter limit: sharper convex corners are clipped (offset vertex at most 1/sqrt(MIN_MITER/2) times farther)
+#define MAX_CACHED_LEGS 65536
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+RoutePlanner::RoutePlanner(double dBuffer, int iMaxGraphs) : m_dBuffer(qMax(dBuffer, 0.)), m_iMaxGraphs(qMax(iMaxGraphs, 1))
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+RoutePlanner::~RoutePlanner()
+{
+    clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void RoutePlanner::setBuffer(double dBuffer)
+{
+    m_dBuffer = qMax(dBuffer, 0.);
+    clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double RoutePlanner::buffer() const
+{
+    return m_dBuffer;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int RoutePlanner::graphCount() const
+{
+    return m_hGraphs.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool RoutePlanner::route(const QVector<WayPoint> &vWayPoints, const QList<QGeoShape> &lExclusionArea, bool bClosed, QVector<WayPoint> &vRoute, QVector<int> &vUnroutedLegs)
+{
+    vRoute.clear();
+    vUnroutedLegs.clear();
+    if (lExclusionArea.isEmpty() || (vWayPoints.size() < 2))
+    {
+        vRoute = vWayPoints;
+        return true;
+    }
+
+    Graph *pGraph = graph(lExclusionArea);
+    int iPointCount = vWayPoints.size();
+    int iLegCount = bClosed ? iPointCount : iPointCount-1;
+    vRoute.reserve(iPointCount);
+    for (int i=0; i<iPointCount; i++)
+    {
+        vRoute << vWayPoints[i];
+        if (i >= iLegCount)
+            continue;
+
+        // Detour way points fly at the speed of the leg (a leg flies at the speed of its start way point)
+        const WayPoint &next = vWayPoints[(i+1)%iPointCount];
+        QVector<QGeoCoordinate> vDetour;
+        if (!detour(*pGraph, vWayPoints[i].geoCoord(), next.geoCoord(), vDetour))
+        {
+            vUnroutedLegs << i;
+            continue;
+        }
+        foreach (const QGeoCoordinate &geoCoord, vDetour)
+        {
+            WayPoint wayPoint(geoCoord, SpyCore::POINT);
+            wayPoint.setSpeed(vWayPoints[i].speed());
+            vRoute << wayPoint;
+        }
+    }
+    return vUnroutedLegs.isEmpty();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool RoutePlanner::findPath(const QGeoCoordinate &from, const QGeoCoordinate &to, const QList<QGeoShape> &lExclusionArea, QVector<QGeoCoordinate> &vDetour)
+{
+    vDetour.clear();
+    if (lExclusionArea.isEmpty())
+        return true;
+    return detour(*graph(lExclusionArea), from, to, vDetour);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void RoutePlanner::clear()
+{
+    qDeleteAll(m_hGraphs);
+    m_hGraphs.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+RoutePlanner::Graph *RoutePlanner::graph(const QList<QGeoShape> &lExclusionArea)
+{
+    // Cached
+    uint iKey = exclusionKey(lExclusionArea);
+    Graph *pGraph = m_hGraphs.value(iKey, nullptr);
+    if ((pGraph != nullptr) && (pGraph->lExclusionArea == lExclusionArea))
+    {
+        pGraph->iLastUse = ++m_iUseCounter;
+        return pGraph;
+    }
+    delete pGraph;
+
+    // Evict least recently used graph
+    m_hGraphs.remove(iKey);
+    if (m_hGraphs.size() >= m_iMaxGraphs)
+    {
+        QHash<uint, Graph *>::iterator itOldest = m_hGraphs.begin();
+        for (QHash<uint, Graph *>::iterator it=m_hGraphs.begin(); it!=m_hGraphs.end(); ++it)
+            if (it.value()->iLastUse < itOldest.value()->iLastUse)
+                itOldest = it;
+        delete itOldest.value();
+        m_hGraphs.erase(itOldest);
+    }
+
+    pGraph = buildGraph(lExclusionArea);
+    pGraph->iLastUse = ++m_iUseCounter;
+    m_hGraphs.insert(iKey, pGraph);
+    return pGraph;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+RoutePlanner::Graph *RoutePlanner::buildGraph(const QList<QGeoShape> &lExclusionArea) const
+{
+    Graph *pGraph = new Graph;
+    pGraph->lExclusionArea = lExclusionArea;
+
+    // Local plane around the first area (equirectangular: exact enough at mission scale)
+    pGraph->origin = lExclusionArea.first().center();
+    pGraph->dMetersPerLatitude = qDegreesToRadians(EARTH_RADIUS);
+    pGraph->dMetersPerLongitude = pGraph->dMetersPerLatitude*qCos(qDegreesToRadians(pGraph->origin.latitude()));
+
+    // Obstacles (areas grown by the buffer) and candidate nodes (their corners, slightly further out)
+    QVector<QPointF> vCorners;
+    pGraph->dMinX = pGraph->dMinY = std::numeric_limits<double>::max();
+    pGraph->dMaxX = pGraph->dMaxY = -std::numeric_limits<double>::max();
+    foreach (const QGeoShape &shape, lExclusionArea)
+    {
+        Obstacle obstacle;
+        obstacle.vPolygon = polygon(*pGraph, shape, m_dBuffer);
+        if (obstacle.vPolygon.size() < 3)
+            continue;
+        obstacle.dMinX = obstacle.dMinY = std::numeric_limits<double>::max();
+        obstacle.dMaxX = obstacle.dMaxY = -std::numeric_limits<double>::max();
+        foreach (const QPointF &point, obstacle.vPolygon)
+        {
+            obstacle.dMinX = qMin(obstacle.dMinX, point.x());
+            obstacle.dMinY = qMin(obstacle.dMinY, point.y());
+            obstacle.dMaxX = qMax(obstacle.dMaxX, point.x());
+            obstacle.dMaxY = qMax(obstacle.dMaxY, point.y());
+        }
+        pGraph->dMinX = qMin(pGraph->dMinX, obstacle.dMinX);
+        pGraph->dMinY = qMin(pGraph->dMinY, obstacle.dMinY);
+        pGraph->dMaxX = qMax(pGraph->dMaxX, obstacle.dMaxX);
+        pGraph->dMaxY = qMax(pGraph->dMaxY, obstacle.dMaxY);
+        pGraph->vObstacles << obstacle;
+        vCorners << polygon(*pGraph, shape, m_dBuffer+NODE_MARGIN);
+    }
+
+    // Corners swallowed by an overlapping area are useless
+    foreach (const QPointF &corner, vCorners)
+        if (!isBlocked(*pGraph, corner))
+            pGraph->vNodes << corner;
+
+    // Edges between mutually visible nodes
+    int iNodeCount = pGraph->vNodes.size();
+    pGraph->vAdjacency.resize(iNodeCount);
+    for (int i=0; i<iNodeCount; i++)
+    {
+        for (int j=i+1; j<iNodeCount; j++)
+        {
+            if (!isVisible(*pGraph, pGraph->vNodes[i], pGraph->vNodes[j]))
+                continue;
+            QPointF delta = pGraph->vNodes[j]-pGraph->vNodes[i];
+            Edge edge;
+            edge.dLength = qSqrt(delta.x()*delta.x()+delta.y()*delta.y());
+            edge.iNode = j;
+            pGraph->vAdjacency[i] << edge;
+            edge.iNode = i;
+            pGraph->vAdjacency[j] << edge;
+        }
+    }
+    return pGraph;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<QPointF> RoutePlanner::polygon(const Graph &graph, const QGeoShape &shape, double dOffset)
+{
+    QVector<QPointF> vPolygon;
+    if (shape.type() == QGeoShape::CircleType)
+    {
+        // Circumscribed polygon of the grown circle
+        QGeoCircle circle(shape);
+        QPointF center = toPlane(graph, circle.center());
+        double dRadius = (circle.radius()+dOffset)/qCos(M_PI/CIRCLE_SIDES);
+        for (int i=0; i<CIRCLE_SIDES; i++)
+        {
+            double dAngle = 2*M_PI*i/CIRCLE_SIDES;
+            vPolygon << QPointF(center.x()+dRadius*qCos(dAngle), center.y()+dRadius*qSin(dAngle));
+        }
+        return vPolygon;
+    }
+    else
+    if (shape.type() == QGeoShape::RectangleType)
+    {
+        QGeoRectangle rectangle(shape);
+        QPointF topLeft = toPlane(graph, rectangle.topLeft());
+        QPointF bottomRight = toPlane(graph, rectangle.bottomRight());
+        vPolygon << topLeft << QPointF(bottomRight.x(), topLeft.y()) << bottomRight << QPointF(topLeft.x(), bottomRight.y());
+    }
+    else
+    if (shape.type() == QGeoShape::PathType)
+    {
+        QGeoPath geoPath(shape);
+        for (int i=0; i<geoPath.size(); i++)
+            vPolygon << toPlane(graph, geoPath.coordinateAt(i));
+    }
+    return offsetPolygon(vPolygon, dOffset);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<QPointF> RoutePlanner::offsetPolygon(const QVector<QPointF> &vPolygon, double dOffset)
+{
+    int iCount = vPolygon.size();
+    if (iCount < 3)
+        return QVector<QPointF>();
+
+    // Counterclockwise: outward normal of edge direction (dx, dy) is (dy, -dx)
+    double dArea = 0;
+    for (int i=0, j=iCount-1; i<iCount; j=i++)
+        dArea += vPolygon[j].x()*vPolygon[i].y()-vPolygon[i].x()*vPolygon[j].y();
+    QVector<QPointF> vSource = vPolygon;
+    if (dArea < 0)
+        std::reverse(vSource.begin(), vSource.end());
+
+    QVector<QPointF> vResult;
+    vResult.reserve(2*iCount);
+    for (int i=0; i<iCount; i++)
+    {
+        const QPointF &previous = vSource[(i+iCount-1)%iCount];
+        const QPointF &current = vSource[i];
+        const QPointF &next = vSource[(i+1)%iCount];
+        QPointF in = current-previous;
+        QPointF out = next-current;
+        double dInLength = qSqrt(in.x()*in.x()+in.y()*in.y());
+        double dOutLength = qSqrt(out.x()*out.x()+out.y()*out.y());
+        if ((dInLength <= 0) || (dOutLength <= 0))
+            continue;
+        QPointF inDirection = in/dInLength;
+        QPointF outDirection = out/dOutLength;
+        QPointF inNormal(inDirection.y(), -inDirection.x());
+        QPointF outNormal(outDirection.y(), -outDirection.x());
+
+        // Miter: offset along the bisector so that both edges move by dOffset
+        double dMiter = 1+inNormal.x()*outNormal.x()+inNormal.y()*outNormal.y();
+        bool bConvex = (inDirection.x()*outDirection.y()-inDirection.y()*outDirection.x()) > 0;
+        if ((dMiter >= MIN_MITER) || !bConvex)
+        {
+            vResult << current+(inNormal+outNormal)*(dOffset/qMax(dMiter, MIN_MITER));
+            continue;
+        }
+
+        // Sharp convex corner: clip the miter dOffset away from the corner (both offset edges end on the clipping line)
+        QPointF bisector = inDirection-outDirection;
+        double dBisectorLength = qSqrt(bisector.x()*bisector.x()+bisector.y()*bisector.y());
+        bisector /= dBisectorLength;
+        double dExtension = dOffset*(1-(inNormal.x()*bisector.x()+inNormal.y()*bisector.y()))/(dBisectorLength/2);
+        vResult << current+inNormal*dOffset+inDirection*dExtension;
+        vResult << current+outNormal*dOffset-outDirection*dExtension;
+    }
+    return vResult;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool RoutePlanner::detour(Graph &graph, const QGeoCoordinate &from, const QGeoCoordinate &to, QVector<QGeoCoordinate> &vDetour) const
+{
+    vDetour.clear();
+    QPointF fromPoint = toPlane(graph, from);
+    QPointF toPoint = toPlane(graph, to);
+
+    // Leg far from every area
+    if ((qMax(fromPoint.x(), toPoint.x()) < graph.dMinX) || (qMin(fromPoint.x(), toPoint.x()) > graph.dMaxX) ||
+        (qMax(fromPoint.y(), toPoint.y()) < graph.dMinY) || (qMin(fromPoint.y(), toPoint.y()) > graph.dMaxY))
+        return true;
+
+    // Legs already routed on this graph (a moved way point only reroutes its two legs)
+    uint iKey = qHash(fromPoint.x(), qHash(fromPoint.y(), qHash(toPoint.x(), qHash(toPoint.y()))));
+    QHash<uint, Leg>::const_iterator it = graph.hLegs.constFind(iKey);
+    if ((it == graph.hLegs.constEnd()) || (it.value().from != fromPoint) || (it.value().to != toPoint))
+    {
+        if (graph.hLegs.size() >= MAX_CACHED_LEGS)
+            graph.hLegs.clear();
+        Leg leg;
+        leg.from = fromPoint;
+        leg.to = toPoint;
+        leg.bFound = routeLeg(graph, fromPoint, toPoint, leg.vNodes);
+        it = graph.hLegs.insert(iKey, leg);
+    }
+    if (!it.value().bFound)
+        return false;
+
+    // Detour coordinates, altitude interpolated along the way
+    const QVector<int> &vNodes = it.value().vNodes;
+    if (vNodes.isEmpty())
+        return true;
+    QVector<double> vDistances;
+    double dLength = 0;
+    QPointF previous = fromPoint;
+    foreach (int iNode, vNodes)
+    {
+        QPointF delta = graph.vNodes[iNode]-previous;
+        dLength += qSqrt(delta.x()*delta.x()+delta.y()*delta.y());
+        vDistances << dLength;
+        previous = graph.vNodes[iNode];
+    }
+    QPointF last = toPoint-previous;
+    dLength += qSqrt(last.x()*last.x()+last.y()*last.y());
+    double dFromAltitude = qIsNaN(from.altitude()) ? to.altitude() : from.altitude();
+    double dToAltitude = qIsNaN(to.altitude()) ? dFromAltitude : to.altitude();
+    for (int i=0; i<vNodes.size(); i++)
+    {
+        QGeoCoordinate geoCoord = toGeoCoordinate(graph, graph.vNodes[vNodes[i]]);
+        if (!qIsNaN(dFromAltitude))
+            geoCoord.setAltitude(dFromAltitude+(dToAltitude-dFromAltitude)*(dLength > 0 ? vDistances[i]/dLength : 0));
+        vDetour << geoCoord;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool RoutePlanner::routeLeg(Graph &graph, const QPointF &from, const QPointF &to, QVector<int> &vNodes) const
+{
+    vNodes.clear();
+    if (isVisible(graph, from, to))
+        return true;
+    if (isBlocked(graph, from) || isBlocked(graph, to))
+        return false;
+
+    // A* over the graph plus the leg ends (start: iNodeCount, goal: iNodeCount+1)
+    int iNodeCount = graph.vNodes.size();
+    int iStart = iNodeCount;
+    int iGoal = iNodeCount+1;
+    auto point = [&](int iNode) { return iNode == iStart ? from : (iNode == iGoal ? to : graph.vNodes[iNode]); };
+    auto distance = [](const QPointF &a, const QPointF &b) { QPointF delta = b-a; return qSqrt(delta.x()*delta.x()+delta.y()*delta.y()); };
+
+    QVector<double> vCost(iNodeCount+2, std::numeric_limits<double>::max());
+    QVector<int> vPrevious(iNodeCount+2, -1);
+    QVector<bool> vClosed(iNodeCount+2, false);
+    typedef std::pair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    auto relax = [&](int iNode, int iTarget, double dLength) {
+        double dCost = vCost[iNode]+dLength;
+        if (dCost >= vCost[iTarget])
+            return;
+        vCost[iTarget] = dCost;
+        vPrevious[iTarget] = iNode;
+        queue.push(Entry(dCost+distance(point(iTarget), to), iTarget));
+    };
+    vCost[iStart] = 0;
+    queue.push(Entry(distance(from, to), iStart));
+    while (!queue.empty())
+    {
+        int iNode = queue.top().second;
+        queue.pop();
+        if (vClosed[iNode])
+            continue;
+        vClosed[iNode] = true;
+        if (iNode == iGoal)
+            break;
+
+        // Leg ends are only linked to the nodes they see
+        if (iNode == iStart)
+        {
+            for (int i=0; i<iNodeCount; i++)
+                if (isVisible(graph, from, graph.vNodes[i]))
+                    relax(iStart, i, distance(from, graph.vNodes[i]));
+            continue;
+        }
+        foreach (const Edge &edge, graph.vAdjacency[iNode])
+            if (!vClosed[edge.iNode])
+                relax(iNode, edge.iNode, edge.dLength);
+        if (isVisible(graph, graph.vNodes[iNode], to))
+            relax(iNode, iGoal, distance(graph.vNodes[iNode], to));
+    }
+    if (!vClosed[iGoal])
+        return false;
+
+    for (int iNode=vPrevious[iGoal]; iNode!=iStart; iNode=vPrevious[iNode])
+        vNodes.prepend(iNode);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool RoutePlanner::isVisible(const Graph &graph, const QPointF &from, const QPointF &to)
+{
+    double dMinX = qMin(from.x(), to.x());
+    double dMaxX = qMax(from.x(), to.x());
+    double dMinY = qMin(from.y(), to.y());
+    double dMaxY = qMax(from.y(), to.y());
+    foreach (const Obstacle &obstacle, graph.vObstacles)
+    {
+        if ((dMaxX < obstacle.dMinX) || (dMinX > obstacle.dMaxX) || (dMaxY < obstacle.dMinY) || (dMinY > obstacle.dMaxY))
+            continue;
+
+        // Ends lie outside obstacles: a segment through one crosses its border
+        int iCount = obstacle.vPolygon.size();
+        for (int i=0, j=iCount-1; i<iCount; j=i++)
+            if (PlanValidator::segmentsIntersect(from, to, obstacle.vPolygon[j], obstacle.vPolygon[i]))
+                return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool RoutePlanner::isBlocked(const Graph &graph, const QPointF &point)
+{
+    foreach (const Obstacle &obstacle, graph.vObstacles)
+    {
+        if ((point.x() < obstacle.dMinX) || (point.x() > obstacle.dMaxX) || (point.y() < obstacle.dMinY) || (point.y() > obstacle.dMaxY))
+            continue;
+        if (PlanValidator::contains(obstacle.vPolygon, point))
+            return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QPointF RoutePlanner::toPlane(const Graph &graph, const QGeoCoordinate &geoCoord)
+{
+    return QPointF((geoCoord.longitude()-graph.origin.longitude())*graph.dMetersPerLongitude,
+                   (geoCoord.latitude()-graph.origin.latitude())*graph.dMetersPerLatitude);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QGeoCoordinate RoutePlanner::toGeoCoordinate(const Graph &graph, const QPointF &point)
+{
+    return QGeoCoordinate(graph.origin.latitude()+point.y()/graph.dMetersPerLatitude,
+                          graph.origin.longitude()+point.x()/graph.dMetersPerLongitude);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+uint RoutePlanner::exclusionKey(const QList<QGeoShape> &lExclusionArea)
+{
+    uint iKey = qHash(lExclusionArea.size());
+    foreach (const QGeoShape &shape, lExclusionArea)
+    {
+        iKey = qHash((int)shape.type(), iKey);
+        if (shape.type() == QGeoShape::CircleType)
+        {
+            QGeoCircle circle(shape);
+            iKey = qHash(circle.center().latitude(), qHash(circle.center().longitude(), qHash(circle.radius(), iKey)));
+        }
+        else
+        if (shape.type() == QGeoShape::RectangleType)
+        {
+            QGeoRectangle rectangle(shape);
+            iKey = qHash(rectangle.topLeft().latitude(), qHash(rectangle.topLeft().longitude(), iKey));
+            iKey = qHash(rectangle.bottomRight().latitude(), qHash(rectangle.bottomRight().longitude(), iKey));
+        }
+        else
+        if (shape.type() == QGeoShape::PathType)
+        {
+            QGeoPath geoPath(shape);
+            for (int i=0; i<geoPath.size(); i++)
+                iKey = qHash(geoPath.coordinateAt(i).latitude(), qHash(geoPath.coordinateAt(i).longitude(), iKey));
+        }
+    }
+    return iKey;
+}
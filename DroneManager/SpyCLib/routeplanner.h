@@ -0,0 +1,176 @@
+#ifndef ROUTEPLANNER_H
+#define ROUTEPLANNER_H
+
+// Qt
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QPointF>
+#include <QGeoShape>
+#include <QGeoCoordinate>
+
+// Application
+#include "waypoint.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class SPYCLIBSHARED_EXPORT RoutePlanner
+{
+public:
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor (dBuffer: clearance kept around exclusion areas (m), iMaxGraphs: cached exclusion sets)
+    RoutePlanner(double dBuffer=20, int iMaxGraphs=8);
+
+    //! Destructor
+    ~RoutePlanner();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Set clearance kept around exclusion areas (m, cached graphs are dropped)
+    void setBuffer(double dBuffer);
+
+    //! Return clearance kept around exclusion areas (m)
+    double buffer() const;
+
+    //! Return cached graph count
+    int graphCount() const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Insert detour way points on legs crossing exclusion areas (bClosed: plan flown in a loop)
+    //! Legs that can't be routed (end inside an exclusion area, no way around) are kept as is and listed in vUnroutedLegs
+    bool route(const QVector<WayPoint> &vWayPoints, const QList<QGeoShape> &lExclusionArea, bool bClosed, QVector<WayPoint> &vRoute, QVector<int> &vUnroutedLegs);
+
+    //! Return detour from -> to around exclusion areas (empty: direct leg is clear), false if there is no way around
+    bool findPath(const QGeoCoordinate &from, const QGeoCoordinate &to, const QList<QGeoShape> &lExclusionArea, QVector<QGeoCoordinate> &vDetour);
+
+    //! Drop cached graphs
+    void clear();
+
+private:
+    //! Buffered exclusion polygon (local plane, m)
+    struct Obstacle
+    {
+        //! Vertices (counterclockwise)
+        QVector<QPointF> vPolygon;
+
+        //! Bounding box
+        double dMinX = 0;
+        double dMinY = 0;
+        double dMaxX = 0;
+        double dMaxY = 0;
+    };
+
+    //! Visibility graph edge
+    struct Edge
+    {
+        //! Target node
+        int iNode = -1;
+
+        //! Length (m)
+        double dLength = 0;
+    };
+
+    //! Cached leg (detour as graph nodes)
+    struct Leg
+    {
+        //! Leg ends (hash collisions)
+        QPointF from;
+        QPointF to;
+
+        //! Way around found?
+        bool bFound = false;
+
+        //! Detour
+        QVector<int> vNodes;
+    };
+
+    //! Visibility graph of an exclusion set
+    struct Graph
+    {
+        //! Exclusion set (hash collisions)
+        QList<QGeoShape> lExclusionArea;
+
+        //! Origin of the local plane
+        QGeoCoordinate origin;
+
+        //! Meters per degree of longitude and latitude at origin
+        double dMetersPerLongitude = 1;
+        double dMetersPerLatitude = 1;
+
+        //! Obstacles
+        QVector<Obstacle> vObstacles;
+
+        //! Bounding box of all obstacles
+        double dMinX = 0;
+        double dMinY = 0;
+        double dMaxX = 0;
+        double dMaxY = 0;
+
+        //! Nodes (buffered obstacle corners)
+        QVector<QPointF> vNodes;
+
+        //! Edges of each node
+        QVector<QVector<Edge>> vAdjacency;
+
+        //! Routed legs
+        QHash<uint, Leg> hLegs;
+
+        //! Last use (LRU)
+        quint64 iLastUse = 0;
+    };
+
+    //! Return visibility graph of an exclusion set (built on first use)
+    Graph *graph(const QList<QGeoShape> &lExclusionArea);
+
+    //! Build visibility graph
+    Graph *buildGraph(const QList<QGeoShape> &lExclusionArea) const;
+
+    //! Return polygon of a shape grown by dOffset (local plane)
+    static QVector<QPointF> polygon(const Graph &graph, const QGeoShape &shape, double dOffset);
+
+    //! Return polygon grown by dOffset (mitered corners, sharp convex ones clipped: one more vertex each)
+    static QVector<QPointF> offsetPolygon(const QVector<QPointF> &vPolygon, double dOffset);
+
+    //! Return detour of a leg (cached per graph), false if there is no way around
+    bool detour(Graph &graph, const QGeoCoordinate &from, const QGeoCoordinate &to, QVector<QGeoCoordinate> &vDetour) const;
+
+    //! Route a leg (graph nodes of the detour, A*), false if there is no way around
+    bool routeLeg(Graph &graph, const QPointF &from, const QPointF &to, QVector<int> &vNodes) const;
+
+    //! Return true if segment is clear of every obstacle
+    static bool isVisible(const Graph &graph, const QPointF &from, const QPointF &to);
+
+    //! Return true if point is inside an obstacle
+    static bool isBlocked(const Graph &graph, const QPointF &point);
+
+    //! Projection between geo coordinates and the local plane of a graph
+    static QPointF toPlane(const Graph &graph, const QGeoCoordinate &geoCoord);
+    static QGeoCoordinate toGeoCoordinate(const Graph &graph, const QPointF &point);
+
+    //! Return exclusion set key
+    static uint exclusionKey(const QList<QGeoShape> &lExclusionArea);
+
+private:
+    //! Clearance kept around exclusion areas (m)
+    double m_dBuffer = 20;
+
+    //! Max cached graphs
+    int m_iMaxGraphs = 8;
+
+    //! Use counter (LRU)
+    quint64 m_iUseCounter = 0;
+
+    //! Cached graphs
+    QHash<uint, Graph *> m_hGraphs;
+};
+}
+
+#endif // ROUTEPLANNER_H
@@ -0,0 +1,201 @@
+// Qt
+#include <QtMath>
+#include <QDebug>
+#include <QGeoCircle>
+#include <QGeoRectangle>
+
+// Application
+#include "scenario.h"
+#include "serializehelper.h"
+#include "messageschema.h"
+#include "flightpath.h"
+#include "workerpool.h"
+#include "geoutils.h"
+#define DEFAULT_UID_PREFIX "DRONE "
+#define DEFAULT_SPACING 100. // Meters between generated drones
+#define EXPAND_CHUNK_SIZE 64
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+Scenario::Scenario()
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+Scenario::~Scenario()
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const QVector<Scenario::Drone> &Scenario::drones() const
+{
+    return m_vDrones;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void Scenario::append(const Drone &drone)
+{
+    m_vDrones << drone;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void Scenario::clear()
+{
+    m_vDrones.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool Scenario::load(const QString &sFileName, WorkerPool *pWorkerPool)
+{
+    CXMLNode scenarioNode = Schema::Scenario::find(CXMLNode::load(sFileName));
+    if (!Schema::Scenario::is(scenarioNode))
+        return false;
+
+    // Fleet plans: flown relative to the scenario reference by every drone without plans of its own
+    Drone fleet;
+    readPlans(scenarioNode, fleet);
+    QGeoCoordinate reference(Schema::Scenario::Latitude::read(scenarioNode, qQNaN()), Schema::Scenario::Longitude::read(scenarioNode, qQNaN()),
+                             Schema::Scenario::Altitude::read(scenarioNode, qQNaN()));
+    QString sPrefix = Schema::Scenario::UIDPrefix::read(scenarioNode, DEFAULT_UID_PREFIX);
+    QString sVideoUrl = Schema::Scenario::VideoUrl::read(scenarioNode);
+    double dSpacing = Schema::Scenario::Spacing::read(scenarioNode, DEFAULT_SPACING);
+
+    // Explicit drones
+    QVector<CXMLNode> vDroneNodes = scenarioNode.getNodesByTagName(Schema::ScenarioDrone::name());
+    int iExplicitCount = vDroneNodes.size();
+    int iCount = qMax(Schema::Scenario::Count::read(scenarioNode), iExplicitCount);
+    if ((iCount > iExplicitCount) && !reference.isValid())
+    {
+        qWarning() << "Scenario::load generated drones need a scenario latitude and longitude" << sFileName;
+        return false;
+    }
+    m_vDrones.clear();
+    m_vDrones.resize(iCount);
+    for (int i=0; i<iExplicitCount; i++)
+    {
+        const CXMLNode &droneNode = vDroneNodes[i];
+        Drone &drone = m_vDrones[i];
+        drone.sDroneUID = Schema::ScenarioDrone::DroneUID::read(droneNode, sPrefix+QString::number(i));
+        drone.sVideoUrl = Schema::ScenarioDrone::VideoUrl::read(droneNode, sVideoUrl);
+        drone.position = QGeoCoordinate(Schema::ScenarioDrone::Latitude::read(droneNode), Schema::ScenarioDrone::Longitude::read(droneNode),
+                                        Schema::ScenarioDrone::Altitude::read(droneNode, qQNaN()));
+
+        // Fleet plans are moved along with the drone when both it and the scenario have a position, flown as is otherwise (no NaN shift)
+        if (reference.isValid() && drone.position.isValid())
+            copyPlans(fleet, drone.position.latitude()-reference.latitude(), drone.position.longitude()-reference.longitude(), drone);
+        else
+            copyPlans(fleet, 0, 0, drone);
+        readPlans(droneNode, drone);
+        prepareFlight(drone);
+    }
+
+    // Generated drones: square grid centered on the reference, fleet plans moved along (copies and flight paths are built in parallel)
+    int iGeneratedCount = iCount-iExplicitCount;
+    int iColumns = qMax(1, qCeil(qSqrt(iGeneratedCount)));
+    int iRows = (iGeneratedCount+iColumns-1)/iColumns;
+    WorkerPool::Job job = [&](int iBegin, int iEnd) {
+        for (int i=iBegin; i<iEnd; i++)
+        {
+            Drone &drone = m_vDrones[iExplicitCount+i];
+            double dNorth = ((iRows-1)/2.-i/iColumns)*dSpacing;
+            double dEast = (i%iColumns-(iColumns-1)/2.)*dSpacing;
+            drone.sDroneUID = sPrefix+QString::number(iExplicitCount+i);
+            drone.sVideoUrl = sVideoUrl;
+            drone.position = GeoUtils::translate(reference, dNorth, dEast);
+            copyPlans(fleet, drone.position.latitude()-reference.latitude(), drone.position.longitude()-reference.longitude(), drone);
+            prepareFlight(drone);
+        }
+    };
+    if (pWorkerPool != nullptr)
+        pWorkerPool->run(iGeneratedCount, EXPAND_CHUNK_SIZE, job);
+    else
+        job(0, iGeneratedCount);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void Scenario::readPlans(const CXMLNode &node, Drone &drone)
+{
+    QString sDroneUID;
+    if (Schema::SafetyPlan::is(Schema::SafetyPlan::find(node)))
+        SerializeHelper::deserializeSafetyPlan(node, drone.safetyPlan, sDroneUID);
+    if (Schema::MissionPlan::is(Schema::MissionPlan::find(node)))
+    {
+        drone.vMissionPlan.clear();
+        SerializeHelper::deserializeMissionPlan(node, drone.vMissionPlan, sDroneUID);
+    }
+    if (Schema::LandingPlan::is(Schema::LandingPlan::find(node)))
+    {
+        drone.vLandingPlan.clear();
+        SerializeHelper::deserializeLandingPlan(node, drone.vLandingPlan, sDroneUID);
+    }
+    if (Schema::ExclusionArea::is(Schema::ExclusionArea::find(node)))
+    {
+        drone.lExclusionArea.clear();
+        SerializeHelper::deserializeExclusionArea(node, drone.lExclusionArea, sDroneUID);
+    }
+    if (Schema::TakeOff::is(Schema::TakeOff::find(node)))
+        drone.bTakeOff = true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void Scenario::copyPlans(const Drone &fleet, double dLatitude, double dLongitude, Drone &drone)
+{
+    drone.bTakeOff = fleet.bTakeOff;
+    drone.safetyPlan = fleet.safetyPlan;
+    drone.safetyPlan.translate(dLatitude, dLongitude);
+    drone.vMissionPlan = fleet.vMissionPlan;
+    drone.vLandingPlan = fleet.vLandingPlan;
+    for (int i=0; i<drone.vMissionPlan.size(); i++)
+    {
+        GeoPoint point = drone.vMissionPlan[i].point();
+        drone.vMissionPlan[i].setPoint(GeoPoint(point.dLatitude+dLatitude, point.dLongitude+dLongitude, point.dAltitude));
+    }
+    for (int i=0; i<drone.vLandingPlan.size(); i++)
+    {
+        GeoPoint point = drone.vLandingPlan[i].point();
+        drone.vLandingPlan[i].setPoint(GeoPoint(point.dLatitude+dLatitude, point.dLongitude+dLongitude, point.dAltitude));
+    }
+    drone.lExclusionArea.clear();
+    foreach (QGeoShape shape, fleet.lExclusionArea)
+    {
+        if (shape.type() == QGeoShape::CircleType)
+        {
+            QGeoCircle circle(shape);
+            circle.translate(dLatitude, dLongitude);
+            drone.lExclusionArea << circle;
+        }
+        else
+        if (shape.type() == QGeoShape::RectangleType)
+        {
+            QGeoRectangle rectangle(shape);
+            rectangle.translate(dLatitude, dLongitude);
+            drone.lExclusionArea << rectangle;
+        }
+        else
+        if (shape.type() == QGeoShape::PathType)
+        {
+            QGeoPath path(shape);
+            path.translate(dLatitude, dLongitude);
+            drone.lExclusionArea << path;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void Scenario::prepareFlight(Drone &drone)
+{
+    if (drone.bTakeOff && !drone.vMissionPlan.isEmpty())
+        drone.pFlightPath = FlightPath::shared(drone.vMissionPlan);
+}
@@ -0,0 +1,101 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+// Qt
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QGeoCoordinate>
+#include <QGeoPath>
+#include <QGeoShape>
+#include <QSharedPointer>
+
+// Application
+#include "waypoint.h"
+#include "cxmlnode.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class WorkerPool;
+class FlightPath;
+class SPYCLIBSHARED_EXPORT Scenario
+{
+public:
+    //! Drone to spawn
+    struct Drone
+    {
+        //! UID
+        QString sDroneUID;
+
+        //! Video url
+        QString sVideoUrl;
+
+        //! Start position
+        QGeoCoordinate position;
+
+        //! Safety plan
+        QGeoPath safetyPlan;
+
+        //! Mission plan
+        QVector<WayPoint> vMissionPlan;
+
+        //! Landing plan
+        QVector<WayPoint> vLandingPlan;
+
+        //! Exclusion area
+        QList<QGeoShape> lExclusionArea;
+
+        //! Take off once spawned?
+        bool bTakeOff = false;
+
+        //! Flight path of the mission plan, built ahead of take off (null if the drone stays on the ground)
+        QSharedPointer<const FlightPath> pFlightPath;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor
+    Scenario();
+
+    //! Destructor
+    ~Scenario();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Return drones
+    const QVector<Drone> &drones() const;
+
+    //! Append drone
+    void append(const Drone &drone);
+
+    //! Drop every drone
+    void clear();
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Load scenario file (.json, .xml or .cbor), generated drones are expanded on the worker pool if any
+    bool load(const QString &sFileName, WorkerPool *pWorkerPool=nullptr);
+
+private:
+    //! Read plans and take off found among the children of a scenario or drone node
+    static void readPlans(const CXMLNode &node, Drone &drone);
+
+    //! Copy plans of a fleet template, moved by (dLatitude, dLongitude) degrees
+    static void copyPlans(const Drone &fleet, double dLatitude, double dLongitude, Drone &drone);
+
+    //! Build flight path of a drone taking off (path cache is shared with take off)
+    static void prepareFlight(Drone &drone);
+
+private:
+    //! Drones
+    QVector<Drone> m_vDrones;
+};
+}
+
+#endif // SCENARIO_H
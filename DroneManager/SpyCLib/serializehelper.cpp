@@ -1,31 +1,54 @@
 // Qt
 #include <QGeoCoordinate>
+#include <QGeoCircle>
+#include <QGeoRectangle>
 #include <QDebug>
 #include <QFile>
+#include <QPair>
+
+// Std
+#include <algorithm>
 
 // Application
 #include "serializehelper.h"
 #include "waypoint.h"
-#include "defs.h"
+#include "messageschema.h"
 using namespace Core;
 
 //-------------------------------------------------------------------------------------------------
 
-CXMLNode SerializeHelper::serializeDroneStatus(const DroneEmulator &drone)
+CXMLNode SerializeHelper::serializeDroneStatus(const DroneEmulator &drone, qint64 iTimestamp)
+{
+    return serializeDroneStatus(*drone.fleetState(), drone.slot(), iTimestamp);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+CXMLNode SerializeHelper::serializeDroneStatus(const FleetState &fleetState, int iSlot, qint64 iTimestamp)
 {
     // Create status node
     CXMLNode rootNode;
-    CXMLNode statusNode(TAG_DRONE_STATUS);
-    statusNode.attributes()[ATTR_DRONE_UID] = drone.uid();
-    statusNode.attributes()[ATTR_FLIGHT_STATUS] = QString::number(drone.flightStatus());
-    statusNode.attributes()[ATTR_VIDEO_URL] = drone.videoUrl();
-
-    // Serialize position
-    CXMLNode positionNode = serializePosition(drone.position(), drone.heading());
+    CXMLNode statusNode = Schema::DroneStatus::create();
+    Schema::DroneStatus::DroneUID::write(statusNode, fleetState.uid(iSlot));
+    int iHandle = fleetState.handle(iSlot);
+    if (iHandle >= 0)
+        Schema::DroneStatus::Handle::write(statusNode, iHandle);
+    Schema::DroneStatus::FlightStatus::write(statusNode, fleetState.flightStatus(iSlot));
+    Schema::DroneStatus::VideoUrl::write(statusNode, fleetState.videoUrl(iSlot));
+    if (iTimestamp >= 0)
+        Schema::DroneStatus::Timestamp::write(statusNode, iTimestamp);
+
+    // Serialize position and velocity (clients extrapolate position between two status)
+    CXMLNode positionNode = serializePosition(fleetState.position(iSlot), fleetState.heading(iSlot));
+    double dVelocityNorth = 0;
+    double dVelocityEast = 0;
+    fleetState.velocity(iSlot, dVelocityNorth, dVelocityEast);
+    Schema::Position::VelocityNorth::write(positionNode.nodes().first(), dVelocityNorth);
+    Schema::Position::VelocityEast::write(positionNode.nodes().first(), dVelocityEast);
     statusNode << positionNode;
 
     // Serialize battery level
-    CXMLNode batteryLevelNode = serializeBatteryLevel(drone.batteryLevel(), drone.returnLevel());
+    CXMLNode batteryLevelNode = serializeBatteryLevel(fleetState.batteryLevel(iSlot), fleetState.returnLevel(iSlot));
     statusNode << batteryLevelNode;
 
     rootNode.nodes() << statusNode;
@@ -34,38 +57,78 @@ CXMLNode SerializeHelper::serializeDroneStatus(const DroneEmulator &drone)
 
 //-------------------------------------------------------------------------------------------------
 
+QVector<CXMLNode> SerializeHelper::serializeFleetStatus(const FleetState &fleetState)
+{
+    QVector<CXMLNode> vStatus;
+    vStatus.reserve(fleetState.activeCount());
+    const uchar *pActive = fleetState.activeFlags();
+    for (int iSlot=0; iSlot<fleetState.slotCount(); iSlot++)
+        if (pActive[iSlot])
+            vStatus << serializeDroneStatus(fleetState, iSlot);
+    return vStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 void SerializeHelper::deserializeDroneStatus(const QString &sDroneStatus, QString &sDroneUID, SpyCore::FlightStatus &eFlightStatus, QGeoCoordinate &position, double &dHeading, int &iBatteryLevel, int &iReturnLevel, QString &sVideoUrl)
 {
-    CXMLNode msgNode = CXMLNode::parseJSON(sDroneStatus);
+    deserializeDroneStatus(CXMLNode::parseJSON(sDroneStatus), sDroneUID, eFlightStatus, position, dHeading, iBatteryLevel, iReturnLevel, sVideoUrl);
+}
 
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::deserializeDroneStatus(const CXMLNode &msgNode, QString &sDroneUID, SpyCore::FlightStatus &eFlightStatus, QGeoCoordinate &position, double &dHeading, int &iBatteryLevel, int &iReturnLevel, QString &sVideoUrl)
+{
     // Retrieve drone status node
-    CXMLNode droneStatusNode = msgNode.getNodeByTagName(TAG_DRONE_STATUS);
-    sDroneUID = droneStatusNode.attributes()[ATTR_DRONE_UID];
-    sVideoUrl = droneStatusNode.attributes()[ATTR_VIDEO_URL];
-    eFlightStatus = (SpyCore::FlightStatus)droneStatusNode.attributes()[ATTR_FLIGHT_STATUS].toInt();
+    CXMLNode droneStatusNode = Schema::DroneStatus::find(msgNode);
+    sDroneUID = Schema::DroneStatus::DroneUID::read(droneStatusNode);
+    sVideoUrl = Schema::DroneStatus::VideoUrl::read(droneStatusNode);
+    eFlightStatus = Schema::DroneStatus::FlightStatus::read(droneStatusNode);
 
     // Retrieve position node
     if (!droneStatusNode.nodes().isEmpty())
     {
-        CXMLNode positionNode = droneStatusNode.nodes().first().getNodeByTagName(TAG_POSITION);
+        CXMLNode positionNode = Schema::Position::find(droneStatusNode.nodes().first());
         deserializePosition(positionNode, position, dHeading);
 
         // Retrieve battery node
-        CXMLNode batteryNode = droneStatusNode.nodes().first().getNodeByTagName(TAG_BATTERY);
+        CXMLNode batteryNode = Schema::Battery::find(droneStatusNode.nodes().first());
         deserializeBatteryLevel(batteryNode, iBatteryLevel, iReturnLevel);
     }
 }
 
 //-------------------------------------------------------------------------------------------------
 
+void SerializeHelper::deserializeDroneMotion(const CXMLNode &msgNode, QString &sDroneUID, QGeoCoordinate &position, double &dVelocityNorth, double &dVelocityEast, qint64 &iTimestamp)
+{
+    // Retrieve drone status node
+    CXMLNode droneStatusNode = Schema::DroneStatus::find(msgNode);
+    sDroneUID = Schema::DroneStatus::DroneUID::read(droneStatusNode);
+    iTimestamp = Schema::DroneStatus::Timestamp::read(droneStatusNode, -1);
+    dVelocityNorth = 0;
+    dVelocityEast = 0;
+
+    // Retrieve position node (older servers send no velocity: drone is not extrapolated)
+    if (!droneStatusNode.nodes().isEmpty())
+    {
+        CXMLNode positionNode = Schema::Position::find(droneStatusNode.nodes().first());
+        double dHeading = 0;
+        deserializePosition(positionNode, position, dHeading);
+        dVelocityNorth = Schema::Position::VelocityNorth::read(positionNode);
+        dVelocityEast = Schema::Position::VelocityEast::read(positionNode);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
 CXMLNode SerializeHelper::serializePosition(const QGeoCoordinate &geoCoord, double dHeading)
 {
     CXMLNode rootNode;
-    CXMLNode positionNode(TAG_POSITION);
-    positionNode.attributes()[ATTR_LATITUDE] = QString::number(geoCoord.latitude());
-    positionNode.attributes()[ATTR_LONGITUDE] = QString::number(geoCoord.longitude());
-    positionNode.attributes()[ATTR_ALTITUDE] = QString::number(geoCoord.altitude());
-    positionNode.attributes()[ATTR_HEADING] = QString::number(dHeading);
+    CXMLNode positionNode = Schema::Position::create();
+    Schema::Position::Latitude::write(positionNode, geoCoord.latitude());
+    Schema::Position::Longitude::write(positionNode, geoCoord.longitude());
+    Schema::Position::Altitude::write(positionNode, geoCoord.altitude());
+    Schema::Position::Heading::write(positionNode, dHeading);
     rootNode.nodes() << positionNode;
     return rootNode;
 }
@@ -74,10 +137,10 @@ CXMLNode SerializeHelper::serializePosition(const QGeoCoordinate &geoCoord, doub
 
 void SerializeHelper::deserializePosition(const CXMLNode &positionNode, QGeoCoordinate &geoCoord, double &dHeading)
 {
-    double dLatitude = positionNode.attributes()[ATTR_LATITUDE].toDouble();
-    double dLongitude = positionNode.attributes()[ATTR_LONGITUDE].toDouble();
-    double dAltitude = positionNode.attributes()[ATTR_ALTITUDE].toDouble();
-    dHeading = positionNode.attributes()[ATTR_HEADING].toDouble();
+    double dLatitude = Schema::Position::Latitude::read(positionNode);
+    double dLongitude = Schema::Position::Longitude::read(positionNode);
+    double dAltitude = Schema::Position::Altitude::read(positionNode);
+    dHeading = Schema::Position::Heading::read(positionNode);
     geoCoord.setLatitude(dLatitude);
     geoCoord.setLongitude(dLongitude);
     geoCoord.setAltitude(dAltitude);
@@ -88,9 +151,9 @@ void SerializeHelper::deserializePosition(const CXMLNode &positionNode, QGeoCoor
 CXMLNode SerializeHelper::serializeBatteryLevel(double dLevel, double dReturn)
 {
     CXMLNode rootNode;
-    CXMLNode batteryNode(TAG_BATTERY);
-    batteryNode.attributes()[ATTR_LEVEL] = QString::number(dLevel);
-    batteryNode.attributes()[ATTR_RETURN] = QString::number(dReturn);
+    CXMLNode batteryNode = Schema::Battery::create();
+    Schema::Battery::Level::write(batteryNode, dLevel);
+    Schema::Battery::Return::write(batteryNode, dReturn);
     rootNode.nodes() << batteryNode;
     return rootNode;
 }
@@ -99,25 +162,31 @@ CXMLNode SerializeHelper::serializeBatteryLevel(double dLevel, double dReturn)
 
 void SerializeHelper::deserializeBatteryLevel(const CXMLNode &batteryNode, int &iLevel, int &iReturnLevel)
 {
-    iLevel = batteryNode.attributes()[ATTR_LEVEL].toInt();
-    iReturnLevel = batteryNode.attributes()[ATTR_RETURN].toInt();
+    iLevel = (int)Schema::Battery::Level::read(batteryNode);
+    iReturnLevel = (int)Schema::Battery::Return::read(batteryNode);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 CXMLNode SerializeHelper::serializeMissionPlan(const QVector<Core::WayPoint> &vWayPoints, const QString &sDroneUID)
 {
-    return writeGeoPath(vWayPoints, TAG_MISSION_PLAN, sDroneUID);
+    return writeGeoPath(vWayPoints, Schema::MissionPlan::name(), sDroneUID);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void SerializeHelper::deserializeMissionPlan(const QString &sMissionPlan, QVector<WayPoint> &vWayPoints, QString &sDroneUID)
+{
+    deserializeMissionPlan(CXMLNode::parseJSON(sMissionPlan), vWayPoints, sDroneUID);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::deserializeMissionPlan(const CXMLNode &rootNode, QVector<WayPoint> &vWayPoints, QString &sDroneUID)
 {
     // Read waypoints
-    CXMLNode rootNode = CXMLNode::parseJSON(sMissionPlan);
-    CXMLNode missionPlanNode = rootNode.getNodeByTagName(TAG_MISSION_PLAN);
-    sDroneUID = missionPlanNode.attributes()[ATTR_DRONE_UID];
+    CXMLNode missionPlanNode = Schema::MissionPlan::find(rootNode);
+    sDroneUID = Schema::MissionPlan::DroneUID::read(missionPlanNode);
     readPlan(missionPlanNode, vWayPoints);
 }
 
@@ -125,17 +194,23 @@ void SerializeHelper::deserializeMissionPlan(const QString &sMissionPlan, QVecto
 
 CXMLNode SerializeHelper::serializeSafetyPlan(const QGeoPath &wayPoints, const QString &sDroneUID)
 {
-    return writeGeoPath(wayPoints, TAG_SAFETY_PLAN, sDroneUID);
+    return writeGeoPath(wayPoints, Schema::SafetyPlan::name(), sDroneUID);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void SerializeHelper::deserializeSafetyPlan(const QString &sSafetyPlan, QGeoPath &geoPath, QString &sDroneUID)
+{
+    deserializeSafetyPlan(CXMLNode::parseJSON(sSafetyPlan), geoPath, sDroneUID);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::deserializeSafetyPlan(const CXMLNode &rootNode, QGeoPath &geoPath, QString &sDroneUID)
 {
     // Read waypoints
-    CXMLNode rootNode = CXMLNode::parseJSON(sSafetyPlan);
-    CXMLNode safetyPlanNode = rootNode.getNodeByTagName(TAG_SAFETY_PLAN);
-    sDroneUID = safetyPlanNode.attributes()[ATTR_DRONE_UID];
+    CXMLNode safetyPlanNode = Schema::SafetyPlan::find(rootNode);
+    sDroneUID = Schema::SafetyPlan::DroneUID::read(safetyPlanNode);
     geoPath = readGeoPath(safetyPlanNode);
 }
 
@@ -143,28 +218,214 @@ void SerializeHelper::deserializeSafetyPlan(const QString &sSafetyPlan, QGeoPath
 
 CXMLNode SerializeHelper::serializeLandingPlan(const QVector<Core::WayPoint> &vWayPoints, const QString &sDroneUID)
 {
-    return writeGeoPath(vWayPoints, TAG_LANDING_PLAN, sDroneUID);
+    return writeGeoPath(vWayPoints, Schema::LandingPlan::name(), sDroneUID);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void SerializeHelper::deserializeLandingPlan(const QString &sLandingPlan, QVector<WayPoint> &vWayPoints, QString &sDroneUID)
+{
+    deserializeLandingPlan(CXMLNode::parseJSON(sLandingPlan), vWayPoints, sDroneUID);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::deserializeLandingPlan(const CXMLNode &rootNode, QVector<WayPoint> &vWayPoints, QString &sDroneUID)
 {
     // Read waypoints
-    CXMLNode rootNode = CXMLNode::parseJSON(sLandingPlan);
-    CXMLNode landingPlanNode = rootNode.getNodeByTagName(TAG_LANDING_PLAN);
-    sDroneUID = landingPlanNode.attributes()[ATTR_DRONE_UID];
+    CXMLNode landingPlanNode = Schema::LandingPlan::find(rootNode);
+    sDroneUID = Schema::LandingPlan::DroneUID::read(landingPlanNode);
     readPlan(landingPlanNode, vWayPoints);
 }
 
 //-------------------------------------------------------------------------------------------------
 
+CXMLNode SerializeHelper::serializeRoute(const QVector<Core::WayPoint> &vWayPoints, const QString &sDroneUID)
+{
+    return writeGeoPath(vWayPoints, Schema::Route::name(), sDroneUID);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::deserializeRoute(const CXMLNode &rootNode, QVector<WayPoint> &vWayPoints, QString &sDroneUID)
+{
+    CXMLNode routeNode = Schema::Route::find(rootNode);
+    sDroneUID = Schema::Route::DroneUID::read(routeNode);
+    readPlan(routeNode, vWayPoints);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+CXMLNode SerializeHelper::serializeTrajectory(const QVector<Core::WayPoint> &vWayPoints, const QString &sDroneUID, qint64 iTimestamp, double dProgress)
+{
+    CXMLNode rootNode = writeGeoPath(vWayPoints, Schema::Trajectory::name(), sDroneUID);
+    Schema::Trajectory::Timestamp::write(rootNode.nodes().first(), iTimestamp);
+    Schema::Trajectory::Progress::write(rootNode.nodes().first(), dProgress);
+    return rootNode;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::deserializeTrajectory(const CXMLNode &msgNode, QVector<WayPoint> &vWayPoints, QString &sDroneUID, qint64 &iTimestamp, double &dProgress)
+{
+    CXMLNode trajectoryNode = Schema::Trajectory::find(msgNode);
+    sDroneUID = Schema::Trajectory::DroneUID::read(trajectoryNode);
+    iTimestamp = Schema::Trajectory::Timestamp::read(trajectoryNode, -1);
+    dProgress = Schema::Trajectory::Progress::read(trajectoryNode);
+    readPlan(trajectoryNode, vWayPoints);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::appendProgress(CXMLNode &rootNode, double dProgress)
+{
+    if (!rootNode.nodes().isEmpty())
+        Schema::DroneStatus::Progress::write(rootNode.nodes().first(), dProgress);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::appendPlanErrors(CXMLNode &rootNode, const QVector<PlanValidator::Issue> &vIssues)
+{
+    if (rootNode.nodes().isEmpty())
+        return;
+    CXMLNode &planNode = rootNode.nodes().first();
+    foreach (PlanValidator::Issue issue, vIssues)
+    {
+        CXMLNode errorNode = Schema::PlanError::create();
+        Schema::PlanError::Error::write(errorNode, (int)issue.eError);
+        Schema::PlanError::Index::write(errorNode, issue.iIndex);
+        planNode.nodes() << errorNode;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<PlanValidator::Issue> SerializeHelper::deserializePlanErrors(const CXMLNode &planNode)
+{
+    QVector<PlanValidator::Issue> vIssues;
+    foreach (CXMLNode errorNode, planNode.getNodesByTagName(Schema::PlanError::name()))
+    {
+        PlanValidator::Issue issue;
+        issue.eError = (SpyCore::MissionPlanError)Schema::PlanError::Error::read(errorNode);
+        issue.iIndex = Schema::PlanError::Index::read(errorNode, -1);
+        vIssues << issue;
+    }
+    return vIssues;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+CXMLNode SerializeHelper::serializeExclusionArea(const QList<QGeoShape> &lExclusionArea, const QString &sDroneUID)
+{
+    CXMLNode rootNode;
+    CXMLNode exclusionAreaNode = Schema::ExclusionArea::create();
+    Schema::ExclusionArea::DroneUID::write(exclusionAreaNode, sDroneUID);
+    foreach (QGeoShape shape, lExclusionArea)
+    {
+        QList<QGeoCoordinate> lCoords;
+        CXMLNode shapeNode;
+        if (shape.type() == QGeoShape::CircleType)
+        {
+            QGeoCircle circle(shape);
+            shapeNode = Schema::Circle::create();
+            Schema::Circle::Latitude::write(shapeNode, circle.center().latitude());
+            Schema::Circle::Longitude::write(shapeNode, circle.center().longitude());
+            Schema::Circle::Radius::write(shapeNode, circle.radius());
+        }
+        else
+        if (shape.type() == QGeoShape::RectangleType)
+        {
+            QGeoRectangle rectangle(shape);
+            shapeNode = Schema::Rectangle::create();
+            lCoords << rectangle.topLeft() << rectangle.bottomRight();
+        }
+        else
+        if (shape.type() == QGeoShape::PathType)
+        {
+            shapeNode = Schema::Triangle::create();
+            lCoords = QGeoPath(shape).path();
+        }
+        else
+            continue;
+
+        foreach (QGeoCoordinate geoCoord, lCoords)
+        {
+            CXMLNode coordNode = Schema::Coord::create();
+            Schema::Coord::Latitude::write(coordNode, geoCoord.latitude());
+            Schema::Coord::Longitude::write(coordNode, geoCoord.longitude());
+            Schema::Coord::Altitude::write(coordNode, geoCoord.altitude());
+            shapeNode.nodes() << coordNode;
+        }
+        exclusionAreaNode.nodes() << shapeNode;
+    }
+    rootNode.nodes() << exclusionAreaNode;
+    return rootNode;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::deserializeExclusionArea(const CXMLNode &rootNode, QList<QGeoShape> &lExclusionArea, QString &sDroneUID)
+{
+    CXMLNode exclusionAreaNode = Schema::ExclusionArea::find(rootNode);
+    sDroneUID = Schema::ExclusionArea::DroneUID::read(exclusionAreaNode);
+    foreach (CXMLNode shapeNode, exclusionAreaNode.nodes())
+    {
+        // Shape coordinates
+        QList<QGeoCoordinate> lCoords;
+        foreach (CXMLNode coordNode, shapeNode.getNodesByTagName(Schema::Coord::name()))
+            lCoords << QGeoCoordinate(Schema::Coord::Latitude::read(coordNode), Schema::Coord::Longitude::read(coordNode), Schema::Coord::Altitude::read(coordNode));
+
+        if (Schema::Circle::is(shapeNode))
+        {
+            QGeoCoordinate center(Schema::Circle::Latitude::read(shapeNode), Schema::Circle::Longitude::read(shapeNode));
+            lExclusionArea << QGeoCircle(center, Schema::Circle::Radius::read(shapeNode));
+        }
+        else
+        if (Schema::Rectangle::is(shapeNode) && (lCoords.size() == 2))
+            lExclusionArea << QGeoRectangle(lCoords.first(), lCoords.last());
+        else
+        if (Schema::Triangle::is(shapeNode) && (lCoords.size() > 2))
+            lExclusionArea << QGeoPath(lCoords);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+CXMLNode SerializeHelper::serializeGeofenceEvent(const QString &sDroneUID, int iZone, SpyCore::ZoneType eZoneType, SpyCore::GeofenceEvent eEvent)
+{
+    CXMLNode rootNode;
+    CXMLNode geofenceNode = Schema::Geofence::create();
+    Schema::Geofence::DroneUID::write(geofenceNode, sDroneUID);
+    Schema::Geofence::Zone::write(geofenceNode, iZone);
+    Schema::Geofence::ZoneType::write(geofenceNode, eZoneType);
+    Schema::Geofence::Event::write(geofenceNode, eEvent);
+    rootNode.nodes() << geofenceNode;
+    return rootNode;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+CXMLNode SerializeHelper::serializeProximityAlert(const QString &sDroneUID, const QString &sOtherDroneUID, double dDistance, bool bConflict)
+{
+    CXMLNode rootNode;
+    CXMLNode proximityNode = Schema::Proximity::create();
+    Schema::Proximity::DroneUID::write(proximityNode, sDroneUID);
+    Schema::Proximity::OtherDroneUID::write(proximityNode, sOtherDroneUID);
+    Schema::Proximity::Distance::write(proximityNode, dDistance);
+    Schema::Proximity::Conflict::write(proximityNode, bConflict);
+    rootNode.nodes() << proximityNode;
+    return rootNode;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 CXMLNode SerializeHelper::serializeDroneError(const SpyCore::DroneError &eDroneError, const QString &sDroneUID)
 {
     CXMLNode rootNode;
-    CXMLNode errorNode(TAG_DRONE_ERROR);
-    errorNode.attributes()[ATTR_DRONE_UID] = sDroneUID;
-    errorNode.attributes()[ATTR_ERROR] = QString::number((int)eDroneError);
+    CXMLNode errorNode = Schema::DroneError::create();
+    Schema::DroneError::DroneUID::write(errorNode, sDroneUID);
+    Schema::DroneError::Error::write(errorNode, (int)eDroneError);
     rootNode.nodes() << errorNode;
     return rootNode;
 }
@@ -173,10 +434,16 @@ CXMLNode SerializeHelper::serializeDroneError(const SpyCore::DroneError &eDroneE
 
 void SerializeHelper::deSerializeDroneError(const QString &sErrorNode, int &iErrorCode, QString &sDroneUID)
 {
-    CXMLNode msgNode = CXMLNode::parseJSON(sErrorNode);
-    CXMLNode droneErrorNode = msgNode.getNodeByTagName(TAG_DRONE_ERROR);
-    sDroneUID = droneErrorNode.attributes()[ATTR_DRONE_UID];
-    iErrorCode = droneErrorNode.attributes()[ATTR_ERROR].toInt();
+    deSerializeDroneError(CXMLNode::parseJSON(sErrorNode), iErrorCode, sDroneUID);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SerializeHelper::deSerializeDroneError(const CXMLNode &msgNode, int &iErrorCode, QString &sDroneUID)
+{
+    CXMLNode droneErrorNode = Schema::DroneError::find(msgNode);
+    sDroneUID = Schema::DroneError::DroneUID::read(droneErrorNode);
+    iErrorCode = Schema::DroneError::Error::read(droneErrorNode);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -184,9 +451,9 @@ void SerializeHelper::deSerializeDroneError(const QString &sErrorNode, int &iErr
 CXMLNode SerializeHelper::serializeTakeOffRequest(const QString &sDroneUID)
 {
     CXMLNode rootNode;
-    CXMLNode failSafeNode(TAG_TAKE_OFF);
-    failSafeNode.attributes()[ATTR_DRONE_UID] = sDroneUID;
-    rootNode.nodes() << failSafeNode;
+    CXMLNode takeOffNode = Schema::TakeOff::create();
+    Schema::TakeOff::DroneUID::write(takeOffNode, sDroneUID);
+    rootNode.nodes() << takeOffNode;
     return rootNode;
 }
 
@@ -194,7 +461,7 @@ CXMLNode SerializeHelper::serializeTakeOffRequest(const QString &sDroneUID)
 
 void SerializeHelper::deserializeTakeOffRequest(const CXMLNode &takeOffRequestNode, QString &sDroneUID)
 {
-    sDroneUID = takeOffRequestNode.attributes()[ATTR_DRONE_UID];
+    sDroneUID = Schema::TakeOff::DroneUID::read(takeOffRequestNode);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -202,8 +469,8 @@ void SerializeHelper::deserializeTakeOffRequest(const CXMLNode &takeOffRequestNo
 CXMLNode SerializeHelper::serializeFailSafeRequest(const QString &sDroneUID)
 {
     CXMLNode rootNode;
-    CXMLNode failSafeNode(TAG_FAIL_SAFE);
-    failSafeNode.attributes()[ATTR_DRONE_UID] = sDroneUID;
+    CXMLNode failSafeNode = Schema::FailSafe::create();
+    Schema::FailSafe::DroneUID::write(failSafeNode, sDroneUID);
     rootNode.nodes() << failSafeNode;
     return rootNode;
 }
@@ -213,8 +480,8 @@ CXMLNode SerializeHelper::serializeFailSafeRequest(const QString &sDroneUID)
 CXMLNode SerializeHelper::serializeFailSafeDone(const QString &sDroneUID)
 {
     CXMLNode rootNode;
-    CXMLNode failSafeDoneNode(TAG_FAIL_SAFE_DONE);
-    failSafeDoneNode.attributes()[ATTR_DRONE_UID] = sDroneUID;
+    CXMLNode failSafeDoneNode = Schema::FailSafeDone::create();
+    Schema::FailSafeDone::DroneUID::write(failSafeDoneNode, sDroneUID);
     rootNode.nodes() << failSafeDoneNode;
     return rootNode;
 }
@@ -223,7 +490,57 @@ CXMLNode SerializeHelper::serializeFailSafeDone(const QString &sDroneUID)
 
 void SerializeHelper::deserializeFailSafeRequest(const CXMLNode &failSafeRequestNode, QString &sDroneUID)
 {
-    sDroneUID = failSafeRequestNode.attributes()[ATTR_DRONE_UID];
+    sDroneUID = Schema::FailSafe::DroneUID::read(failSafeRequestNode);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+CXMLNode SerializeHelper::serializeBatch(const QVector<CXMLNode> &vMessages)
+{
+    CXMLNode rootNode;
+    CXMLNode batchNode = Schema::Batch::create();
+    for (int i=0; i<vMessages.size(); i++)
+    {
+        CXMLNode entryNode = Schema::BatchEntry::create();
+        Schema::BatchEntry::Index::write(entryNode, i);
+        entryNode.merge(vMessages[i]);
+        batchNode.nodes() << entryNode;
+    }
+    rootNode.nodes() << batchNode;
+    return rootNode;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QVector<CXMLNode> SerializeHelper::deserializeBatch(const CXMLNode &msgNode)
+{
+    QVector<CXMLNode> vMessages;
+    CXMLNode batchNode = Schema::Batch::find(msgNode);
+
+    // Entries in rank order
+    QVector<QPair<int, CXMLNode> > vEntries;
+    foreach (CXMLNode childNode, batchNode.nodes())
+        if (Schema::BatchEntry::is(childNode))
+            vEntries << qMakePair(Schema::BatchEntry::Index::read(childNode, vEntries.size()), childNode);
+    std::stable_sort(vEntries.begin(), vEntries.end(), [](const QPair<int, CXMLNode> &a, const QPair<int, CXMLNode> &b) { return a.first < b.first; });
+    for (int i=0; i<vEntries.size(); i++)
+    {
+        CXMLNode rootNode;
+        rootNode.merge(vEntries[i].second);
+        vMessages << rootNode;
+    }
+
+    // Peers older than entries put messages right under the batch (order kept by XML only)
+    if (vEntries.isEmpty())
+    {
+        foreach (CXMLNode childNode, batchNode.nodes())
+        {
+            CXMLNode rootNode;
+            rootNode.nodes() << childNode;
+            vMessages << rootNode;
+        }
+    }
+    return vMessages;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -232,24 +549,24 @@ CXMLNode SerializeHelper::writeGeoPath(const QVector<Core::WayPoint> &plan, cons
 {
     CXMLNode rootNode;
     CXMLNode planNode(sPlanType);
-    planNode.attributes()[ATTR_DRONE_UID] = sDroneUID;
+    Schema::MissionPlan::DroneUID::write(planNode, sDroneUID);
     foreach (Core::WayPoint wayPoint, plan)
     {
         // Static attributes
-        CXMLNode wayPointNode(TAG_WAY_POINT);
-        wayPointNode.attributes()[ATTR_LATITUDE] = QString::number(wayPoint.geoCoord().latitude());
-        wayPointNode.attributes()[ATTR_LONGITUDE] = QString::number(wayPoint.geoCoord().longitude());
-        wayPointNode.attributes()[ATTR_ALTITUDE] = QString::number( wayPoint.geoCoord().altitude());
-        wayPointNode.attributes()[ATTR_WAY_POINT_TYPE] = QString::number((int)wayPoint.type());
-        wayPointNode.attributes()[ATTR_WAY_POINT_SPEED] = QString::number((int)wayPoint.speed());
-        wayPointNode.attributes()[ATTR_WAY_POINT_CLOCKWISE] = QString::number((int)wayPoint.clockWise());
+        CXMLNode wayPointNode = Schema::WayPoint::create();
+        Schema::WayPoint::Latitude::write(wayPointNode, wayPoint.point().dLatitude);
+        Schema::WayPoint::Longitude::write(wayPointNode, wayPoint.point().dLongitude);
+        Schema::WayPoint::Altitude::write(wayPointNode, wayPoint.point().dAltitude);
+        Schema::WayPoint::Type::write(wayPointNode, wayPoint.type());
+        Schema::WayPoint::Speed::write(wayPointNode, (SpyCore::PointSpeed)wayPoint.speed());
+        Schema::WayPoint::ClockWise::write(wayPointNode, wayPoint.clockWise());
 
         // Metadata
-        if (!wayPoint.metaData().isEmpty())
+        if (wayPoint.metaDataCount() > 0)
         {
-            CXMLNode wayPointMetaDataNode(TAG_WAY_POINT_METADATA);
-            for (QHash<QString, double>::const_iterator it=wayPoint.metaData().begin(); it!=wayPoint.metaData().end(); ++it)
-                wayPointMetaDataNode.attributes()[it.key()] = QString::number(it.value());
+            CXMLNode wayPointMetaDataNode = Schema::WayPointMetaData::create();
+            for (int i=0; i<wayPoint.metaDataCount(); i++)
+                wayPointMetaDataNode.attributes()[WayPoint::metaDataName(wayPoint.metaDataKeyAt(i))] = QString::number(wayPoint.metaDataValueAt(i));
             wayPointNode.nodes() << wayPointMetaDataNode;
         }
         planNode.nodes() << wayPointNode;
@@ -265,17 +582,17 @@ CXMLNode SerializeHelper::writeGeoPath(const QGeoPath &plan, const QString &sPla
 {
     CXMLNode rootNode;
     CXMLNode planNode(sPlanType);
-    planNode.attributes()[ATTR_DRONE_UID] = sDroneUID;
+    Schema::SafetyPlan::DroneUID::write(planNode, sDroneUID);
     for (int i=0; i<plan.size(); i++)
     {
         // Get geocoord
         QGeoCoordinate geoCoord = plan.coordinateAt(i);
 
         // Static attributes
-        CXMLNode wayPointNode(TAG_WAY_POINT);
-        wayPointNode.attributes()[ATTR_LATITUDE] = QString::number(geoCoord.latitude());
-        wayPointNode.attributes()[ATTR_LONGITUDE] = QString::number(geoCoord.longitude());
-        wayPointNode.attributes()[ATTR_ALTITUDE] = QString::number( geoCoord.altitude());
+        CXMLNode wayPointNode = Schema::WayPoint::create();
+        Schema::WayPoint::Latitude::write(wayPointNode, geoCoord.latitude());
+        Schema::WayPoint::Longitude::write(wayPointNode, geoCoord.longitude());
+        Schema::WayPoint::Altitude::write(wayPointNode, geoCoord.altitude());
         planNode.nodes() << wayPointNode;
     }
     rootNode.nodes() << planNode;
@@ -286,21 +603,30 @@ CXMLNode SerializeHelper::writeGeoPath(const QGeoPath &plan, const QString &sPla
 
 void SerializeHelper::readPlan(const CXMLNode &node, WayPointList &vWayPointList)
 {
-    QVector<CXMLNode> vWayPointNodes = node.getNodesByTagName(TAG_WAY_POINT);
+    QVector<CXMLNode> vWayPointNodes = node.getNodesByTagName(Schema::WayPoint::name());
     foreach (CXMLNode wayPointNode, vWayPointNodes)
     {
         // Static attributes
-        double dLatitude = wayPointNode.attributes()[ATTR_LATITUDE].toDouble();
-        double dLongitude = wayPointNode.attributes()[ATTR_LONGITUDE].toDouble();
-        double dAltitude = wayPointNode.attributes()[ATTR_ALTITUDE].toDouble();
-        int iType = wayPointNode.attributes()[ATTR_WAY_POINT_TYPE].toInt();
-        int iSpeed = wayPointNode.attributes()[ATTR_WAY_POINT_SPEED].toInt();
-        bool bClockWise = (bool)wayPointNode.attributes()[ATTR_WAY_POINT_CLOCKWISE].toInt();
-
-        QGeoCoordinate geoCoord(dLatitude, dLongitude, dAltitude);
-        Core::WayPoint wayPoint(geoCoord, (SpyCore::PointType)iType);
-        wayPoint.setSpeed((SpyCore::PointSpeed)iSpeed);
+        double dLatitude = Schema::WayPoint::Latitude::read(wayPointNode);
+        double dLongitude = Schema::WayPoint::Longitude::read(wayPointNode);
+        double dAltitude = Schema::WayPoint::Altitude::read(wayPointNode);
+        SpyCore::PointType eType = Schema::WayPoint::Type::read(wayPointNode, SpyCore::POINT);
+        SpyCore::PointSpeed eSpeed = Schema::WayPoint::Speed::read(wayPointNode, SpyCore::ECO);
+        bool bClockWise = Schema::WayPoint::ClockWise::read(wayPointNode, false);
+
+        Core::WayPoint wayPoint(GeoPoint(dLatitude, dLongitude, dAltitude), eType);
+        wayPoint.setSpeed(eSpeed);
         wayPoint.setClockWise(bClockWise);
+
+        // Metadata
+        CXMLNode wayPointMetaDataNode = Schema::WayPointMetaData::find(wayPointNode);
+        for (QMap<QString, QString>::const_iterator it=wayPointMetaDataNode.attributes().constBegin(); it!=wayPointMetaDataNode.attributes().constEnd(); ++it)
+        {
+            bool bOk = false;
+            double dValue = it.value().toDouble(&bOk);
+            if (bOk)
+                wayPoint.setMetaData(it.key(), dValue);
+        }
         vWayPointList << wayPoint;
     }
 }
@@ -309,26 +635,43 @@ void SerializeHelper::readPlan(const CXMLNode &node, WayPointList &vWayPointList
 
 QGeoPath SerializeHelper::readGeoPath(const CXMLNode &node)
 {
-    QVector<CXMLNode> vWayPointNodes = node.getNodesByTagName(TAG_WAY_POINT);
-    QGeoPath geoPath;
+    QVector<CXMLNode> vWayPointNodes = node.getNodesByTagName(Schema::WayPoint::name());
+
+    // Path is built once: adding coordinates one by one copies the shared path each time
+    QList<QGeoCoordinate> lPath;
+    lPath.reserve(vWayPointNodes.size());
     foreach (CXMLNode wayPointNode, vWayPointNodes)
     {
         // Static attributes
-        double dLatitude = wayPointNode.attributes()[ATTR_LATITUDE].toDouble();
-        double dLongitude = wayPointNode.attributes()[ATTR_LONGITUDE].toDouble();
-        double dAltitude = wayPointNode.attributes()[ATTR_ALTITUDE].toDouble();
-        QGeoCoordinate geoCoord(dLatitude, dLongitude, dAltitude);
-        geoPath.addCoordinate(geoCoord);
+        double dLatitude = Schema::WayPoint::Latitude::read(wayPointNode);
+        double dLongitude = Schema::WayPoint::Longitude::read(wayPointNode);
+        double dAltitude = Schema::WayPoint::Altitude::read(wayPointNode);
+        lPath << QGeoCoordinate(dLatitude, dLongitude, dAltitude);
     }
-    return geoPath;
+    return QGeoPath(lPath);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 QString SerializeHelper::messageType(const QString &sMessage)
 {
-    CXMLNode rootNode = CXMLNode::parseJSON(sMessage);
-    if (!rootNode.nodes().isEmpty())
-        return rootNode.nodes().first().tag();
+    return messageType(CXMLNode::parseJSON(sMessage));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QString SerializeHelper::messageType(const CXMLNode &msgNode)
+{
+    if (!msgNode.nodes().isEmpty())
+        return msgNode.nodes().first().tag();
     return QString("");
 }
+
+//-------------------------------------------------------------------------------------------------
+
+int SerializeHelper::droneHandle(const CXMLNode &msgNode)
+{
+    if (!msgNode.nodes().isEmpty())
+        return Schema::DroneHandle::read(msgNode.nodes().first(), -1);
+    return -1;
+}
@@ -4,6 +4,8 @@
 // Application
 #include "droneemulator.h"
 #include "waypoint.h"
+#include "fleetstate.h"
+#include "planvalidator.h"
 #include <cxmlnode.h>
 #include "spyclib_global.h"
 class BaseShape;
@@ -12,12 +14,24 @@ namespace Core {
 class SPYCLIBSHARED_EXPORT SerializeHelper
 {
 public:
-    //! Serialize drone status
-    static CXMLNode serializeDroneStatus(const DroneEmulator &drone);
+    //! Serialize drone status (iTimestamp: simulation time in ms, omitted if negative)
+    static CXMLNode serializeDroneStatus(const DroneEmulator &drone, qint64 iTimestamp=-1);
+
+    //! Serialize drone status straight from fleet state
+    static CXMLNode serializeDroneStatus(const FleetState &fleetState, int iSlot, qint64 iTimestamp=-1);
+
+    //! Serialize status of every active drone of the fleet (one pass over fleet state)
+    static QVector<CXMLNode> serializeFleetStatus(const FleetState &fleetState);
 
     //! Deserialize drone status
     static void deserializeDroneStatus(const QString &sDroneStatus, QString &sDroneUID, SpyCore::FlightStatus &eFlightStatus, QGeoCoordinate &position, double &dHeading, int &iBatteryLevel, int &iReturnLevel, QString &sVideoUrl);
 
+    //! Deserialize drone status
+    static void deserializeDroneStatus(const CXMLNode &msgNode, QString &sDroneUID, SpyCore::FlightStatus &eFlightStatus, QGeoCoordinate &position, double &dHeading, int &iBatteryLevel, int &iReturnLevel, QString &sVideoUrl);
+
+    //! Deserialize what a client needs to extrapolate a drone (see GeoUtils::extrapolate, iTimestamp is -1 if not sent)
+    static void deserializeDroneMotion(const CXMLNode &msgNode, QString &sDroneUID, QGeoCoordinate &position, double &dVelocityNorth, double &dVelocityEast, qint64 &iTimestamp);
+
     //! Serialize drone position
     static CXMLNode serializePosition(const QGeoCoordinate &geoCoord, double dHeading);
 
@@ -36,24 +50,69 @@ public:
     //! Serialize mission plan
     static void deserializeMissionPlan(const QString &sMissionPlan, QVector<WayPoint> &vWayPoints, QString &sDroneUID);
 
+    //! Deserialize mission plan
+    static void deserializeMissionPlan(const CXMLNode &msgNode, QVector<WayPoint> &vWayPoints, QString &sDroneUID);
+
     //! Serialize safety plan
     static CXMLNode serializeSafetyPlan(const QGeoPath &vWayPoints, const QString &sDroneUID);
 
     //! Deserialize safety plan
     static void deserializeSafetyPlan(const QString &sSafetyPlan, QGeoPath &geoPath, QString &sDroneUID);
 
+    //! Deserialize safety plan
+    static void deserializeSafetyPlan(const CXMLNode &msgNode, QGeoPath &geoPath, QString &sDroneUID);
+
     //! Serialize landing plan
     static CXMLNode serializeLandingPlan(const QVector<Core::WayPoint> &vWayPoints, const QString &sDroneUID);
 
     //! Serialize mission plan
     static void deserializeLandingPlan(const QString &sMissionPlan, QVector<WayPoint> &vWayPoints, QString &sDroneUID);
 
+    //! Deserialize landing plan
+    static void deserializeLandingPlan(const CXMLNode &msgNode, QVector<WayPoint> &vWayPoints, QString &sDroneUID);
+
+    //! Serialize route
+    static CXMLNode serializeRoute(const QVector<Core::WayPoint> &vWayPoints, const QString &sDroneUID);
+
+    //! Deserialize route
+    static void deserializeRoute(const CXMLNode &msgNode, QVector<WayPoint> &vWayPoints, QString &sDroneUID);
+
+    //! Serialize trajectory pushed at take off (flown from dProgress m at simulation time iTimestamp ms)
+    static CXMLNode serializeTrajectory(const QVector<Core::WayPoint> &vWayPoints, const QString &sDroneUID, qint64 iTimestamp, double dProgress);
+
+    //! Deserialize trajectory
+    static void deserializeTrajectory(const CXMLNode &msgNode, QVector<WayPoint> &vWayPoints, QString &sDroneUID, qint64 &iTimestamp, double &dProgress);
+
+    //! Append progress along pushed trajectory to a serialized drone status
+    static void appendProgress(CXMLNode &rootNode, double dProgress);
+
+    //! Append validation issues to a serialized plan (mission, safety or landing)
+    static void appendPlanErrors(CXMLNode &rootNode, const QVector<PlanValidator::Issue> &vIssues);
+
+    //! Deserialize validation issues of a plan
+    static QVector<PlanValidator::Issue> deserializePlanErrors(const CXMLNode &planNode);
+
+    //! Serialize exclusion area (circles, rectangles and triangles)
+    static CXMLNode serializeExclusionArea(const QList<QGeoShape> &lExclusionArea, const QString &sDroneUID);
+
+    //! Deserialize exclusion area
+    static void deserializeExclusionArea(const CXMLNode &msgNode, QList<QGeoShape> &lExclusionArea, QString &sDroneUID);
+
+    //! Serialize geofence event
+    static CXMLNode serializeGeofenceEvent(const QString &sDroneUID, int iZone, SpyCore::ZoneType eZoneType, SpyCore::GeofenceEvent eEvent);
+
+    //! Serialize proximity alert
+    static CXMLNode serializeProximityAlert(const QString &sDroneUID, const QString &sOtherDroneUID, double dDistance, bool bConflict);
+
     //! Serialize drone error
     static CXMLNode serializeDroneError(const  SpyCore::DroneError &eDroneError, const QString &sDroneUID);
 
     //! Serialize drone error
     static void deSerializeDroneError(const QString &sErrorNode, int &iErrorCode, QString &sDroneUID);
 
+    //! Deserialize drone error
+    static void deSerializeDroneError(const CXMLNode &msgNode, int &iErrorCode, QString &sDroneUID);
+
     //! Serialize take off request
     static CXMLNode serializeTakeOffRequest(const QString &sDroneUID);
 
@@ -69,6 +128,12 @@ public:
     //! Deserialize fail safe request
     static void deserializeFailSafeRequest(const CXMLNode &failSafeRequest, QString &sDroneUID);
 
+    //! Serialize batch (wraps every message of vMessages in one envelope, as indexed entries so that every format keeps their order)
+    static CXMLNode serializeBatch(const QVector<CXMLNode> &vMessages);
+
+    //! Deserialize batch (returns each message as a standalone message, in batch order)
+    static QVector<CXMLNode> deserializeBatch(const CXMLNode &msgNode);
+
     //! Write geopath
     static CXMLNode writeGeoPath(const QVector<Core::WayPoint> &plan, const QString &sPlanType, const QString &sDroneUID);
 
@@ -83,6 +148,12 @@ public:
 
     //! Return message type
     static QString messageType(const QString &sMessage);
+
+    //! Return message type
+    static QString messageType(const CXMLNode &msgNode);
+
+    //! Return handle of the drone targeted by a message (-1 if addressed by UID only)
+    static int droneHandle(const CXMLNode &msgNode);
 };
 }
 
@@ -0,0 +1,45 @@
+#ifndef SIMULATIONCONTEXT_H
+#define SIMULATIONCONTEXT_H
+
+// Qt
+#include <QtGlobal>
+
+namespace Core {
+class SimulationScheduler;
+class FleetState;
+class FleetKinematics;
+class WorkerPool;
+class GeofenceEngine;
+class TerrainCache;
+class SimulatorObserver;
+
+//! Simulation services shared by every emulated drone
+struct SimulationContext
+{
+    //! Scheduler
+    SimulationScheduler *pScheduler = nullptr;
+
+    //! Fleet state
+    FleetState *pFleetState = nullptr;
+
+    //! Fleet kinematics (batch flight stepping)
+    FleetKinematics *pKinematics = nullptr;
+
+    //! Worker pool (fleet wide work is partitioned over it)
+    WorkerPool *pWorkerPool = nullptr;
+
+    //! Geofence engine (safety plan and exclusion areas of every drone)
+    GeofenceEngine *pGeofence = nullptr;
+
+    //! Terrain elevation (null: flat earth, way point altitudes are flown as is)
+    TerrainCache *pTerrain = nullptr;
+
+    //! Minimum height above ground kept by drones (m, terrain following)
+    double dTerrainClearance = 0;
+
+    //! Simulator output observer (null: none, see SimulatorSignals for Qt consumers)
+    SimulatorObserver *pObserver = nullptr;
+};
+}
+
+#endif // SIMULATIONCONTEXT_H
@@ -0,0 +1,231 @@
+// Qt
+#include <QDebug>
+
+// Application
+#include "simulationscheduler.h"
+#define WHEEL_SIZE 64
+#define MAX_CATCH_UP_TICKS 10
+#define MAX_BATCH_TICKS 200
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+SimulationScheduler::SimulationScheduler(int iStepMs, QObject *pParent) : QObject(pParent),
+    m_iStepMs(qMax(1, iStepMs))
+{
+    m_vWheel.resize(WHEEL_SIZE);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(m_iStepMs);
+    connect(&m_timer, &QTimer::timeout, this, &SimulationScheduler::onTimeOut, Qt::DirectConnection);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+SimulationScheduler::~SimulationScheduler()
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int SimulationScheduler::stepMs() const
+{
+    return m_iStepMs;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+qint64 SimulationScheduler::tick() const
+{
+    return m_iTick;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+qint64 SimulationScheduler::simulationTime() const
+{
+    return m_iTick*m_iStepMs;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+qint64 SimulationScheduler::overrunCount() const
+{
+    return m_iOverrunCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int SimulationScheduler::taskCount() const
+{
+    return m_hTasks.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::setSpeedFactor(double dSpeedFactor)
+{
+    m_dSpeedFactor = qMax(0., dSpeedFactor);
+
+    // Faster than real time: the timer only gives the event loop a chance to run between batches
+    m_timer.setInterval(((m_dSpeedFactor <= 0) || (m_dSpeedFactor > 1)) ? 0 : m_iStepMs);
+    if (m_timer.isActive())
+        start();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double SimulationScheduler::speedFactor() const
+{
+    return m_dSpeedFactor;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+qint64 SimulationScheduler::wallTime() const
+{
+    return m_clock.isValid() ? m_clock.elapsed() : 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int SimulationScheduler::addTask(int iPeriodMs, const Task &task, bool bEnabled)
+{
+    int iTaskId = m_iNextTaskId++;
+    Entry &entry = m_hTasks[iTaskId];
+    entry.task = task;
+    entry.iPeriod = qMax(1, qRound((double)iPeriodMs/m_iStepMs));
+    entry.bEnabled = bEnabled;
+    if (bEnabled)
+        schedule(iTaskId);
+    return iTaskId;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::removeTask(int iTaskId)
+{
+    // Wheel items of removed tasks are dropped when their slot comes up
+    m_hTasks.remove(iTaskId);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::setTaskEnabled(int iTaskId, bool bEnabled)
+{
+    QHash<int, Entry>::iterator it = m_hTasks.find(iTaskId);
+    if ((it != m_hTasks.end()) && (it->bEnabled != bEnabled))
+    {
+        it->bEnabled = bEnabled;
+        if (bEnabled)
+            schedule(iTaskId);
+        else
+            it->iStamp++;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::start()
+{
+    m_iDroppedMs = -m_iTick*m_iStepMs;
+    m_clock.start();
+    m_timer.start();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::stop()
+{
+    m_timer.stop();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::schedule(int iTaskId)
+{
+    Entry &entry = m_hTasks[iTaskId];
+    entry.iDueTick = m_iTick+entry.iPeriod;
+    entry.iStamp++;
+    Item item;
+    item.iTaskId = iTaskId;
+    item.iStamp = entry.iStamp;
+    m_vWheel[entry.iDueTick%WHEEL_SIZE] << item;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::advance()
+{
+    m_iTick++;
+
+    // Take current slot: items due in a later round are put back
+    QVector<Item> vItems;
+    vItems.swap(m_vWheel[m_iTick%WHEEL_SIZE]);
+
+    foreach (Item item, vItems)
+    {
+        QHash<int, Entry>::iterator it = m_hTasks.find(item.iTaskId);
+        if ((it == m_hTasks.end()) || (it->iStamp != item.iStamp))
+            continue;
+        if (it->iDueTick > m_iTick)
+        {
+            m_vWheel[m_iTick%WHEEL_SIZE] << item;
+            continue;
+        }
+
+        // Reschedule before running: the task may add or remove tasks
+        Task task = it->task;
+        schedule(item.iTaskId);
+        task();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::advance(qint64 iTicks)
+{
+    for (qint64 i=0; i<iTicks; i++)
+        advance();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulationScheduler::onTimeOut()
+{
+    // As fast as possible: one batch of ticks per event loop iteration
+    if (m_dSpeedFactor <= 0)
+    {
+        advance(MAX_BATCH_TICKS);
+        return;
+    }
+
+    // Fixed steps: run every tick the (scaled) clock says is due
+    qint64 iTargetTick = ((qint64)(m_clock.elapsed()*m_dSpeedFactor)-m_iDroppedMs)/m_iStepMs;
+    int iMaxTicks = m_dSpeedFactor > 1 ? MAX_BATCH_TICKS : MAX_CATCH_UP_TICKS;
+    double dTickBudgetMs = m_iStepMs/m_dSpeedFactor;
+    int iCatchUp = 0;
+    while ((m_iTick < iTargetTick) && (iCatchUp < iMaxTicks))
+    {
+        QElapsedTimer tickTimer;
+        tickTimer.start();
+        advance();
+        iCatchUp++;
+
+        qint64 iElapsed = tickTimer.elapsed();
+        if (iElapsed > dTickBudgetMs)
+        {
+            m_iOverrunCount++;
+            emit tickOverrun(m_iTick, iElapsed-(qint64)dTickBudgetMs);
+        }
+    }
+
+    // Too far behind: let simulation time slip instead of spiralling
+    if (m_iTick < iTargetTick)
+    {
+        qint64 iLateMs = (iTargetTick-m_iTick)*m_iStepMs;
+        m_iDroppedMs += iLateMs;
+        m_iOverrunCount++;
+        emit tickOverrun(m_iTick, iLateMs);
+    }
+}
@@ -0,0 +1,163 @@
+#ifndef SIMULATIONSCHEDULER_H
+#define SIMULATIONSCHEDULER_H
+
+// Qt
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QHash>
+
+// Std
+#include <functional>
+
+// Application
+#include "spyclib_global.h"
+
+namespace Core {
+class SPYCLIBSHARED_EXPORT SimulationScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Task
+    typedef std::function<void()> Task;
+
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor
+    explicit SimulationScheduler(int iStepMs=50, QObject *pParent=nullptr);
+
+    //! Destructor
+    virtual ~SimulationScheduler();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Return step (ms)
+    int stepMs() const;
+
+    //! Return current tick
+    qint64 tick() const;
+
+    //! Return simulation time (ms)
+    qint64 simulationTime() const;
+
+    //! Return number of overruns
+    qint64 overrunCount() const;
+
+    //! Return number of tasks
+    int taskCount() const;
+
+    //! Set speed factor: 1 is real time, 10 is ten times faster, 0 is as fast as possible
+    void setSpeedFactor(double dSpeedFactor);
+
+    //! Return speed factor
+    double speedFactor() const;
+
+    //! Return wall clock time since start (ms)
+    qint64 wallTime() const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Add task run every iPeriodMs (rounded to a whole number of steps), return task id
+    int addTask(int iPeriodMs, const Task &task, bool bEnabled=true);
+
+    //! Remove task
+    void removeTask(int iTaskId);
+
+    //! Enable/disable task
+    void setTaskEnabled(int iTaskId, bool bEnabled);
+
+    //! Start
+    void start();
+
+    //! Stop
+    void stop();
+
+    //! Advance one step
+    void advance();
+
+    //! Advance iTicks steps right away (virtual clock, no event loop needed)
+    void advance(qint64 iTicks);
+
+private:
+    //! Task entry
+    struct Entry
+    {
+        //! Task
+        Task task;
+
+        //! Period (ticks)
+        int iPeriod = 1;
+
+        //! Next due tick
+        qint64 iDueTick = 0;
+
+        //! Stamp of the last scheduling (older wheel items are stale)
+        quint32 iStamp = 0;
+
+        //! Enabled?
+        bool bEnabled = true;
+    };
+
+    //! Wheel item
+    struct Item
+    {
+        //! Task id
+        int iTaskId;
+
+        //! Stamp
+        quint32 iStamp;
+    };
+
+    //! Put task in the wheel slot of its next due tick
+    void schedule(int iTaskId);
+
+private:
+    //! Step (ms)
+    int m_iStepMs = 50;
+
+    //! Current tick
+    qint64 m_iTick = 0;
+
+    //! Simulation time dropped when too far behind (ms)
+    qint64 m_iDroppedMs = 0;
+
+    //! Speed factor
+    double m_dSpeedFactor = 1;
+
+    //! Number of overruns
+    qint64 m_iOverrunCount = 0;
+
+    //! Next task id
+    int m_iNextTaskId = 0;
+
+    //! Tasks
+    QHash<int, Entry> m_hTasks;
+
+    //! Timer wheel
+    QVector<QVector<Item> > m_vWheel;
+
+    //! Clock source
+    QElapsedTimer m_clock;
+
+    //! Timer
+    QTimer m_timer;
+
+public slots:
+    //! Time out
+    void onTimeOut();
+
+signals:
+    //! A tick took longer than a step, or ticks were dropped to catch up with the clock
+    void tickOverrun(qint64 iTick, qint64 iLateMs);
+};
+}
+
+#endif // SIMULATIONSCHEDULER_H
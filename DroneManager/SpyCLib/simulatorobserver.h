@@ -0,0 +1,26 @@
+#ifndef SIMULATOROBSERVER_H
+#define SIMULATOROBSERVER_H
+
+// Qt
+#include <QtGlobal>
+
+// Application
+#include "spyclib_global.h"
+
+namespace Core {
+//! Simulator output observer (called on the simulation thread once fleet state is written, plain C++: no event queue)
+class SPYCLIBSHARED_EXPORT SimulatorObserver
+{
+public:
+    //! Destructor
+    virtual ~SimulatorObserver() {}
+
+    //! Drone position moved to a new kinematics segment
+    virtual void onPositionChanged(int iSlot) { Q_UNUSED(iSlot); }
+
+    //! Drone battery level updated
+    virtual void onBatteryLevelChanged(int iSlot) { Q_UNUSED(iSlot); }
+};
+}
+
+#endif // SIMULATOROBSERVER_H
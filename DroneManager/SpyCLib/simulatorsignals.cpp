@@ -0,0 +1,33 @@
+// Application
+#include "simulatorsignals.h"
+#include "fleetstate.h"
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+SimulatorSignals::SimulatorSignals(const FleetState *pFleetState, QObject *pParent) : QObject(pParent),
+    m_pFleetState(pFleetState)
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+SimulatorSignals::~SimulatorSignals()
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulatorSignals::onPositionChanged(int iSlot)
+{
+    emit positionChanged(iSlot, m_pFleetState->position(iSlot), m_pFleetState->heading(iSlot));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void SimulatorSignals::onBatteryLevelChanged(int iSlot)
+{
+    emit batteryLevelChanged(iSlot, m_pFleetState->batteryLevel(iSlot), m_pFleetState->returnLevel(iSlot));
+}
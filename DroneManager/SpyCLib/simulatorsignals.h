@@ -0,0 +1,52 @@
+#ifndef SIMULATORSIGNALS_H
+#define SIMULATORSIGNALS_H
+
+// Qt
+#include <QObject>
+#include <QGeoCoordinate>
+
+// Application
+#include "simulatorobserver.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class FleetState;
+class SPYCLIBSHARED_EXPORT SimulatorSignals : public QObject, public SimulatorObserver
+{
+    Q_OBJECT
+
+public:
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor (hand it to drones through SimulationContext::pObserver)
+    SimulatorSignals(const FleetState *pFleetState, QObject *pParent=nullptr);
+
+    //! Destructor
+    ~SimulatorSignals();
+
+    //-------------------------------------------------------------------------------------------------
+    // SimulatorObserver
+    //-------------------------------------------------------------------------------------------------
+
+    //! Emit positionChanged with current position
+    virtual void onPositionChanged(int iSlot);
+
+    //! Emit batteryLevelChanged with current levels
+    virtual void onBatteryLevelChanged(int iSlot);
+
+private:
+    //! Fleet state
+    const FleetState *m_pFleetState = nullptr;
+
+signals:
+    //! Position changed (emitted on each kinematics segment)
+    void positionChanged(int iSlot, const QGeoCoordinate &geoCoord, double dHeading);
+
+    //! Battery level changed
+    void batteryLevelChanged(int iSlot, int iLevel, int iReturn);
+};
+}
+
+#endif // SIMULATORSIGNALS_H
@@ -19,6 +19,8 @@ class SPYCLIBSHARED_EXPORT SpyCore : public QObject
     Q_ENUMS(Status)
     Q_ENUMS(WorkMode)
     Q_ENUMS(ExclusionShape)
+    Q_ENUMS(ZoneType)
+    Q_ENUMS(GeofenceEvent)
     Q_ENUMS(DroneRole)
     Q_ENUMS(ShapeRole)
     Q_ENUMS(GalleryRole)
@@ -41,7 +43,7 @@ public:
     enum FlightStatus {IDLE=Qt::UserRole+1, FLYING};
 
     //! Drone error
-    enum DroneError {NO_SAFETY=Qt::UserRole+1, NO_LANDING_PLAN, NO_MISSION_PLAN};
+    enum DroneError {NO_SAFETY=Qt::UserRole+1, NO_LANDING_PLAN, NO_MISSION_PLAN, BATTERY_LOW, BATTERY_EMPTY};
 
     //! Point type
     enum PointType {POINT=Qt::UserRole+1, LOITER, EIGHT, HIPPODROM};
@@ -64,6 +66,12 @@ public:
     //! Exclusion shape
     enum ExclusionShape {CIRCLE=Qt::UserRole+1, RECTANGLE, TRIANGLE};
 
+    //! Geofence zone type
+    enum ZoneType {SAFETY_ZONE=Qt::UserRole+1, EXCLUSION_ZONE};
+
+    //! Geofence event
+    enum GeofenceEvent {ZONE_ENTRY=Qt::UserRole+1, ZONE_EXIT};
+
     //! Drone role
     enum DroneRole {Drone=Qt::UserRole+1};
 
@@ -76,7 +84,10 @@ public:
     //! Mission plan error
     enum MissionPlanError {EMPTY_SAFETY=Qt::UserRole+1, NOT_ENOUGH_POINTS_IN_SAFETY,
                            EMPTY_MISSION_PLAN, NOT_ENOUGH_POINTS_IN_MISSION_PLAN, EMPTY_EXCLUSION_AREA,
-                           EMPTY_LANDING_PLAN, UNEXPECTED_LANDING_PLAN_COUNT};
+                           EMPTY_LANDING_PLAN, UNEXPECTED_LANDING_PLAN_COUNT, SELF_INTERSECTING_SAFETY,
+                           SELF_INTERSECTING_MISSION_PLAN, MISSION_PLAN_IN_EXCLUSION_AREA, MISSION_PLAN_OUTSIDE_SAFETY,
+                           LANDING_PLAN_IN_EXCLUSION_AREA, LANDING_PLAN_OUTSIDE_SAFETY, MISSION_PLAN_BELOW_TERRAIN,
+                           LANDING_PLAN_BELOW_TERRAIN};
 
     //! Setting type
     enum SettingType {ARMY=Qt::UserRole+1, UNIT, MISSION, OPERATOR, MAP_PATH, MISSION_PATH, LOG_PATH, ALERT_PATH, GALLERY_PATH, LANGUAGE_STRING, HAND};
@@ -120,5 +131,7 @@ Q_DECLARE_METATYPE(SpyCore::DialogType)
 Q_DECLARE_METATYPE(SpyCore::WayPointRole)
 Q_DECLARE_METATYPE(SpyCore::SettingType)
 Q_DECLARE_METATYPE(SpyCore::ExclusionShape)
+Q_DECLARE_METATYPE(SpyCore::ZoneType)
+Q_DECLARE_METATYPE(SpyCore::GeofenceEvent)
 
 #endif // SPYCORE_H
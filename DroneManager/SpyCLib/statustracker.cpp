@@ -0,0 +1,239 @@
+// Qt
+#include <QtMath>
+
+// Application
+#include "statustracker.h"
+#include "simulationscheduler.h"
+#include "fleetstate.h"
+#include "geoutils.h"
+#include "flightpath.h"
+#define HEADING_TOLERANCE 5 // Degrees, heading is not extrapolated
+#define SCHEDULE_TOLERANCE 5 // Meters along trajectory (kinematics ticks vs continuous client clock)
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+StatusTracker::StatusTracker(SimulationScheduler *pScheduler, FleetState *pFleetState, int iPeriodMs, int iHeartbeatMs, QObject *pParent) : QObject(pParent),
+    m_pScheduler(pScheduler), m_pFleetState(pFleetState), m_iPeriodMs(qMax(iPeriodMs, 1))
+{
+    setHeartbeat(iHeartbeatMs);
+    m_iTaskId = m_pScheduler->addTask(m_iPeriodMs, [this]() { scan(); });
+}
+
+//-------------------------------------------------------------------------------------------------
+
+StatusTracker::~StatusTracker()
+{
+    m_pScheduler->removeTask(m_iTaskId);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void StatusTracker::setHeartbeat(int iHeartbeatMs)
+{
+    m_iHeartbeatMs = qMax(iHeartbeatMs, m_iPeriodMs);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int StatusTracker::heartbeat() const
+{
+    return m_iHeartbeatMs;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void StatusTracker::setErrorBound(double dErrorBound)
+{
+    m_dErrorBound = qMax(dErrorBound, 0.);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double StatusTracker::errorBound() const
+{
+    return m_dErrorBound;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const StatusTracker::Counters &StatusTracker::counters() const
+{
+    return m_counters;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void StatusTracker::invalidate()
+{
+    m_bInvalidated = true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void StatusTracker::scan()
+{
+    grow();
+    int iSlotCount = m_pFleetState->slotCount();
+    int iScansPerHeartbeat = qMax(m_iHeartbeatMs/m_iPeriodMs, 1);
+    qint64 iNow = m_pScheduler->simulationTime();
+    const uchar *pActive = m_pFleetState->activeFlags();
+    const double *pLatitudes = m_pFleetState->latitudes();
+    const double *pLongitudes = m_pFleetState->longitudes();
+    const double *pAltitudes = m_pFleetState->altitudes();
+    const double *pHeadings = m_pFleetState->headings();
+    const int *pBatteryLevels = m_pFleetState->batteryLevels();
+    const int *pReturnLevels = m_pFleetState->returnLevels();
+    for (int iSlot=0; iSlot<iSlotCount; iSlot++)
+    {
+        if (!pActive[iSlot])
+        {
+            m_vActive[iSlot] = 0;
+            m_vTrajectory[iSlot].clear();
+            continue;
+        }
+
+        // Changed since last report (a reused slot is a new drone)
+        bool bChanged = m_bInvalidated || !m_vActive[iSlot] ||
+                        (pBatteryLevels[iSlot] != m_vBatteryLevel[iSlot]) || (pReturnLevels[iSlot] != m_vReturnLevel[iSlot]) ||
+                        (m_pFleetState->flightStatus(iSlot) != m_vFlightStatus[iSlot]);
+        if (!bChanged)
+        {
+            if (!m_vTrajectory[iSlot].isNull())
+                bChanged = offSchedule(iSlot, iNow);
+            else
+            if (m_dErrorBound > 0)
+            {
+                double dTurn = qAbs(pHeadings[iSlot]-m_vHeading[iSlot]);
+                bChanged = drifted(iSlot, iNow) || (qMin(dTurn, 360-dTurn) > HEADING_TOLERANCE);
+            }
+            else
+                bChanged = !same(pLatitudes[iSlot], m_vLatitude[iSlot]) || !same(pLongitudes[iSlot], m_vLongitude[iSlot]) ||
+                           !same(pAltitudes[iSlot], m_vAltitude[iSlot]) || !same(pHeadings[iSlot], m_vHeading[iSlot]);
+        }
+        bool bHeartbeat = ++m_vScansSinceReport[iSlot] >= iScansPerHeartbeat;
+        if (!bChanged && !bHeartbeat)
+            continue;
+
+        snapshot(iSlot);
+        m_vReportTime[iSlot] = iNow;
+        if (bChanged)
+            m_counters.iChanges++;
+        else
+            m_counters.iHeartbeats++;
+        emit statusChanged(iSlot);
+    }
+    m_bInvalidated = false;
+    m_counters.iScans++;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void StatusTracker::markReported(int iSlot)
+{
+    grow();
+    if ((iSlot < 0) || (iSlot >= m_vActive.size()))
+        return;
+    snapshot(iSlot);
+    m_vReportTime[iSlot] = m_pScheduler->simulationTime();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void StatusTracker::setTrajectory(int iSlot, const QSharedPointer<const FlightPath> &pFlightPath)
+{
+    grow();
+    if ((iSlot < 0) || (iSlot >= m_vActive.size()))
+        return;
+    m_vTrajectory[iSlot] = (pFlightPath.isNull() || pFlightPath->isEmpty()) ? QSharedPointer<const FlightPath>() : pFlightPath;
+    m_vProgress[iSlot] = m_pFleetState->pathProgress(iSlot);
+    m_vReportTime[iSlot] = m_pScheduler->simulationTime();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool StatusTracker::hasTrajectory(int iSlot) const
+{
+    return (iSlot >= 0) && (iSlot < m_vTrajectory.size()) && !m_vTrajectory[iSlot].isNull();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void StatusTracker::grow()
+{
+    // New slots: never reported, heartbeat phase depends on slot
+    int iSlotCount = m_pFleetState->slotCount();
+    int iScansPerHeartbeat = qMax(m_iHeartbeatMs/m_iPeriodMs, 1);
+    for (int iSlot=m_vActive.size(); iSlot<iSlotCount; iSlot++)
+    {
+        m_vLatitude << 0;
+        m_vLongitude << 0;
+        m_vAltitude << 0;
+        m_vHeading << 0;
+        m_vBatteryLevel << 0;
+        m_vReturnLevel << 0;
+        m_vFlightStatus << SpyCore::IDLE;
+        m_vActive << 0;
+        m_vVelocityNorth << 0;
+        m_vVelocityEast << 0;
+        m_vReportTime << 0;
+        m_vProgress << 0;
+        m_vTrajectory << QSharedPointer<const FlightPath>();
+        m_vScansSinceReport << iSlot%iScansPerHeartbeat;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void StatusTracker::snapshot(int iSlot)
+{
+    m_vLatitude[iSlot] = m_pFleetState->latitude(iSlot);
+    m_vLongitude[iSlot] = m_pFleetState->longitude(iSlot);
+    m_vAltitude[iSlot] = m_pFleetState->altitude(iSlot);
+    m_vHeading[iSlot] = m_pFleetState->heading(iSlot);
+    m_vBatteryLevel[iSlot] = m_pFleetState->batteryLevel(iSlot);
+    m_vReturnLevel[iSlot] = m_pFleetState->returnLevel(iSlot);
+    m_vFlightStatus[iSlot] = m_pFleetState->flightStatus(iSlot);
+    m_pFleetState->velocity(iSlot, m_vVelocityNorth[iSlot], m_vVelocityEast[iSlot]);
+    m_vProgress[iSlot] = m_pFleetState->pathProgress(iSlot);
+    if (m_vFlightStatus[iSlot] != SpyCore::FLYING)
+        m_vTrajectory[iSlot].clear();
+    m_vActive[iSlot] = 1;
+    m_vScansSinceReport[iSlot] = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool StatusTracker::drifted(int iSlot, qint64 iNow) const
+{
+    // Same extrapolation as clients (see GeoUtils::extrapolate)
+    GeoPoint reported(m_vLatitude[iSlot], m_vLongitude[iSlot], m_vAltitude[iSlot]);
+    GeoPoint extrapolated = GeoUtils::extrapolate(reported, m_vVelocityNorth[iSlot], m_vVelocityEast[iSlot], (iNow-m_vReportTime[iSlot])/1000.);
+    GeoPoint position = m_pFleetState->point(iSlot);
+    if (qIsNaN(position.dAltitude) != qIsNaN(extrapolated.dAltitude))
+        return true;
+    if (!qIsNaN(position.dAltitude) && (qAbs(position.dAltitude-extrapolated.dAltitude) > m_dErrorBound))
+        return true;
+    return GeoUtils::distance(extrapolated, position) > m_dErrorBound;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool StatusTracker::offSchedule(int iSlot, qint64 iNow) const
+{
+    // Same schedule as clients: progress flown at leg cruise speeds since last report
+    const FlightPath *pFlightPath = m_vTrajectory[iSlot].data();
+    double dExpected = pFlightPath->distanceAfter(m_vProgress[iSlot], (iNow-m_vReportTime[iSlot])/1000.);
+    double dLag = fmod(m_pFleetState->pathProgress(iSlot)-dExpected, pFlightPath->length());
+    if (dLag < 0)
+        dLag += pFlightPath->length();
+    dLag = qMin(dLag, pFlightPath->length()-dLag);
+    return dLag > qMax(m_dErrorBound, (double)SCHEDULE_TOLERANCE);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool StatusTracker::same(double dValue, double dOther)
+{
+    return (dValue == dOther) || (qIsNaN(dValue) && qIsNaN(dOther));
+}
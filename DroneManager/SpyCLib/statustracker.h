@@ -0,0 +1,150 @@
+#ifndef STATUSTRACKER_H
+#define STATUSTRACKER_H
+
+// Qt
+#include <QObject>
+#include <QVector>
+#include <QSharedPointer>
+
+// Application
+#include "spycore.h"
+#include "spyclib_global.h"
+
+namespace Core {
+class SimulationScheduler;
+class FleetState;
+class FlightPath;
+class SPYCLIBSHARED_EXPORT StatusTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Counters
+    struct Counters
+    {
+        //! Scans run
+        qint64 iScans = 0;
+
+        //! Status reported because it changed
+        qint64 iChanges = 0;
+
+        //! Status reported as heartbeat (unchanged drone)
+        qint64 iHeartbeats = 0;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor
+    StatusTracker(SimulationScheduler *pScheduler, FleetState *pFleetState, int iPeriodMs=250, int iHeartbeatMs=5000, QObject *pParent=nullptr);
+
+    //! Destructor
+    ~StatusTracker();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Set heartbeat period of unchanged drones (ms)
+    void setHeartbeat(int iHeartbeatMs);
+
+    //! Return heartbeat period of unchanged drones (ms)
+    int heartbeat() const;
+
+    //! Set dead reckoning error bound (m): moving drones are reported when the position extrapolated by clients drifts further (0: report every move)
+    void setErrorBound(double dErrorBound);
+
+    //! Return dead reckoning error bound (m)
+    double errorBound() const;
+
+    //! Return counters
+    const Counters &counters() const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Report every drone on next scan (new ground station)
+    void invalidate();
+
+    //! Compare fleet state with the last reported one
+    void scan();
+
+    //! Record that the status of a slot was just sent outside of a scan
+    void markReported(int iSlot);
+
+    //! Record that the trajectory of a flying drone was just pushed: it is reported only when off schedule (until it stops flying)
+    void setTrajectory(int iSlot, const QSharedPointer<const FlightPath> &pFlightPath);
+
+    //! Return true if slot follows a pushed trajectory (its status carries progress along it)
+    bool hasTrajectory(int iSlot) const;
+
+private:
+    //! Make room for new slots
+    void grow();
+
+    //! Record current state of a slot as reported
+    void snapshot(int iSlot);
+
+    //! Return true if a client extrapolating the last report is more than the error bound away from the drone
+    bool drifted(int iSlot, qint64 iNow) const;
+
+    //! Return true if a drone following a trajectory is further from schedule than the error bound
+    bool offSchedule(int iSlot, qint64 iNow) const;
+
+    //! Return true if both values are equal (unknown altitudes are equal)
+    static bool same(double dValue, double dOther);
+
+private:
+    //! Scheduler
+    SimulationScheduler *m_pScheduler = nullptr;
+
+    //! Fleet state
+    FleetState *m_pFleetState = nullptr;
+
+    //! Scan task id
+    int m_iTaskId = -1;
+
+    //! Scan period (ms)
+    int m_iPeriodMs = 250;
+
+    //! Heartbeat period (ms)
+    int m_iHeartbeatMs = 5000;
+
+    //! Dead reckoning error bound (m)
+    double m_dErrorBound = 0;
+
+    //! Report every drone on next scan?
+    bool m_bInvalidated = true;
+
+    //! Last reported state of each slot
+    QVector<double> m_vLatitude;
+    QVector<double> m_vLongitude;
+    QVector<double> m_vAltitude;
+    QVector<double> m_vHeading;
+    QVector<int> m_vBatteryLevel;
+    QVector<int> m_vReturnLevel;
+    QVector<SpyCore::FlightStatus> m_vFlightStatus;
+    QVector<uchar> m_vActive;
+    QVector<double> m_vVelocityNorth;
+    QVector<double> m_vVelocityEast;
+    QVector<qint64> m_vReportTime;
+    QVector<double> m_vProgress;
+
+    //! Pushed trajectory of each slot (null if none)
+    QVector<QSharedPointer<const FlightPath>> m_vTrajectory;
+
+    //! Scans since last report of each slot (heartbeats of a parked fleet are spread over the period)
+    QVector<int> m_vScansSinceReport;
+
+    //! Counters
+    Counters m_counters;
+
+signals:
+    //! Drone status changed, or heartbeat is due
+    void statusChanged(int iSlot);
+};
+}
+
+#endif // STATUSTRACKER_H
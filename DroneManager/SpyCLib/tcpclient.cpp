@@ -1,5 +1,9 @@
 // Application
 #include "tcpclient.h"
+#include "serializehelper.h"
+#include "messageschema.h"
+#include "geoutils.h"
+#include "flightpath.h"
 using namespace Core;
 #define LOCAL_HOST "127.0.0.1"
 #define DATA_SIZE 4
@@ -26,6 +30,8 @@ TCPClient::~TCPClient()
 
 bool TCPClient::connectToHost(const QString &sHost)
 {
+    // Handles are only valid for the server that announced them
+    m_hHandles.clear();
     m_pSocket->connectToHost(sHost, PORT);
     return m_pSocket->waitForConnected();
 }
@@ -40,10 +46,45 @@ void TCPClient::disconnectFromHost()
 //-------------------------------------------------------------------------------------------------
 
 void TCPClient::sendMessage(const QString &sMessage)
+{
+    writeFrame(sMessage.toLatin1());
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPClient::sendMessage(const CXMLNode &messageNode)
+{
+    if (m_hHandles.isEmpty())
+    {
+        writeFrame(messageNode.serialize(m_eFormat));
+        return;
+    }
+    CXMLNode compactNode = messageNode;
+    for (int i=0; i<compactNode.nodes().size(); i++)
+        useHandle(compactNode.nodes()[i]);
+    writeFrame(compactNode.serialize(m_eFormat));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPClient::setFormat(const CXMLNode::Format &eFormat)
+{
+    m_eFormat = eFormat;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const CXMLNode::Format &TCPClient::format() const
+{
+    return m_eFormat;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPClient::writeFrame(const QByteArray &ba)
 {
     if (m_pSocket != nullptr)
     {
-        QByteArray ba = sMessage.toLatin1();
         if (m_pSocket->state() == QAbstractSocket::ConnectedState)
         {
             m_pSocket->write(intToByteArray(ba.size()));
@@ -96,8 +137,11 @@ void TCPClient::onReadyRead()
                 QByteArray baData = m_pBuffer->mid(0, m_iExpectedDataSize);
                 m_pBuffer->remove(0, m_iExpectedDataSize);
                 m_iExpectedDataSize = 0;
+                CXMLNode msgNode = CXMLNode::parse(baData);
+                learnHandles(msgNode);
+                if (m_bTracking)
+                    updateTracks(msgNode);
                 emit dataReady(baData);
-                m_pBuffer->clear();
             }
         }
     }
@@ -116,3 +160,156 @@ bool TCPClient::isConnected() const
 {
     return m_pSocket->state() == QAbstractSocket::ConnectedState;
 }
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPClient::setTracking(bool bTracking)
+{
+    m_bTracking = bTracking;
+    if (!m_bTracking)
+    {
+        m_hTracks.clear();
+        m_iServerTime = -1;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool TCPClient::isTracking() const
+{
+    return m_bTracking;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+qint64 TCPClient::serverTime() const
+{
+    if (m_iServerTime < 0)
+        return -1;
+    return m_iServerTime+m_serverClock.elapsed();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool TCPClient::track(const QString &sDroneUID, Track &track) const
+{
+    QHash<QString, Track>::const_iterator it = m_hTracks.constFind(sDroneUID);
+    if (it == m_hTracks.constEnd())
+        return false;
+    track = it.value();
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool TCPClient::extrapolatedPosition(const QString &sDroneUID, qint64 iTimeMs, QGeoCoordinate &position) const
+{
+    Track lastTrack;
+    if (!track(sDroneUID, lastTrack))
+        return false;
+
+    // Never extrapolate backwards, nor without a timestamp
+    position = lastTrack.position;
+    if ((lastTrack.iTimestamp < 0) || (iTimeMs <= lastTrack.iTimestamp))
+        return true;
+
+    // Along pushed trajectory (same schedule as the server), otherwise straight ahead
+    double dSeconds = (iTimeMs-lastTrack.iTimestamp)/1000.;
+    if (!lastTrack.pTrajectory.isNull())
+        position = lastTrack.pTrajectory->positionAt(lastTrack.pTrajectory->distanceAfter(lastTrack.dProgress, dSeconds));
+    else
+        position = GeoUtils::extrapolate(lastTrack.position, lastTrack.dVelocityNorth, lastTrack.dVelocityEast, dSeconds);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int TCPClient::droneHandle(const QString &sDroneUID) const
+{
+    return m_hHandles.value(sDroneUID, -1);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPClient::updateTracks(const CXMLNode &msgNode)
+{
+    QString sMessageType = SerializeHelper::messageType(msgNode);
+    if (sMessageType == Schema::Batch::name())
+    {
+        foreach (CXMLNode singleMsgNode, SerializeHelper::deserializeBatch(msgNode))
+            updateTracks(singleMsgNode);
+    }
+    else if (sMessageType == Schema::DroneStatus::name())
+    {
+        QString sDroneUID;
+        Track newTrack;
+        SerializeHelper::deserializeDroneMotion(msgNode, sDroneUID, newTrack.position, newTrack.dVelocityNorth, newTrack.dVelocityEast, newTrack.iTimestamp);
+
+        // Trajectory is followed as long as status carries progress along it
+        CXMLNode statusNode = Schema::DroneStatus::find(msgNode);
+        newTrack.dProgress = Schema::DroneStatus::Progress::read(statusNode, -1);
+        if (newTrack.dProgress >= 0)
+            newTrack.pTrajectory = m_hTracks.value(sDroneUID).pTrajectory;
+        m_hTracks[sDroneUID] = newTrack;
+        if (newTrack.iTimestamp > m_iServerTime)
+        {
+            m_iServerTime = newTrack.iTimestamp;
+            m_serverClock.start();
+        }
+    }
+    else if (sMessageType == Schema::Trajectory::name())
+    {
+        QString sDroneUID;
+        QVector<WayPoint> vWayPoints;
+        Track newTrack;
+        SerializeHelper::deserializeTrajectory(msgNode, vWayPoints, sDroneUID, newTrack.iTimestamp, newTrack.dProgress);
+        newTrack.pTrajectory = FlightPath::shared(vWayPoints);
+        if (newTrack.pTrajectory->isEmpty())
+            return;
+        newTrack.position = newTrack.pTrajectory->positionAt(newTrack.dProgress);
+        m_hTracks[sDroneUID] = newTrack;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPClient::learnHandles(const CXMLNode &msgNode)
+{
+    QString sMessageType = SerializeHelper::messageType(msgNode);
+    if (sMessageType == Schema::Batch::name())
+    {
+        foreach (CXMLNode singleMsgNode, SerializeHelper::deserializeBatch(msgNode))
+            learnHandles(singleMsgNode);
+    }
+    else if (sMessageType == Schema::DroneStatus::name())
+    {
+        // Server announcing handles accepts them instead of UIDs (a status without one drops the handle)
+        CXMLNode statusNode = Schema::DroneStatus::find(msgNode);
+        QString sDroneUID = Schema::DroneStatus::DroneUID::read(statusNode);
+        int iHandle = Schema::DroneStatus::Handle::read(statusNode, -1);
+        if (iHandle >= 0)
+            m_hHandles[sDroneUID] = iHandle;
+        else
+            m_hHandles.remove(sDroneUID);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPClient::useHandle(CXMLNode &node) const
+{
+    if (Schema::Batch::is(node) || Schema::BatchEntry::is(node))
+    {
+        for (int i=0; i<node.nodes().size(); i++)
+            useHandle(node.nodes()[i]);
+        return;
+    }
+    QMap<QString, QString>::iterator it = node.attributes().find(Schema::DroneStatus::DroneUID::name());
+    if (it == node.attributes().end())
+        return;
+    QHash<QString, int>::const_iterator itHandle = m_hHandles.constFind(it.value());
+    if (itHandle == m_hHandles.constEnd())
+        return;
+    node.attributes().erase(it);
+    Schema::DroneHandle::write(node, itHandle.value());
+}
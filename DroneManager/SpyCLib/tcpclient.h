@@ -4,16 +4,41 @@
 // Qt
 #include <QtCore>
 #include <QtNetwork>
+#include <QGeoCoordinate>
 
-// Applicaon
+// Application
+#include "cxmlnode.h"
 #include "spyclib_global.h"
 
 namespace Core {
+class FlightPath;
 class SPYCLIBSHARED_EXPORT TCPClient : public QObject
 {
     Q_OBJECT
 
 public:
+    //! Last status of a drone (dead reckoning reference)
+    struct Track
+    {
+        //! Reported position
+        QGeoCoordinate position;
+
+        //! Reported velocity towards north (m/s)
+        double dVelocityNorth = 0;
+
+        //! Reported velocity towards east (m/s)
+        double dVelocityEast = 0;
+
+        //! Simulation time of the report (ms, -1 if the server did not send it)
+        qint64 iTimestamp = -1;
+
+        //! Pushed trajectory (null if none)
+        QSharedPointer<const FlightPath> pTrajectory;
+
+        //! Reported progress along trajectory (m)
+        double dProgress = 0;
+    };
+
     //-------------------------------------------------------------------------------------------------
     // Constructors and destructor
     //-------------------------------------------------------------------------------------------------
@@ -37,10 +62,53 @@ public:
     //! Send message
     void sendMessage(const QString &sMessage);
 
+    //! Send message, encoded in the client format (drones whose handle is known are addressed by handle)
+    void sendMessage(const CXMLNode &messageNode);
+
+    //! Set format (the server answers in the format it receives)
+    void setFormat(const CXMLNode::Format &eFormat);
+
+    //! Return format
+    const CXMLNode::Format &format() const;
+
     //! Is connected?
     bool isConnected() const;
 
+    //-------------------------------------------------------------------------------------------------
+    // Drone tracking (dead reckoning between two drone status)
+    //-------------------------------------------------------------------------------------------------
+
+    //! Enable drone tracking (incoming drone status are decoded before dataReady is emitted)
+    void setTracking(bool bTracking);
+
+    //! Is drone tracking enabled?
+    bool isTracking() const;
+
+    //! Return estimated simulation time of the server (ms, -1 before the first timestamped status)
+    qint64 serverTime() const;
+
+    //! Return last status of a drone (false if unknown)
+    bool track(const QString &sDroneUID, Track &track) const;
+
+    //! Return position of a drone extrapolated at simulation time iTimeMs (false if unknown)
+    bool extrapolatedPosition(const QString &sDroneUID, qint64 iTimeMs, QGeoCoordinate &position) const;
+
+    //! Return handle announced by the server for a drone (-1 if unknown)
+    int droneHandle(const QString &sDroneUID) const;
+
 private:
+    //! Update tracks from an incoming message (drone status, trajectory or batch)
+    void updateTracks(const CXMLNode &msgNode);
+
+    //! Learn drone handles announced in statuses (tracking or not)
+    void learnHandles(const CXMLNode &msgNode);
+
+    //! Replace drone UID by its handle in an outgoing message (batch children included)
+    void useHandle(CXMLNode &node) const;
+
+    //! Write frame
+    void writeFrame(const QByteArray &ba);
+
     //! Int to byte array
     static QByteArray intToByteArray(qint32 iInput);
 
@@ -57,6 +125,24 @@ private:
     //! Buffer
     QByteArray *m_pBuffer = nullptr;
 
+    //! Format
+    CXMLNode::Format m_eFormat = CXMLNode::JSON;
+
+    //! Drone tracking enabled?
+    bool m_bTracking = false;
+
+    //! Last status of each drone
+    QHash<QString, Track> m_hTracks;
+
+    //! Handle of each drone, as announced in its status
+    QHash<QString, int> m_hHandles;
+
+    //! Latest timestamp received (ms)
+    qint64 m_iServerTime = -1;
+
+    //! Time elapsed since latest timestamp
+    QElapsedTimer m_serverClock;
+
 public slots:
     //! Ready read
     void onReadyRead();
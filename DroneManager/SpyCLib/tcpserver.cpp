@@ -1,5 +1,6 @@
 // Application
 #include "tcpserver.h"
+#include "serializehelper.h"
 #define DATA_SIZE 4
 #define PORT 1024
 using namespace Core;
@@ -10,7 +11,7 @@ TCPServer::TCPServer(QObject *parent) : QObject(parent)
 {
     m_pServer = new QTcpServer(this);
     m_pBuffer = new QByteArray;
-    connect(m_pServer, QTcpServer::newConnection, this, &TCPServer::onNewConnection, Qt::DirectConnection);
+    connect(m_pServer, &QTcpServer::newConnection, this, &TCPServer::onNewConnection, Qt::DirectConnection);
     qDebug() << "Listening:" << m_pServer->listen(QHostAddress::Any, PORT);
 }
 
@@ -32,20 +33,94 @@ void TCPServer::sendMessage(const QString &sMessage)
         {
             // Make sure socket is connected
             if (pClient->state() == QAbstractSocket::ConnectedState)
-            {
-                // Get byte array
-                QByteArray ba = sMessage.toLatin1();
+                writeFrame(pClient, sMessage.toLatin1());
+        }
+    }
+}
 
-                // Write size of data
-                pClient->write(intToByteArray(ba.size()));
+//-------------------------------------------------------------------------------------------------
 
-                // Write data
-                pClient->write(ba);
-                pClient->waitForBytesWritten();
-            }
+void TCPServer::sendMessage(const CXMLNode &messageNode)
+{
+    // Encode at most once per format
+    QHash<int, QByteArray> hEncoded;
+    foreach (QTcpSocket *pClient, m_vClients)
+        sendMessage(pClient, messageNode, hEncoded);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPServer::sendMessages(const QVector<CXMLNode> &vMessages)
+{
+    if (vMessages.size() == 1)
+    {
+        sendMessage(vMessages.first());
+        return;
+    }
+
+    // Encode the batch and each message at most once per format
+    CXMLNode batchNode = m_sBatchClients.isEmpty() ? CXMLNode() : SerializeHelper::serializeBatch(vMessages);
+    QHash<int, QByteArray> hBatchEncoded;
+    QVector<QHash<int, QByteArray> > vEncoded(vMessages.size());
+    foreach (QTcpSocket *pClient, m_vClients)
+    {
+        if (m_sBatchClients.contains(pClient))
+            sendMessage(pClient, batchNode, hBatchEncoded);
+        else
+        {
+            for (int i=0; i<vMessages.size(); i++)
+                sendMessage(pClient, vMessages[i], vEncoded[i]);
         }
     }
 }
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPServer::acceptBatches()
+{
+    if (m_pCurrentClient != nullptr)
+        m_sBatchClients.insert(m_pCurrentClient);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPServer::sendMessage(QTcpSocket *pClient, const CXMLNode &messageNode, QHash<int, QByteArray> &hEncoded)
+{
+    // Make sure socket is connected
+    if ((pClient != nullptr) && (pClient->state() == QAbstractSocket::ConnectedState))
+    {
+        CXMLNode::Format eFormat = m_hClientFormat.value(pClient, m_eDefaultFormat);
+        if (!hEncoded.contains(eFormat))
+            hEncoded[eFormat] = messageNode.serialize(eFormat);
+        writeFrame(pClient, hEncoded[eFormat]);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPServer::setDefaultFormat(const CXMLNode::Format &eFormat)
+{
+    m_eDefaultFormat = eFormat;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const CXMLNode::Format &TCPServer::defaultFormat() const
+{
+    return m_eDefaultFormat;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TCPServer::writeFrame(QTcpSocket *pClient, const QByteArray &ba)
+{
+    // Write size of data
+    pClient->write(intToByteArray(ba.size()));
+
+    // Write data
+    pClient->write(ba);
+    pClient->waitForBytesWritten();
+}
 //-------------------------------------------------------------------------------------------------
 
 void TCPServer::onNewConnection()
@@ -72,6 +147,8 @@ void TCPServer::onDisconnected()
     if (pSocket != nullptr)
     {
         m_vClients.removeAll(pSocket);
+        m_hClientFormat.remove(pSocket);
+        m_sBatchClients.remove(pSocket);
         pSocket->deleteLater();
     }
 }
@@ -103,8 +180,12 @@ void TCPServer::onReadyRead()
                     QByteArray baData = m_pBuffer->mid(0, m_iExpectedDataSize);
                     m_pBuffer->remove(0, m_iExpectedDataSize);
                     m_iExpectedDataSize = 0;
+
+                    // Answer this client in the format it talks
+                    m_hClientFormat[pSocket] = CXMLNode::detectFormat(baData);
+                    m_pCurrentClient = pSocket;
                     emit dataReady(baData);
-                    m_pBuffer->clear();
+                    m_pCurrentClient = nullptr;
                 }
             }
         }
@@ -6,6 +6,7 @@
 #include <QtNetwork>
 
 // Application
+#include "cxmlnode.h"
 #include "spyclib_global.h"
 
 namespace Core {
@@ -27,7 +28,28 @@ public:
     //! Send message
     void sendMessage(const QString &sMessage);
 
+    //! Send message, encoded in the format of each client
+    void sendMessage(const CXMLNode &messageNode);
+
+    //! Send messages: in one batch to clients which read batches, one by one to the others
+    void sendMessages(const QVector<CXMLNode> &vMessages);
+
+    //! Mark the client whose message is being handled (from dataReady) as able to read batches
+    void acceptBatches();
+
+    //! Set format used for clients which did not talk yet
+    void setDefaultFormat(const CXMLNode::Format &eFormat);
+
+    //! Return default format
+    const CXMLNode::Format &defaultFormat() const;
+
 private:
+    //! Send message to one client, encoded at most once per format (hEncoded: encodings already done)
+    void sendMessage(QTcpSocket *pClient, const CXMLNode &messageNode, QHash<int, QByteArray> &hEncoded);
+
+    //! Write frame to client
+    static void writeFrame(QTcpSocket *pClient, const QByteArray &ba);
+
     //! Array to int
     static qint32 arrayToInt(QByteArray ba);
 
@@ -47,6 +69,18 @@ private:
     //! Client sockets
     QVector<QTcpSocket *> m_vClients;
 
+    //! Format of each client (the one it last talked in)
+    QHash<QTcpSocket *, CXMLNode::Format> m_hClientFormat;
+
+    //! Default format
+    CXMLNode::Format m_eDefaultFormat = CXMLNode::JSON;
+
+    //! Clients which sent a batch (they read batches too)
+    QSet<QTcpSocket *> m_sBatchClients;
+
+    //! Client whose frame is being handled (dataReady is connected directly)
+    QTcpSocket *m_pCurrentClient = nullptr;
+
 private slots:
     //! Handle incoming client connection
     void onNewConnection();
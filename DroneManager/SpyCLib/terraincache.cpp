@@ -0,0 +1,197 @@
+// Qt
+#include <QtMath>
+#include <QDir>
+
+// Application
+#include "terraincache.h"
+#define VOID_POST -32768 // SRTM no data value
+#define MIN_TILE_SIZE 2
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+TerrainCache::TerrainCache(const QString &sDirectory, int iMaxTiles) : m_sDirectory(sDirectory), m_iMaxTiles(qMax(iMaxTiles, 1))
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+TerrainCache::~TerrainCache()
+{
+    clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const QString &TerrainCache::directory() const
+{
+    return m_sDirectory;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int TerrainCache::tileCount()
+{
+    QReadLocker locker(&m_lock);
+    return m_hTiles.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+TerrainCache::Counters TerrainCache::counters()
+{
+    QReadLocker locker(&m_lock);
+    return m_counters;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double TerrainCache::elevation(double dLatitude, double dLongitude)
+{
+    if (qIsNaN(dLatitude) || qIsNaN(dLongitude) || (dLatitude < -90) || (dLatitude > 90))
+        return qQNaN();
+
+    // Tile containing the point (north pole belongs to the last row of tiles)
+    dLongitude = fmod(dLongitude+180, 360);
+    if (dLongitude < 0)
+        dLongitude += 360;
+    dLongitude -= 180;
+    int iLatitude = qMin(qFloor(dLatitude), 89);
+    int iLongitude = qMin(qFloor(dLongitude), 179);
+    int iKey = tileKey(iLatitude, iLongitude);
+
+    // Resident tile: shared lock only
+    {
+        QReadLocker locker(&m_lock);
+        Tile *pTile = m_hTiles.value(iKey, nullptr);
+        if (pTile != nullptr)
+            return lookup(pTile, dLatitude-iLatitude, dLongitude-iLongitude);
+    }
+
+    // Map it (another thread may have done it meanwhile)
+    QWriteLocker locker(&m_lock);
+    Tile *pTile = m_hTiles.value(iKey, nullptr);
+    if (pTile == nullptr)
+        pTile = loadTile(iLatitude, iLongitude);
+    return lookup(pTile, dLatitude-iLatitude, dLongitude-iLongitude);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double TerrainCache::elevation(const QGeoCoordinate &position)
+{
+    return elevation(position.latitude(), position.longitude());
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void TerrainCache::clear()
+{
+    QWriteLocker locker(&m_lock);
+    foreach (Tile *pTile, m_hTiles)
+    {
+        delete pTile->pFile;
+        delete pTile;
+    }
+    m_hTiles.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int TerrainCache::tileKey(int iLatitude, int iLongitude)
+{
+    return (iLatitude+90)*360+iLongitude+180;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QString TerrainCache::tileName(int iLatitude, int iLongitude)
+{
+    return QString("%1%2%3%4.hgt").arg(iLatitude < 0 ? 'S' : 'N').arg(qAbs(iLatitude), 2, 10, QChar('0'))
+            .arg(iLongitude < 0 ? 'W' : 'E').arg(qAbs(iLongitude), 3, 10, QChar('0'));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+TerrainCache::Tile *TerrainCache::loadTile(int iLatitude, int iLongitude)
+{
+    // Evict least recently used tile
+    while (m_hTiles.size() >= m_iMaxTiles)
+    {
+        QHash<int, Tile *>::iterator itOldest = m_hTiles.begin();
+        for (QHash<int, Tile *>::iterator it=m_hTiles.begin(); it!=m_hTiles.end(); ++it)
+            if (it.value()->iLastUse.load() < itOldest.value()->iLastUse.load())
+                itOldest = it;
+        delete itOldest.value()->pFile;
+        delete itOldest.value();
+        m_hTiles.erase(itOldest);
+        m_counters.iEvictions++;
+    }
+
+    // Map file: square grid of 16 bit posts (1201 or 3601 per row), missing tiles are cached too
+    Tile *pTile = new Tile;
+    pTile->pFile = new QFile(QDir(m_sDirectory).filePath(tileName(iLatitude, iLongitude)));
+    if (pTile->pFile->open(QIODevice::ReadOnly))
+    {
+        qint64 iFileSize = pTile->pFile->size();
+        int iSize = qRound(qSqrt(iFileSize/2.));
+        if ((iSize >= MIN_TILE_SIZE) && ((qint64)iSize*iSize*2 == iFileSize))
+        {
+            pTile->pData = pTile->pFile->map(0, iFileSize);
+            pTile->iSize = iSize;
+        }
+    }
+    if (pTile->pData == nullptr)
+    {
+        delete pTile->pFile;
+        pTile->pFile = nullptr;
+    }
+    m_hTiles.insert(tileKey(iLatitude, iLongitude), pTile);
+    m_iGeneration++;
+    m_counters.iLoads++;
+    return pTile;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double TerrainCache::lookup(Tile *pTile, double dNorth, double dEast) const
+{
+    // Written only when stale, so that threads reading the same tile do not fight over its cache line
+    if (pTile->iLastUse.load() != m_iGeneration)
+        pTile->iLastUse.store(m_iGeneration);
+    if (pTile->pData == nullptr)
+        return qQNaN();
+
+    // Rows run from north to south
+    int iLast = pTile->iSize-1;
+    double dRow = (1-dNorth)*iLast;
+    double dColumn = dEast*iLast;
+    int iRow = qBound(0, (int)dRow, iLast-1);
+    int iColumn = qBound(0, (int)dColumn, iLast-1);
+    double dV = dRow-iRow;
+    double dU = dColumn-iColumn;
+
+    // Bilinear, void posts left out
+    double vWeights[] = {(1-dU)*(1-dV), dU*(1-dV), (1-dU)*dV, dU*dV};
+    double vPosts[] = {post(pTile, iRow, iColumn), post(pTile, iRow, iColumn+1), post(pTile, iRow+1, iColumn), post(pTile, iRow+1, iColumn+1)};
+    double dSum = 0;
+    double dWeight = 0;
+    for (int i=0; i<4; i++)
+    {
+        if (qIsNaN(vPosts[i]))
+            continue;
+        dSum += vWeights[i]*vPosts[i];
+        dWeight += vWeights[i];
+    }
+    return dWeight > 0 ? dSum/dWeight : qQNaN();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double TerrainCache::post(const Tile *pTile, int iRow, int iColumn)
+{
+    const uchar *pPost = pTile->pData+2*((qint64)iRow*pTile->iSize+iColumn);
+    qint16 iElevation = (qint16)((pPost[0] << 8) | pPost[1]);
+    return iElevation == VOID_POST ? qQNaN() : iElevation;
+}
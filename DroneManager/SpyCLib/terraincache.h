@@ -0,0 +1,118 @@
+#ifndef TERRAINCACHE_H
+#define TERRAINCACHE_H
+
+// Qt
+#include <QString>
+#include <QHash>
+#include <QFile>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
+#include <QGeoCoordinate>
+
+// Application
+#include "spyclib_global.h"
+
+namespace Core {
+class SPYCLIBSHARED_EXPORT TerrainCache
+{
+public:
+    //! Counters
+    struct Counters
+    {
+        //! Tiles mapped (including missing ones)
+        qint64 iLoads = 0;
+
+        //! Tiles evicted
+        qint64 iEvictions = 0;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor (sDirectory: SRTM .hgt tiles named like N48E002.hgt, iMaxTiles: tiles kept mapped)
+    TerrainCache(const QString &sDirectory, int iMaxTiles=16);
+
+    //! Destructor
+    ~TerrainCache();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Return tile directory
+    const QString &directory() const;
+
+    //! Return mapped tile count
+    int tileCount();
+
+    //! Return counters
+    Counters counters();
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Return ground elevation (m above sea level, bilinear between posts), NaN outside known tiles (thread safe)
+    double elevation(double dLatitude, double dLongitude);
+
+    //! Return ground elevation below position
+    double elevation(const QGeoCoordinate &position);
+
+    //! Unmap every tile
+    void clear();
+
+private:
+    //! Mapped tile (one degree square, posts from north west corner, row by row)
+    struct Tile
+    {
+        //! File (unmapped when deleted)
+        QFile *pFile = nullptr;
+
+        //! Big endian 16 bit posts (null: missing tile)
+        const uchar *pData = nullptr;
+
+        //! Posts per row and per column
+        int iSize = 0;
+
+        //! Load generation of last use (LRU, updated under read lock)
+        QAtomicInteger<quint64> iLastUse;
+    };
+
+    //! Return tile key of the square containing a point
+    static int tileKey(int iLatitude, int iLongitude);
+
+    //! Return file name of a tile (south west corner)
+    static QString tileName(int iLatitude, int iLongitude);
+
+    //! Map tile, evicting the least recently used one if full (write lock held)
+    Tile *loadTile(int iLatitude, int iLongitude);
+
+    //! Return bilinear elevation at (dNorth, dEast) tile fractions from its south west corner, mark tile as used
+    double lookup(Tile *pTile, double dNorth, double dEast) const;
+
+    //! Return post elevation (NaN if void)
+    static double post(const Tile *pTile, int iRow, int iColumn);
+
+private:
+    //! Tile directory
+    QString m_sDirectory;
+
+    //! Tiles kept mapped
+    int m_iMaxTiles = 16;
+
+    //! Mapped tiles by key
+    QHash<int, Tile *> m_hTiles;
+
+    //! Lock (lookups share it, loads and evictions own it)
+    QReadWriteLock m_lock;
+
+    //! Load generation (LRU: bumped on each load only, so that lookups of resident tiles share nothing but the read lock)
+    quint64 m_iGeneration = 0;
+
+    //! Counters (write lock held)
+    Counters m_counters;
+};
+}
+
+#endif // TERRAINCACHE_H
@@ -1,17 +1,58 @@
+// Qt
+#include <QHash>
+#include <QReadWriteLock>
+
 // Application
 #include "waypoint.h"
 using namespace Core;
 
+//! Register metatype once on library load, not by each waypoint a container constructs
+static void registerWayPointType()
+{
+    qRegisterMetaType<WayPoint>("WayPoint");
+}
+Q_CONSTRUCTOR_FUNCTION(registerWayPointType)
+
+//-------------------------------------------------------------------------------------------------
+
+//! Metadata names interned for every waypoint
+struct MetaDataKeys
+{
+    //! Lock (lookups share it, new names own it)
+    QReadWriteLock lock;
+
+    //! Keys by name
+    QHash<QString, int> hKeys;
+
+    //! Names by key
+    QVector<QString> vNames;
+};
+
+//-------------------------------------------------------------------------------------------------
+
+static MetaDataKeys &metaDataKeys()
+{
+    static MetaDataKeys keys;
+    return keys;
+}
+
 //-------------------------------------------------------------------------------------------------
 
 WayPoint::WayPoint()
 {
-    qRegisterMetaType<WayPoint>("WayPoint");
+
 }
 
 //-------------------------------------------------------------------------------------------------
 
-WayPoint::WayPoint(const QGeoCoordinate &geoCoord, const SpyCore::PointType &eType) : m_geoCoord(geoCoord), m_eType(eType)
+WayPoint::WayPoint(const QGeoCoordinate &geoCoord, const SpyCore::PointType &eType) : m_point(geoCoord), m_eType(eType)
+{
+
+}
+
+//-------------------------------------------------------------------------------------------------
+
+WayPoint::WayPoint(const GeoPoint &point, const SpyCore::PointType &eType) : m_point(point), m_eType(eType)
 {
 
 }
@@ -25,16 +66,30 @@ WayPoint::~WayPoint()
 
 //-------------------------------------------------------------------------------------------------
 
-const QGeoCoordinate &WayPoint::geoCoord() const
+QGeoCoordinate WayPoint::geoCoord() const
 {
-    return m_geoCoord;
+    return m_point.toCoordinate();
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void WayPoint::setGeoCoord(const QGeoCoordinate &geoCoord)
 {
-    m_geoCoord = geoCoord;
+    m_point = GeoPoint(geoCoord);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const GeoPoint &WayPoint::point() const
+{
+    return m_point;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void WayPoint::setPoint(const GeoPoint &point)
+{
+    m_point = point;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -67,16 +122,106 @@ void WayPoint::setClockWise(bool bClockWise)
 
 //-------------------------------------------------------------------------------------------------
 
-const QHash<QString, double> &WayPoint::metaData() const
+double WayPoint::metaData(int iKey, double dDefault) const
 {
-    return m_hMetaData;
+    const MetaData *pMetaData = findMetaData(iKey);
+    return pMetaData != nullptr ? pMetaData->dValue : dDefault;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void WayPoint::setMetaData(int iKey, double dValue)
+{
+    for (int i=0; i<m_iMetaDataCount; i++)
+        if (m_vMetaData[i].iKey == iKey)
+        {
+            m_vMetaData[i].dValue = dValue;
+            return;
+        }
+    for (int i=0; i<m_vMoreMetaData.size(); i++)
+        if (m_vMoreMetaData[i].iKey == iKey)
+        {
+            m_vMoreMetaData[i].dValue = dValue;
+            return;
+        }
+    MetaData metaData = {iKey, dValue};
+    if (m_iMetaDataCount < WAYPOINT_INLINE_METADATA)
+        m_vMetaData[m_iMetaDataCount++] = metaData;
+    else
+        m_vMoreMetaData << metaData;
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void WayPoint::setMetaData(const QString &sKey, double dValue)
 {
-    m_hMetaData[sKey] = dValue;
+    setMetaData(metaDataKey(sKey), dValue);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int WayPoint::metaDataCount() const
+{
+    return m_iMetaDataCount+m_vMoreMetaData.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int WayPoint::metaDataKeyAt(int iIndex) const
+{
+    return iIndex < m_iMetaDataCount ? m_vMetaData[iIndex].iKey : m_vMoreMetaData[iIndex-m_iMetaDataCount].iKey;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double WayPoint::metaDataValueAt(int iIndex) const
+{
+    return iIndex < m_iMetaDataCount ? m_vMetaData[iIndex].dValue : m_vMoreMetaData[iIndex-m_iMetaDataCount].dValue;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int WayPoint::metaDataKey(const QString &sName)
+{
+    MetaDataKeys &keys = metaDataKeys();
+    {
+        QReadLocker locker(&keys.lock);
+        QHash<QString, int>::const_iterator it = keys.hKeys.constFind(sName);
+        if (it != keys.hKeys.constEnd())
+            return it.value();
+    }
+
+    // New name (another thread may have interned it meanwhile)
+    QWriteLocker locker(&keys.lock);
+    QHash<QString, int>::const_iterator it = keys.hKeys.constFind(sName);
+    if (it != keys.hKeys.constEnd())
+        return it.value();
+    int iKey = keys.vNames.size();
+    keys.hKeys.insert(sName, iKey);
+    keys.vNames << sName;
+    return iKey;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+QString WayPoint::metaDataName(int iKey)
+{
+    MetaDataKeys &keys = metaDataKeys();
+    QReadLocker locker(&keys.lock);
+    return keys.vNames.value(iKey);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+const WayPoint::MetaData *WayPoint::findMetaData(int iKey) const
+{
+    for (int i=0; i<m_iMetaDataCount; i++)
+        if (m_vMetaData[i].iKey == iKey)
+            return &m_vMetaData[i];
+    for (int i=0; i<m_vMoreMetaData.size(); i++)
+        if (m_vMoreMetaData[i].iKey == iKey)
+            return &m_vMoreMetaData[i];
+    return nullptr;
 }
 
 //-------------------------------------------------------------------------------------------------
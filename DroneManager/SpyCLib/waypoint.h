@@ -9,7 +9,9 @@
 
 // Application
 #include <spycore.h>
+#include "geopoint.h"
 #include "spyclib_global.h"
+#define WAYPOINT_INLINE_METADATA 4 // Pattern parameters fit inline
 
 namespace Core {
 class SPYCLIBSHARED_EXPORT WayPoint
@@ -25,19 +27,28 @@ public:
     //! Constructor
     WayPoint(const QGeoCoordinate &geoCoord, const SpyCore::PointType &eType=SpyCore::POINT);
 
+    //! Constructor
+    WayPoint(const GeoPoint &point, const SpyCore::PointType &eType=SpyCore::POINT);
+
     //! Destructor
-    virtual ~WayPoint();
+    ~WayPoint();
 
     //-------------------------------------------------------------------------------------------------
     // Getters & setters
     //-------------------------------------------------------------------------------------------------
 
     //! Return geoCoord
-    const QGeoCoordinate &geoCoord() const;
+    QGeoCoordinate geoCoord() const;
 
     //! Set geoCoord
     void setGeoCoord(const QGeoCoordinate &geoCoord);
 
+    //! Return point
+    const GeoPoint &point() const;
+
+    //! Set point
+    void setPoint(const GeoPoint &point);
+
     //! Return type
     const SpyCore::PointType &type() const;
 
@@ -56,15 +67,51 @@ public:
     //! Set clockwise
     void setClockWise(bool bClockWise);
 
-    //! Return metadata
-    const QHash<QString, double> &metaData() const;
+    //! Return metadata value (dDefault if not set)
+    double metaData(int iKey, double dDefault=qQNaN()) const;
+
+    //! Set metadata
+    void setMetaData(int iKey, double dValue);
 
     //! Set metadata
     void setMetaData(const QString &sKey, double dValue);
 
+    //! Return metadata count
+    int metaDataCount() const;
+
+    //! Return key of the iIndex-th metadata
+    int metaDataKeyAt(int iIndex) const;
+
+    //! Return value of the iIndex-th metadata
+    double metaDataValueAt(int iIndex) const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Metadata keys
+    //-------------------------------------------------------------------------------------------------
+
+    //! Return interned key of a metadata name, shared by every waypoint (thread safe)
+    static int metaDataKey(const QString &sName);
+
+    //! Return name of an interned key
+    static QString metaDataName(int iKey);
+
 private:
-    //! Geo coordinate
-    QGeoCoordinate m_geoCoord;
+    //! Metadata entry
+    struct MetaData
+    {
+        //! Interned key
+        int iKey;
+
+        //! Value
+        double dValue;
+    };
+
+    //! Return metadata entry by key (null if not set)
+    const MetaData *findMetaData(int iKey) const;
+
+private:
+    //! Position
+    GeoPoint m_point;
 
     //! Point type
     SpyCore::PointType m_eType = SpyCore::POINT;
@@ -72,13 +119,20 @@ private:
     //! Clock wise?
     bool m_bClockWise = true;
 
-    //! Point metadata
-    QHash<QString, double> m_hMetaData;
-
     //! Speed
     SpyCore::PointSpeed m_eSpeed = SpyCore::ECO;
+
+    //! Inline metadata count
+    int m_iMetaDataCount = 0;
+
+    //! Inline metadata (no allocation when a waypoint is loaded or copied)
+    MetaData m_vMetaData[WAYPOINT_INLINE_METADATA];
+
+    //! Metadata beyond inline ones
+    QVector<MetaData> m_vMoreMetaData;
 };
 }
+Q_DECLARE_TYPEINFO(Core::WayPoint, Q_MOVABLE_TYPE);
 
 typedef QVector<Core::WayPoint> WayPointList;
 
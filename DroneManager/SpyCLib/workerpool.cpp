@@ -0,0 +1,157 @@
+// Application
+#include "workerpool.h"
+using namespace Core;
+
+//-------------------------------------------------------------------------------------------------
+
+WorkerPool::WorkerPool(int iThreadCount)
+{
+    m_vQueues << new Queue;
+    for (int i=1; i<=iThreadCount; i++)
+    {
+        m_vQueues << new Queue;
+        Worker *pWorker = new Worker(this, i);
+        m_vThreads << pWorker;
+        pWorker->start();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+WorkerPool::~WorkerPool()
+{
+    m_mutex.lock();
+    m_bStop = true;
+    m_startCondition.wakeAll();
+    m_mutex.unlock();
+
+    foreach (Worker *pWorker, m_vThreads)
+        pWorker->wait();
+    qDeleteAll(m_vThreads);
+    qDeleteAll(m_vQueues);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int WorkerPool::threadCount() const
+{
+    return m_vThreads.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int WorkerPool::stealCount() const
+{
+    return m_iStealCount.load();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void WorkerPool::run(int iCount, int iChunkSize, const Job &job)
+{
+    if (iCount <= 0)
+        return;
+    iChunkSize = qMax(1, iChunkSize);
+    int iChunkCount = (iCount+iChunkSize-1)/iChunkSize;
+    if (m_vThreads.isEmpty() || (iChunkCount == 1))
+    {
+        job(0, iCount);
+        return;
+    }
+
+    // Each worker owns a contiguous block of chunks
+    m_mutex.lock();
+    m_job = job;
+    m_iCount = iCount;
+    m_iChunkSize = iChunkSize;
+    int iWorkerCount = m_vQueues.size();
+    for (int i=0; i<iWorkerCount; i++)
+    {
+        QMutexLocker locker(&m_vQueues[i]->mutex);
+        m_vQueues[i]->iHead = i*iChunkCount/iWorkerCount;
+        m_vQueues[i]->iTail = (i+1)*iChunkCount/iWorkerCount;
+    }
+    m_iGeneration++;
+    m_iBusyCount = m_vThreads.size();
+    m_startCondition.wakeAll();
+    m_mutex.unlock();
+
+    work(0);
+
+    // Barrier: every worker is done with this job
+    QMutexLocker locker(&m_mutex);
+    while (m_iBusyCount > 0)
+        m_doneCondition.wait(&m_mutex);
+    m_job = Job();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void WorkerPool::threadLoop(int iWorker)
+{
+    int iGeneration = 0;
+    forever
+    {
+        m_mutex.lock();
+        while ((m_iGeneration == iGeneration) && !m_bStop)
+            m_startCondition.wait(&m_mutex);
+        if (m_bStop)
+        {
+            m_mutex.unlock();
+            return;
+        }
+        iGeneration = m_iGeneration;
+        m_mutex.unlock();
+
+        work(iWorker);
+
+        m_mutex.lock();
+        m_iBusyCount--;
+        if (m_iBusyCount == 0)
+            m_doneCondition.wakeAll();
+        m_mutex.unlock();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void WorkerPool::work(int iWorker)
+{
+    int iChunk = 0;
+    while (takeChunk(iWorker, iChunk))
+    {
+        int iBegin = iChunk*m_iChunkSize;
+        m_job(iBegin, qMin(iBegin+m_iChunkSize, m_iCount));
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool WorkerPool::takeChunk(int iWorker, int &iChunk)
+{
+    // Own chunks first
+    Queue *pQueue = m_vQueues[iWorker];
+    {
+        QMutexLocker locker(&pQueue->mutex);
+        if (pQueue->iHead < pQueue->iTail)
+        {
+            iChunk = pQueue->iHead++;
+            return true;
+        }
+    }
+
+    // Then steal from the other workers
+    int iWorkerCount = m_vQueues.size();
+    for (int i=1; i<iWorkerCount; i++)
+    {
+        Queue *pVictim = m_vQueues[(iWorker+i)%iWorkerCount];
+        QMutexLocker locker(&pVictim->mutex);
+        if (pVictim->iHead < pVictim->iTail)
+        {
+            iChunk = --pVictim->iTail;
+            m_iStealCount.ref();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,132 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+// Qt
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QThread>
+
+// Application
+#include "spyclib_global.h"
+
+// Std
+#include <functional>
+
+namespace Core {
+class SPYCLIBSHARED_EXPORT WorkerPool
+{
+public:
+    //! Job: process items [iBegin, iEnd[
+    typedef std::function<void(int iBegin, int iEnd)> Job;
+
+    //-------------------------------------------------------------------------------------------------
+    // Constructors and destructor
+    //-------------------------------------------------------------------------------------------------
+
+    //! Constructor (iThreadCount worker threads besides the calling thread)
+    explicit WorkerPool(int iThreadCount=QThread::idealThreadCount()-1);
+
+    //! Destructor
+    ~WorkerPool();
+
+    //-------------------------------------------------------------------------------------------------
+    // Getters & setters
+    //-------------------------------------------------------------------------------------------------
+
+    //! Return number of worker threads
+    int threadCount() const;
+
+    //! Return number of chunks run by another worker than their owner
+    int stealCount() const;
+
+    //-------------------------------------------------------------------------------------------------
+    // Control methods
+    //-------------------------------------------------------------------------------------------------
+
+    //! Run job over [0, iCount[ in chunks of iChunkSize items, return when every chunk is done
+    void run(int iCount, int iChunkSize, const Job &job);
+
+private:
+    //! Worker thread
+    class Worker : public QThread
+    {
+    public:
+        //! Constructor
+        Worker(WorkerPool *pPool, int iIndex) : m_pPool(pPool), m_iIndex(iIndex) {}
+
+    protected:
+        //! Run
+        virtual void run() { m_pPool->threadLoop(m_iIndex); }
+
+    private:
+        //! Pool
+        WorkerPool *m_pPool = nullptr;
+
+        //! Worker index (0 is the calling thread)
+        int m_iIndex = 0;
+    };
+
+    //! Chunk queue of one worker: owner takes from the head, thieves from the tail
+    struct Queue
+    {
+        //! Mutex
+        QMutex mutex;
+
+        //! Next chunk
+        int iHead = 0;
+
+        //! End of chunks
+        int iTail = 0;
+    };
+
+    //! Worker thread loop
+    void threadLoop(int iWorker);
+
+    //! Run chunks until none is left
+    void work(int iWorker);
+
+    //! Take own chunk or steal one
+    bool takeChunk(int iWorker, int &iChunk);
+
+private:
+    //! Worker threads
+    QVector<Worker *> m_vThreads;
+
+    //! Chunk queues (one per worker, calling thread included)
+    QVector<Queue *> m_vQueues;
+
+    //! Current job
+    Job m_job;
+
+    //! Current item count
+    int m_iCount = 0;
+
+    //! Current chunk size
+    int m_iChunkSize = 1;
+
+    //! Mutex (job, generation, busy count)
+    QMutex m_mutex;
+
+    //! Job started
+    QWaitCondition m_startCondition;
+
+    //! All workers done
+    QWaitCondition m_doneCondition;
+
+    //! Job generation
+    int m_iGeneration = 0;
+
+    //! Worker threads still on current job
+    int m_iBusyCount = 0;
+
+    //! Stop requested
+    bool m_bStop = false;
+
+    //! Steal count
+    QAtomicInt m_iStealCount;
+};
+}
+
+#endif // WORKERPOOL_H